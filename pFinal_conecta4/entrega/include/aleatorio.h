@@ -0,0 +1,114 @@
+/**
+ * @file aleatorio.h
+ * @brief Fichero de cabecera para el TDA Aleatorio
+ *
+ */
+
+#ifndef __ALEATORIO_H__
+#define __ALEATORIO_H__
+
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * @brief T.D.A. Aleatorio
+ *
+ * Una instancia @e a del T.D.A. Aleatorio es un generador de números
+ * pseudoaleatorios xoshiro256** de 64 bits. Es mucho más rápido que rand()
+ * y, a diferencia de éste, no tiene estado global: cada motor (o cada hilo
+ * de un motor, como en las simulaciones de MonteCarlo) tiene el suyo, así
+ * que no hace falta sincronizar nada y la secuencia de cada uno sólo depende
+ * de su semilla.
+ *
+ * La semilla se amplía a los 256 bits de estado con splitmix64. Con el
+ * mismo par (semilla, flujo) se obtiene siempre la misma secuencia, lo que
+ * permite repetir una partida; con flujos distintos se obtienen secuencias
+ * independientes a partir de una única semilla (p.ej. una por hilo). La
+ * semilla 0 significa "al azar": se toma una del sistema.
+ *
+ * Los enteros acotados (entero, entre) se eligen sin sesgo, por el método
+ * de multiplicación de Lemire con rechazo, en lugar de con el módulo.
+ */
+class Aleatorio
+{
+  private:
+    uint64_t estado[4];   ///< Estado del generador
+
+    /**
+     * @brief Rota x k bits hacia la izquierda.
+     */
+    static uint64_t rotar(uint64_t x, int k)
+    {
+      return (x << k) | (x >> (64 - k));
+    }
+
+  public:
+    /**
+     * @brief Constructor.
+     * @param semilla Semilla del generador (0 para una al azar)
+     * @param flujo Número de secuencia, para sacar varios generadores
+     * independientes de la misma semilla
+     */
+    Aleatorio(uint64_t semilla = 0, uint64_t flujo = 0);
+
+    /**
+     * @brief Devuelve una semilla al azar, distinta en cada llamada.
+     */
+    static uint64_t semillaAleatoria();
+
+    /**
+     * @brief Devuelve los siguientes 64 bits aleatorios.
+     */
+    uint64_t siguiente()
+    {
+      uint64_t resultado = rotar(estado[1] * 5, 7) * 9;
+      uint64_t t = estado[1] << 17;
+
+      estado[2] ^= estado[0];
+      estado[3] ^= estado[1];
+      estado[1] ^= estado[2];
+      estado[0] ^= estado[3];
+      estado[2] ^= t;
+      estado[3] = rotar(estado[3], 45);
+
+      return resultado;
+    }
+
+    /**
+     * @brief Devuelve un entero al azar en [0, n), todos igual de probables.
+     * @pre n > 0
+     */
+    uint64_t entero(uint64_t n)
+    {
+      unsigned __int128 m = (unsigned __int128) siguiente() * n;
+      uint64_t bajo = (uint64_t) m;
+
+      // Se descartan los valores que harían unos restos más probables
+      if (bajo < n)
+      {
+        uint64_t umbral = -n % n;
+        while (bajo < umbral)
+        {
+          m = (unsigned __int128) siguiente() * n;
+          bajo = (uint64_t) m;
+        }
+      }
+
+      return (uint64_t) (m >> 64);
+    }
+
+    /**
+     * @brief Devuelve un entero al azar en [min, max], todos igual de
+     * probables.
+     * @pre min <= max
+     */
+    int entre(int min, int max)
+    {
+      return min + (int) entero((uint64_t) ((int64_t) max - min) + 1);
+    }
+};
+
+#endif
+
+/* Fin fichero: aleatorio.h */
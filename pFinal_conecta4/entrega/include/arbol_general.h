@@ -10,8 +10,13 @@
 #include <iostream>
 #include <cassert>
 #include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <new>
 #include <queue>
 #include <string>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
@@ -39,6 +44,18 @@ using namespace std;
    El espacio requerido para el almacenamiento es O(n), donde n es el número de
    nodos del árbol.
 
+   Los nodos no se reservan uno a uno con new, sino que se sacan de bloques
+   contiguos que comparten todos los árboles del mismo tipo en cada hilo.
+   Destruir un árbol (o podarlo con asignar_subarbol) no recorre sus nodos: el
+   subárbol entero se aparta en O(1) y sus nodos se recogen de una vez cuando
+   se acaban los libres. Cada nodo sabe de qué reserva salió: los que se
+   recogen en otro hilo se devuelven a la cola de su reserva, que los vuelve a
+   usar la próxima vez que se le acaben los libres. La reserva de un hilo que
+   termina se mantiene hasta que se recoge su último nodo, así que un árbol
+   puede crearse en un hilo y destruirse en otro, aunque el primero haya
+   terminado. Un árbol puede leerse desde varios hilos a la vez, pero sólo
+   debe modificarse desde uno a la vez.
+
    @author Luis Baca Ruiz.
    @date Diciembre de 2011
 */
@@ -76,6 +93,8 @@ class ArbolGeneral{
   */
 
   private:
+    struct reserva;
+
     /**
       *@brief nodo
       *
@@ -114,6 +133,12 @@ class ArbolGeneral{
         * es la raíz.
         */
        nodo *padre;
+
+      /**
+        * @brief Reserva de la que salió el nodo
+        */
+       reserva *duenio;
+
        /**
         * @brief Constructor.
         * Crea un nodo vacio.
@@ -125,6 +150,11 @@ class ArbolGeneral{
         * Crea un nodo a con un elemento.
         */
        nodo(const Tbase & elemento) : etiqueta(elemento) {padre = drcha = izqda = 0;}
+       /**
+        * @brief Constructor moviendo el elemento.
+        * @param e elemento que se mueve al nodo.
+        */
+       nodo(Tbase && elemento) : etiqueta(std::move(elemento)) {padre = drcha = izqda = 0;}
 
       /**
        * @brief Destructor.
@@ -144,11 +174,169 @@ class ArbolGeneral{
       */
     struct nodo *laraiz;
 
+    /**
+      * @brief Reserva de nodos
+      *
+      * Bloques de BLOQUE nodos de los que se sacan los nodos nuevos, y pila de
+      * subárboles destruidos cuyos nodos se pueden reutilizar. Cada hilo tiene
+      * su propia reserva. Los nodos de la reserva que se recogen en otro hilo
+      * vuelven por la cola \e devueltos, protegida por \e cerrojo.
+      */
+    struct reserva {
+      /**
+        * @brief Número de nodos de cada bloque (múltiplo de 64).
+        */
+      static const size_t BLOQUE = 1024;
+
+      /**
+        * @brief Bloque contiguo de nodos, con un bit por nodo que indica si
+        * está libre.
+        */
+      struct bloque {
+        nodo * memoria;
+        uint64_t libres[BLOQUE / 64];
+      };
+
+      /**
+        * @brief Bloques reservados, ordenados por dirección de memoria.
+        */
+      std::vector<bloque> bloques;
+
+      /**
+        * @brief Bloque y palabra de \e libres desde los que se busca el
+        * siguiente nodo libre.
+        */
+      size_t bloque_actual, palabra_actual;
+
+      /**
+        * @brief Raíces de subárboles destruidos en este hilo.
+        *
+        * Sus nodos siguen construidos y ocupados: se recogen todos juntos
+        * cuando no quedan nodos libres.
+        */
+      std::vector<nodo *> pendientes;
+
+      /**
+        * @brief Nodos de esta reserva recogidos en otros hilos, ya sin
+        * etiqueta, que aún no se han marcado como libres.
+        */
+      std::vector<nodo *> devueltos;
+
+      /**
+        * @brief Protege \e devueltos, \e viva y, si el hilo ha terminado, el
+        * resto de la reserva.
+        */
+      std::mutex cerrojo;
+
+      /**
+        * @brief Nodos sacados que aún no se han marcado como libres.
+        */
+      size_t ocupados;
+
+      /**
+        * @brief El hilo de la reserva no ha terminado.
+        */
+      bool viva;
+
+      reserva() : bloque_actual(0), palabra_actual(0), ocupados(0), viva(true) {}
+
+      /**
+        * @brief Destructor. Devuelve los bloques al sistema.
+        */
+      ~reserva();
+
+      /**
+        * @brief Memoria para un nodo nuevo
+        * @return Puntero a memoria sin construir para un nodo.
+        *
+        * Los nodos libres se entregan en orden de dirección, de forma que los
+        * nodos creados seguidos quedan contiguos en memoria. La operación se
+        * realiza en tiempo O(1) amortizado.
+        */
+      nodo * sacar();
+
+      /**
+        * @brief Destruye las etiquetas de los subárboles pendientes y marca
+        * sus nodos como libres. Los nodos de otras reservas se devuelven a
+        * la suya.
+        */
+      void recoger();
+
+      /**
+        * @brief Marca como libre un nodo de esta reserva, ya sin etiqueta.
+        */
+      void liberar(nodo * n);
+
+      /**
+        * @brief Marca como libres los nodos de la cola \e devueltos.
+        */
+      void recoger_devueltos();
+
+      /**
+        * @brief Devuelve a su reserva nodos ya sin etiqueta de otra reserva.
+        * @param r Reserva de los nodos
+        * @param v Nodos que se devuelven; se vacía.
+        *
+        * Si el hilo de \e r ha terminado, los nodos se marcan libres aquí y,
+        * si era el último, se destruye la reserva.
+        */
+      static void devolver(reserva * r, std::vector<nodo *> & v);
+
+      /**
+        * @brief Se llama al terminar el hilo de la reserva. Recoge lo que
+        * pueda y destruye la reserva si no le quedan nodos ocupados; si no,
+        * se destruirá cuando se devuelva el último.
+        */
+      void abandonar();
+    };
+
+    /**
+      * @brief Reserva del hilo actual, que se abandona al terminar el hilo.
+      */
+    struct reserva_hilo {
+      reserva * r;
+      reserva_hilo() : r(new reserva) {}
+      ~reserva_hilo() { r->abandonar(); }
+    };
+
+    /**
+      * @brief Reserva de nodos del hilo actual.
+      */
+    static reserva & nodos();
+
+    /**
+      * @brief Crea un nodo vacío en la reserva.
+      */
+    static nodo * nuevo_nodo();
+
+    /**
+      * @brief Crea un nodo con etiqueta \e e en la reserva.
+      */
+    static nodo * nuevo_nodo(const Tbase & e);
+
+    /**
+      * @brief Crea un nodo en la reserva moviendo a él la etiqueta \e e.
+      */
+    static nodo * nuevo_nodo(Tbase && e);
+
+    /**
+      * @brief Desengancha un nodo de su padre (o de la raíz)
+      * @param n Nodo a desenganchar
+      *
+      * Quita \e n de la lista de hijos de su padre, o deja el árbol vacío si
+      * \e n es la raíz. El subárbol que cuelga de \e n no cambia. La operación
+      * se realiza en tiempo O(k), donde \e k es el número de hermanos a la
+      * izquierda de \e n.
+      */
+    void desenganchar(nodo * n);
+
     /**
       * @brief Destruye el subárbol
       * @param n Nodo a destruir, junto con sus descendientes
       *
-      * Libera los recursos que ocupan \e n y sus descendientes.
+      * Devuelve a la reserva \e n y sus descendientes (no sus hermanos). Los
+      * nodos no se recorren: se reutilizan más adelante. La operación se
+      * realiza en tiempo O(1).
       */
     void destruir(nodo *& n);
 
@@ -256,6 +444,14 @@ class ArbolGeneral{
       */
     ArbolGeneral(const Tbase& e);
 
+    /**
+      * @brief Constructor de raíz moviendo la etiqueta
+      * @param e Etiqueta de la raíz, que se mueve al árbol
+      *
+      * Como el constructor de raíz, pero sin copiar \e e.
+      */
+    ArbolGeneral(Tbase&& e);
+
     /**
       * @brief Constructor de copias
       * @param v ArbolGeneral a copiar
@@ -267,12 +463,21 @@ class ArbolGeneral{
       */
     ArbolGeneral (const ArbolGeneral<Tbase>& v);
 
+    /**
+      * @brief Constructor de movimiento
+      * @param v ArbolGeneral cuyos nodos pasan al árbol receptor
+      *
+      * El árbol receptor se queda con los nodos de \e v, que queda vacío.
+      * La operación se realiza en tiempo O(1).
+      */
+    ArbolGeneral (ArbolGeneral<Tbase>&& v);
+
     /**
       * @brief Destructor
       *
       * Libera los recursos ocupados por el árbol receptor. La operación se
-      * realiza en tiempo O(n), donde n es el número de elementos del árbol
-      * receptor.
+      * realiza en tiempo O(1).
+      * @see destruir
       */
     ~ArbolGeneral();
 
@@ -288,6 +493,16 @@ class ArbolGeneral{
       */
     ArbolGeneral<Tbase>& operator = (const ArbolGeneral<Tbase> &v);
 
+    /**
+      * @brief Operador de asignación por movimiento
+      * @param v ArbolGeneral cuyos nodos pasan al árbol receptor
+      * @return Referencia al árbol receptor.
+      *
+      * Libera el contenido del árbol receptor y se queda con los nodos de
+      * \e v, que queda vacío. La operación se realiza en tiempo O(1).
+      */
+    ArbolGeneral<Tbase>& operator = (ArbolGeneral<Tbase> &&v);
+
     /**
       * @brief Asignar nodo raíz
       * @param e Etiqueta a asignar al nodo raíz
@@ -379,11 +594,30 @@ class ArbolGeneral{
       */
     void asignar_subarbol(const ArbolGeneral<Tbase>& orig, const Nodo nod);
 
+    /**
+      * @brief Trasplanta un subárbol
+      * @param orig Árbol del que se extrae una rama
+      * @param nod Nodo raíz del subárbol que se trasplanta.
+      * @pre \e nod es un nodo del árbol \e orig y no es nulo
+      * @pre \e orig no es el árbol receptor
+      *
+      * Como la versión que copia, pero los nodos del subárbol que cuelga de
+      * \e nod pasan al árbol receptor sin copiar ninguna etiqueta, y
+      * desaparecen de \e orig, que conserva el resto de sus nodos. La
+      * operación se realiza en tiempo O(k), donde \e k es el número de
+      * hermanos a la izquierda de \e nod.
+      */
+    void asignar_subarbol(ArbolGeneral<Tbase>&& orig, const Nodo nod);
+
     /**
      * @brief Convierte a un hijo de la raíz, y el subárbol que cuelga de él,
      * en el nuevo árbol. Poda el resto del árbol, eliminándolo.
      * @param n Nodo que pasa a ser la nueva raíz
      * @pre n es un Nodo hijo de laraíz
+     *
+     * Los hermanos de \e n no se liberan uno a uno: se devuelven a la reserva
+     * junto con la raíz. La operación se realiza en tiempo O(k), donde \e k
+     * es el número de hermanos a la izquierda de \e n.
      */
     void asignar_subarbol(Nodo n);
 
@@ -428,6 +662,16 @@ class ArbolGeneral{
       */
     void insertar_hijomasizquierda(Nodo n, ArbolGeneral<Tbase>& rama);
 
+    /**
+      * @brief Insertar subárbol temporal como hijo más a la izquierda
+      * @see insertar_hijomasizquierda(Nodo, ArbolGeneral<Tbase>&)
+      *
+      * Permite insertar directamente un árbol temporal, p.ej.
+      * <tt>a.insertar_hijomasizquierda(n, ArbolGeneral<T>(std::move(e)))</tt>.
+      * Los nodos se enlazan sin copiarse, en tiempo O(1).
+      */
+    void insertar_hijomasizquierda(Nodo n, ArbolGeneral<Tbase>&& rama);
+
     /**
       * @brief Insertar subárbol hermano derecha
       * @param n Nodo al que se insertará el árbol \e rama como hermano a la
@@ -441,12 +685,19 @@ class ArbolGeneral{
       */
     void insertar_hermanoderecha(Nodo n, ArbolGeneral<Tbase>& rama);
 
+    /**
+      * @brief Insertar subárbol temporal como hermano derecha
+      * @see insertar_hermanoderecha(Nodo, ArbolGeneral<Tbase>&)
+      *
+      * Los nodos de \e rama se enlazan sin copiarse, en tiempo O(1).
+      */
+    void insertar_hermanoderecha(Nodo n, ArbolGeneral<Tbase>&& rama);
+
     /**
       * @brief Borra todos los elementos
       *
       * Borra todos los elementos del árbol receptor. Cuando termina, el árbol
-      * está vacía. La operación se realiza en tiempo O(n), donde \e n es el
-      * número de elementos del árbol receptor.
+      * está vacía. La operación se realiza en tiempo O(1).
       */
     void clear();
 
@@ -459,6 +710,13 @@ class ArbolGeneral{
       */
     int size() const;
 
+    /**
+      * @brief Memoria de un nodo
+      * @return El número de bytes que ocupa cada nodo del árbol, con su
+      * etiqueta.
+      */
+    static size_t bytes_nodo() { return sizeof(nodo); }
+
     /**
       * @brief Vacío
       * @return Devuelve \e true si el número de elementos del árbol receptor
@@ -1095,17 +1353,215 @@ class ArbolGeneral{
 /*____________________________________________________________ */
 
 template <class Tbase>
-void ArbolGeneral <Tbase>::destruir (nodo *& n){
-   if(n != 0){                                     //Si no es nulo.
-        Nodo t, aux;
-
-        t = n->izqda;                               //Vamos recorriendo los hijos
-        while( t !=0 ){                             // izquierda.
-            aux = t;                                //Y ahora nos encargamos de los
-            t = t->drcha;                           // hermanos.
-            destruir(aux);
+typename ArbolGeneral<Tbase>::reserva & ArbolGeneral<Tbase>::nodos(){
+    static thread_local reserva_hilo h;             //Una reserva por hilo.
+    return *h.r;
+}
+
+/*____________________________________________________________ */
+
+template <class Tbase>
+typename ArbolGeneral<Tbase>::nodo * ArbolGeneral<Tbase>::reserva::sacar(){
+    const size_t palabras = BLOQUE / 64;
+    while(true){
+        for(; bloque_actual < bloques.size(); ++bloque_actual, palabra_actual = 0){
+            bloque & b = bloques[bloque_actual];
+            for(; palabra_actual < palabras; ++palabra_actual){
+                uint64_t & w = b.libres[palabra_actual];
+                if(w != 0){                         //Primer nodo libre de la palabra.
+                    int bit = __builtin_ctzll(w);
+                    w &= w - 1;
+                    ocupados++;
+                    return b.memoria + palabra_actual * 64 + bit;
+                }
+            }
+        }
+
+        bool hay_devueltos;
+        {
+            std::lock_guard<std::mutex> l(cerrojo);
+            hay_devueltos = !devueltos.empty();
         }
-        delete n;
+        if(!pendientes.empty())                     //Reutilizamos lo destruido,
+            recoger();
+        else if(hay_devueltos)                      // lo que nos han devuelto
+            recoger_devueltos();
+        else{                                       // o pedimos otro bloque.
+            bloque b;
+            b.memoria = static_cast<nodo *>(::operator new(BLOQUE * sizeof(nodo)));
+            for(size_t i = 0; i < palabras; i++)
+                b.libres[i] = ~(uint64_t) 0;
+            size_t i = bloques.size();
+            bloques.push_back(b);
+            while(i > 0 && bloques[i-1].memoria > b.memoria){
+                bloques[i] = bloques[i-1];          //Mantenemos el orden por dirección.
+                i--;
+            }
+            bloques[i] = b;
+        }
+        bloque_actual = palabra_actual = 0;         //Volvemos a buscar desde el principio.
+    }
+}
+
+/*____________________________________________________________ */
+
+template <class Tbase>
+void ArbolGeneral<Tbase>::reserva::liberar(nodo * n){
+    //Bloque al que pertenece: el último que empieza antes que n.
+    std::uintptr_t dir = reinterpret_cast<std::uintptr_t>(n);
+    size_t ini = 0, fin = bloques.size();
+    while(fin - ini > 1){
+        size_t medio = (ini + fin) / 2;
+        if(reinterpret_cast<std::uintptr_t>(bloques[medio].memoria) <= dir)
+            ini = medio;
+        else
+            fin = medio;
+    }
+    std::uintptr_t base = reinterpret_cast<std::uintptr_t>(bloques[ini].memoria);
+    assert(dir >= base && dir < base + BLOQUE * sizeof(nodo));
+    size_t pos = (dir - base) / sizeof(nodo);
+    bloques[ini].libres[pos / 64] |= (uint64_t) 1 << (pos % 64);
+    ocupados--;
+}
+
+/*____________________________________________________________ */
+
+template <class Tbase>
+void ArbolGeneral<Tbase>::reserva::recoger(){
+    std::vector<nodo *> ajenos;                     //Nodos de otras reservas.
+    while(!pendientes.empty()){
+        nodo * n = pendientes.back();
+        pendientes.pop_back();
+        if(n->izqda != 0)                           //Apartamos sus hijos
+            pendientes.push_back(n->izqda);
+        if(n->drcha != 0)                           // y sus hermanos.
+            pendientes.push_back(n->drcha);
+        reserva * r = n->duenio;
+        n->~nodo();
+
+        if(r == this)
+            liberar(n);
+        else{
+            if(!ajenos.empty() && ajenos.back()->duenio != r)
+                devolver(ajenos.back()->duenio, ajenos);
+            n->duenio = r;                          //Sólo se conserva el dueño.
+            ajenos.push_back(n);
+        }
+    }
+    if(!ajenos.empty())
+        devolver(ajenos.back()->duenio, ajenos);
+}
+
+/*____________________________________________________________ */
+
+template <class Tbase>
+void ArbolGeneral<Tbase>::reserva::recoger_devueltos(){
+    std::vector<nodo *> v;
+    {
+        std::lock_guard<std::mutex> l(cerrojo);
+        v.swap(devueltos);
+    }
+    for(size_t i = 0; i < v.size(); i++)
+        liberar(v[i]);
+}
+
+/*____________________________________________________________ */
+
+template <class Tbase>
+void ArbolGeneral<Tbase>::reserva::devolver(reserva * r, std::vector<nodo *> & v){
+    bool ultimo = false;
+    {
+        std::lock_guard<std::mutex> l(r->cerrojo);
+        if(r->viva)                                 //Su hilo los recogerá.
+            r->devueltos.insert(r->devueltos.end(), v.begin(), v.end());
+        else{                                       //Su hilo ha terminado.
+            for(size_t i = 0; i < v.size(); i++)
+                r->liberar(v[i]);
+            ultimo = r->ocupados == 0;
+        }
+    }
+    v.clear();
+    if(ultimo)
+        delete r;
+}
+
+/*____________________________________________________________ */
+
+template <class Tbase>
+void ArbolGeneral<Tbase>::reserva::abandonar(){
+    recoger();
+    bool vacia;
+    {
+        std::lock_guard<std::mutex> l(cerrojo);
+        for(size_t i = 0; i < devueltos.size(); i++)
+            liberar(devueltos[i]);
+        devueltos.clear();
+        viva = false;
+        vacia = ocupados == 0;
+    }
+    if(vacia)
+        delete this;
+}
+
+/*____________________________________________________________ */
+
+template <class Tbase>
+ArbolGeneral<Tbase>::reserva::~reserva(){
+    for(size_t i = 0; i < bloques.size(); i++)
+        ::operator delete(bloques[i].memoria);
+}
+
+/*____________________________________________________________ */
+
+template <class Tbase>
+typename ArbolGeneral<Tbase>::nodo * ArbolGeneral<Tbase>::nuevo_nodo(){
+    reserva & r = nodos();
+    nodo * n = new (r.sacar()) nodo;
+    n->duenio = &r;
+    return n;
+}
+
+template <class Tbase>
+typename ArbolGeneral<Tbase>::nodo * ArbolGeneral<Tbase>::nuevo_nodo(const Tbase & e){
+    reserva & r = nodos();
+    nodo * n = new (r.sacar()) nodo(e);
+    n->duenio = &r;
+    return n;
+}
+
+template <class Tbase>
+typename ArbolGeneral<Tbase>::nodo * ArbolGeneral<Tbase>::nuevo_nodo(Tbase && e){
+    reserva & r = nodos();
+    nodo * n = new (r.sacar()) nodo(std::move(e));
+    n->duenio = &r;
+    return n;
+}
+
+/*____________________________________________________________ */
+
+template <class Tbase>
+void ArbolGeneral<Tbase>::desenganchar(nodo * n){
+    if(n == laraiz)                                 //Era la raíz: árbol vacío.
+        laraiz = 0;
+    else if(n->padre->izqda == n)                   //Era el hijo más a la izquierda.
+        n->padre->izqda = n->drcha;
+    else{                                           //Buscamos su hermano izquierda.
+        Nodo h = n->padre->izqda;
+        while(h->drcha != n)
+            h = h->drcha;
+        h->drcha = n->drcha;
+    }
+    n->padre = 0;
+    n->drcha = 0;
+}
+
+/*____________________________________________________________ */
+
+template <class Tbase>
+void ArbolGeneral <Tbase>::destruir (nodo *& n){
+    if(n != 0){                                     //Si no es nulo.
+        n->drcha = 0;                               //Sus hermanos no se destruyen.
+        nodos().pendientes.push_back(n);            //Se reutilizará más adelante.
         n = 0;
     }
 }
@@ -1120,7 +1576,7 @@ void ArbolGeneral<Tbase>::copiar(nodo * & dest, nodo * orig){
     }
     catch (exception e) {}
 
-    dest = new nodo(orig->etiqueta);
+    dest = nuevo_nodo(orig->etiqueta);
 
     if (orig->izqda != 0) {
        copiar(dest->izqda, orig->izqda);
@@ -1129,7 +1585,7 @@ void ArbolGeneral<Tbase>::copiar(nodo * & dest, nodo * orig){
     }
 
     if (orig->drcha != 0) {
-       dest->drcha = new nodo(orig->drcha->etiqueta);
+       dest->drcha = nuevo_nodo(orig->drcha->etiqueta);
        copiar(dest->drcha, orig->drcha);
        if (dest->drcha != 0) {
           dest->drcha->padre = dest->padre; // padre porque copia los hermanos del nodo origen. El padre de estos esta un nivel por encima
@@ -1192,7 +1648,7 @@ void ArbolGeneral<Tbase>::lee_arbol(std::istream& in, Nodo & nod){
             if(c == 'n'){                           //Nuevo nodo.
                 Tbase e;
                 in >> e;
-                nod = new nodo(e);
+                nod = nuevo_nodo(e);
                 lee_arbol(in, nod->izqda);          //Vamos introduciendo en preorden.
                 if(nod->izqda != 0)
                     nod->izqda->padre = nod;        //Le decimos quién es su padre.
@@ -1235,19 +1691,29 @@ void ArbolGeneral<Tbase>::escribe_arbol(std::ostream& out, Nodo nod) const{
 
 template <class Tbase>
 ArbolGeneral<Tbase>::ArbolGeneral(){
-    laraiz = new nodo;                              //Nuevo nodo vacío.
+    laraiz = nuevo_nodo();                              //Nuevo nodo vacío.
 }
 
 template <class Tbase>
 ArbolGeneral<Tbase>::ArbolGeneral(const Tbase& e){
-    laraiz = new nodo(e);                           //Un solo nodo con una etiqueta.
+    laraiz = nuevo_nodo(e);                           //Un solo nodo con una etiqueta.
+}
+
+template <class Tbase>
+ArbolGeneral<Tbase>::ArbolGeneral(Tbase&& e){
+    laraiz = nuevo_nodo(std::move(e));              //La etiqueta se mueve, no se copia.
+}
+
+template <class Tbase>
+ArbolGeneral<Tbase>::ArbolGeneral (ArbolGeneral<Tbase>&& v){
+    laraiz = v.laraiz;                              //Nos quedamos con sus nodos.
+    v.laraiz = 0;
 }
 
 template <class Tbase>
 ArbolGeneral<Tbase>::ArbolGeneral (const ArbolGeneral<Tbase>& v){
-    if(v.laraiz == 0)                               //Si el nodo apunta a null.
-        laraiz = 0;
-    else                                            //Sino,
+    laraiz = 0;                                     //copiar() destruye el destino.
+    if(v.laraiz != 0)                               //Si hay nodos,
         copiar(laraiz, v.laraiz);                   // copiamos todo a partir de él.
 }
 
@@ -1266,10 +1732,21 @@ ArbolGeneral<Tbase>::operator = (const ArbolGeneral<Tbase> &v){
     return *this;
 }
 
+template <class Tbase>
+ArbolGeneral<Tbase>&
+ArbolGeneral<Tbase>::operator = (ArbolGeneral<Tbase> &&v){
+    if(this != &v){
+        destruir(laraiz);                           //Borramos y nos quedamos
+        laraiz = v.laraiz;                          // con sus nodos.
+        v.laraiz = 0;
+    }
+    return *this;
+}
+
 template <class Tbase>
 void ArbolGeneral<Tbase>::AsignaRaiz(const Tbase& e){
     destruir(laraiz);                               //Borramos.
-    laraiz = new nodo(e);                           //Y asignamos el elemento a la raiz.
+    laraiz = nuevo_nodo(e);                           //Y asignamos el elemento a la raiz.
 }
 
 template <class Tbase>
@@ -1316,28 +1793,26 @@ asignar_subarbol(const ArbolGeneral<Tbase>& orig, const Nodo nod){
     }
 }
 
+template <class Tbase>
+void ArbolGeneral<Tbase>::
+asignar_subarbol(ArbolGeneral<Tbase>&& orig, const Nodo nod){
+    orig.desenganchar(nod);                         //Sacamos la rama de orig
+    destruir(laraiz);                               // y la ponemos en lugar de lo que teníamos.
+    laraiz = nod;
+}
+
 template <class Tbase>
 void ArbolGeneral<Tbase>::
 asignar_subarbol(Nodo n)
 {
-  while (laraiz->izqda != n)
-  {
-    Nodo aux = laraiz->izqda;
-    laraiz->izqda = laraiz->izqda->drcha;
-    destruir(aux);
-  }
-  while (laraiz->izqda->drcha)
-  {
-    Nodo aux = laraiz->izqda->drcha;
-    laraiz->izqda->drcha = laraiz->izqda->drcha->drcha;
-    destruir(aux);
-  }
-
-  laraiz->izqda = 0;
-  delete laraiz;
+  Nodo raiz_anterior = laraiz;
+
+  // Desenganchar n de la lista de hijos de la raíz
+  desenganchar(n);
+
+  // La raíz y el resto de sus hijos se reutilizarán más adelante
+  destruir(raiz_anterior);
   laraiz = n;
-  laraiz->padre = 0;
-  laraiz->drcha = 0;
 }
 
 template <class Tbase>
@@ -1375,6 +1850,12 @@ insertar_hijomasizquierda(Nodo n, ArbolGeneral<Tbase>& rama){
     rama.laraiz = 0;                                //Y la rama queda vacía.
 }
 
+template <class Tbase>
+void ArbolGeneral<Tbase>::
+insertar_hijomasizquierda(Nodo n, ArbolGeneral<Tbase>&& rama){
+    insertar_hijomasizquierda(n, rama);             //Enlaza los nodos sin copiarlos.
+}
+
 template <class Tbase>
 void ArbolGeneral<Tbase>::
 insertar_hermanoderecha(Nodo n, ArbolGeneral<Tbase>& rama){
@@ -1386,6 +1867,12 @@ insertar_hermanoderecha(Nodo n, ArbolGeneral<Tbase>& rama){
     rama.laraiz = 0;                                //Rama queda vacía.
 }
 
+template <class Tbase>
+void ArbolGeneral<Tbase>::
+insertar_hermanoderecha(Nodo n, ArbolGeneral<Tbase>&& rama){
+    insertar_hermanoderecha(n, rama);               //Enlaza los nodos sin copiarlos.
+}
+
 template <class Tbase>
 void ArbolGeneral<Tbase>::clear(){
     destruir(laraiz);
@@ -1453,7 +1940,7 @@ void ArbolGeneral<Tbase>::recuperar_arbol(string preorden, string inorden, strin
         string preorden_izqda, inorden_izqda, postorden_izqda;
         string preorden_drcha, inorden_drcha, postorden_drcha;
         if(nuevo == 0)
-            nuevo = new nodo(preorden[0]);
+            nuevo = nuevo_nodo(preorden[0]);
         else
             nuevo->etiqueta = preorden[0];                  //Creamos la raiz.
 
@@ -1482,13 +1969,13 @@ void ArbolGeneral<Tbase>::recuperar_arbol(string preorden, string inorden, strin
             preorden_drcha.erase(preorden_drcha.begin());
 
         if(preorden_izqda.size() != 0 && postorden_izqda.size() != 0 && inorden_izqda.size() != 0){
-            nuevo->izqda = new nodo;
+            nuevo->izqda = nuevo_nodo();
             recuperar_arbol(preorden_izqda, inorden_izqda, postorden_izqda, nuevo->izqda);
             if(nuevo->izqda != 0)
                 nuevo->izqda->padre = nuevo;
         }
         if(preorden_drcha.size() != 0 && postorden_drcha.size() != 0 && inorden_drcha.size() != 0){
-            nuevo->izqda->drcha = new nodo;
+            nuevo->izqda->drcha = nuevo_nodo();
             recuperar_arbol(preorden_drcha, inorden_drcha, postorden_drcha, nuevo->izqda->drcha);
             typename ArbolGeneral<Tbase>::Nodo n = nuevo->izqda;
             while(n != 0){                                  //Decimos a cada hijo quién es su padre.
@@ -1524,7 +2011,7 @@ void ArbolGeneral<Tbase>::recuperar_arbol(string preorden, string inorden, strin
             recuperar_arbol(preorden_izqda, inorden_izqda, postorden_izqda, nuevo);
         }
         if(preorden_drcha.size() != 0 && postorden_drcha.size() != 0 && inorden_drcha.size() != 0){
-            nuevo->drcha = new nodo;
+            nuevo->drcha = nuevo_nodo();
             recuperar_arbol(preorden_drcha, inorden_drcha, postorden_drcha, nuevo->drcha);
         }
     }
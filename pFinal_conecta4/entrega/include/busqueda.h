@@ -0,0 +1,344 @@
+/**
+ * @file busqueda.h
+ * @brief Fichero de cabecera para el TDA Busqueda
+ *
+ */
+
+#ifndef __BUSQUEDA_H__
+#define __BUSQUEDA_H__
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "evaluador.h"
+#include "grupo_hilos.h"
+#include "motor.h"
+#include "tabla_transposicion.h"
+#include "tablero.h"
+
+/**
+ * @brief Parámetros de configuración del motor de búsqueda.
+ */
+struct ParametrosBusqueda
+{
+  int memoria_tt;   ///< Memoria (en MB) de la tabla de transposición
+  int profundidad;  ///< Profundidad máxima si no hay límite de tiempo
+  int tiempo_ms;    ///< Tiempo máximo por jugada, en milisegundos (0 sin límite)
+  int hilos;        ///< Hilos de trabajo (0 para usar todos los núcleos). En
+                    ///< la Busqueda, hilos de Lazy SMP
+  bool orden_dinamico;  ///< Ordenar también con jugadas asesinas e historia
+  string libro;     ///< Fichero del libro de aperturas (vacío si no se usa)
+  int casillas_final;   ///< Con menos casillas libres, se resuelve el final
+                        ///< de forma exacta (0, por defecto, nunca)
+  int memoria_resolvedor;   ///< Memoria (en MB) de la tabla de transposición
+                            ///< del Resolvedor de finales
+  string estadisticas;  ///< Fichero donde se añaden las estadísticas de cada
+                        ///< jugada (vacío si no se guardan; ver Estadisticas)
+  bool anticipar;       ///< Seguir buscando durante el turno del rival
+  int simulaciones;     ///< Simulaciones por jugada de MonteCarlo si no hay
+                        ///< límite de tiempo
+  uint64_t semilla;     ///< Semilla de los motores que juegan al azar (0 para
+                        ///< una distinta cada vez; ver Aleatorio)
+
+  /**
+   * @brief Constructor con los valores por defecto.
+   */
+  ParametrosBusqueda() : memoria_tt(16), profundidad(10), tiempo_ms(0),
+                         hilos(1), orden_dinamico(true), casillas_final(0),
+                         memoria_resolvedor(4), anticipar(false),
+                         simulaciones(20000), semilla(0) { }
+};
+
+/**
+ * @brief T.D.A. Busqueda
+ *
+ * Una instancia @e b del T.D.A. Busqueda es un motor de búsqueda para el
+ * Conecta-4 basado en negamax con poda alfa-beta. A diferencia de las métricas
+ * que exploran un ArbolGeneral, no guarda ningún nodo: recorre el espacio de
+ * soluciones en profundidad sobre un único Tablero, colocando y quitando
+ * fichas.
+ *
+ * Las puntuaciones se dan siempre desde el punto de vista del jugador al que
+ * le toca mover. Una victoria vale VICTORIA menos el número de fichas
+ * colocadas desde la raíz, de forma que se prefieren las victorias rápidas y
+ * las derrotas lentas.
+ *
+ * Los resultados de cada nodo se guardan en una TablaTransposicion, que se
+ * conserva entre búsquedas. Antes de explorar un nodo se consulta la tabla:
+ * si la posición ya se buscó con suficiente profundidad se usa su valor, y
+ * si no, su mejor columna se prueba la primera.
+ *
+ * El resto de jugadas se ordena para podar cuanto antes: primero las
+ * jugadas asesinas del nivel (las dos últimas que provocaron una poda en
+ * otro nodo del mismo nivel), y después las demás según la tabla de
+ * historia (cuántas podas han provocado, pesadas por la profundidad), y a
+ * igualdad desde el centro hacia los lados. La búsqueda cuenta las podas y
+ * cuántas de ellas las provocó la primera jugada probada, que mide lo bueno
+ * que es el orden.
+ *
+ * La búsqueda es iterativa en profundidad: se busca con profundidad 1, 2, ...
+ * hasta la profundidad máxima o hasta agotar el tiempo por jugada. Cada
+ * iteración prueba primero la variante principal de la anterior, y si se
+ * agota el tiempo se descarta la iteración en curso y se devuelve la mejor
+ * columna de la última completada.
+ *
+ * Con más de un hilo la búsqueda usa Lazy SMP: el hilo principal hace la
+ * búsqueda iterativa de siempre y los auxiliares buscan la misma posición a
+ * la vez, cada uno empezando por una profundidad distinta, sin más
+ * comunicación que la tabla de transposición compartida. Lo que guardan los
+ * auxiliares hace que el principal pode antes; la jugada elegida es siempre
+ * la del hilo principal.
+ *
+ * Mientras el rival piensa su jugada, la búsqueda puede seguir trabajando en
+ * segundo plano (pensar()) sobre la posición a la que se espera llegar: la
+ * de la variante principal tras la respuesta más probable del rival. Al pedir
+ * la jugada se detiene; si el rival ha jugado lo esperado, se aprovecha lo
+ * buscado: se devuelve su columna si la búsqueda terminó, o se reanuda desde
+ * la profundidad a la que llegó. Si no, la tabla de transposición queda
+ * igualmente con posiciones cercanas.
+ *
+ * Es el Motor de la métrica 5 del JugadorAuto.
+ */
+class Busqueda : public Motor
+{
+  private:
+    /**
+     * @brief Estado propio de cada hilo de la búsqueda.
+     */
+    struct Hilo
+    {
+      long nodos;                ///< Nodos visitados en la búsqueda actual
+      long nodos_total;          ///< Nodos visitados en todas las búsquedas
+      int profundidad;           ///< Profundidad de la última iteración completada
+      int valor;                 ///< Valor de la raíz en esa iteración
+
+      /// Variante principal encontrada desde cada nivel en la iteración actual
+      vector<vector<int> > vp;
+      vector<int> long_vp;       ///< Longitud de la variante principal de cada nivel
+      vector<int> vp_anterior;   ///< Variante principal de la iteración anterior
+      bool sigue_vp;             ///< El nodo actual está en la variante anterior
+      bool cancelada;            ///< Se ha abandonado la iteración en curso
+
+      vector<int> asesinas;      ///< Dos jugadas asesinas por nivel
+      vector<long> historia;     ///< Peso de cada casilla, por jugador
+      long cortes;               ///< Podas en todas las búsquedas
+      long cortes_primera;       ///< Podas provocadas por la primera jugada
+
+      Hilo() : nodos(0), nodos_total(0), profundidad(0), valor(0), sigue_vp(false),
+               cancelada(false), cortes(0), cortes_primera(0) { }
+    };
+
+    ParametrosBusqueda params;   ///< Parámetros del motor
+    TablaTransposicion tabla;    ///< Resultados de posiciones ya buscadas
+    Evaluador evaluador;         ///< Cuenta las ventanas abiertas en evaluar()
+    shared_ptr<GrupoHilos> grupo;  ///< Hilos de Lazy SMP (nulo con un hilo)
+    vector<Hilo> hilos;          ///< Estado de cada hilo; el 0 es el principal
+
+    bool con_limite;             ///< Hay límite de tiempo
+    bool parar;                  ///< Los hilos auxiliares deben terminar
+    chrono::steady_clock::time_point limite;  ///< Instante en que se agota el tiempo
+    double segundos_total;       ///< Tiempo total de todas las búsquedas
+
+    unique_ptr<thread> pensador; ///< Hilo que piensa en el turno del rival (o nulo)
+    bool pensada;                ///< Hay una búsqueda hecha pensando
+    uint64_t clave_pensada;      ///< Clave del tablero que se ha pensado
+    int col_pensada;             ///< Mejor columna encontrada pensando
+    bool pensada_completa;       ///< La búsqueda pensando llegó hasta el final
+
+    /**
+     * @brief Prepara el estado de los hilos (y el evaluador) para una búsqueda.
+     * @param t Tablero desde el que se busca
+     * @param max_prof Profundidad máxima de la búsqueda
+     * @param reanudar Si se continúa la búsqueda anterior (hecha pensando):
+     * entonces se conservan su variante principal, su profundidad y la
+     * historia.
+     */
+    void prepararHilos(const Tablero& t, int max_prof, bool reanudar);
+
+    /**
+     * @brief Búsqueda iterativa de todos los hilos.
+     * @param t Tablero desde el que buscar
+     * @param primera Profundidad de la primera iteración del hilo principal
+     * @param max_prof Profundidad máxima
+     * @param inicio Instante en que empezó la búsqueda
+     * @return Mejor columna de la última iteración completada por el hilo
+     * principal, o -1 si no se completó ninguna.
+     */
+    int buscar(const Tablero& t, int primera, int max_prof,
+               chrono::steady_clock::time_point inicio);
+
+    /**
+     * @brief Búsqueda iterativa en profundidad de un hilo.
+     * @param h Estado del hilo
+     * @param t Tablero desde el que buscar (copia propia del hilo)
+     * @param primera Profundidad de la primera iteración
+     * @param max_prof Profundidad máxima
+     * @param inicio Instante en que empezó la búsqueda
+     * @return Mejor columna de la última iteración completada, o -1 si no
+     * se completó ninguna.
+     */
+    int iterar(Hilo& h, Tablero& t, int primera, int max_prof,
+                chrono::steady_clock::time_point inicio);
+
+    /**
+     * @brief Ordena las columnas libres en el orden en que se exploran: la
+     * de la variante principal anterior, la de la tabla de transposición,
+     * las asesinas del nivel y el resto por historia y desde el centro hacia
+     * los lados.
+     * @param h Estado del hilo que busca
+     * @param t Tablero actual
+     * @param nivel Número de fichas colocadas desde la raíz
+     * @param col_vp Columna de la variante principal (-1 si no hay)
+     * @param col_tabla Mejor columna según la tabla (-1 si no hay)
+     * @param orden Vector donde se dejan las columnas ordenadas
+     */
+    void ordenarJugadas(const Hilo& h, Tablero& t, int nivel, int col_vp,
+                        int col_tabla, vector<int>& orden) const;
+
+    /**
+     * @brief Anota que una jugada ha provocado una poda: la cuenta, la
+     * guarda como asesina del nivel y aumenta su historia.
+     * @param h Estado del hilo que busca
+     * @param t Tablero actual (antes de colocar la ficha)
+     * @param col Columna que provocó la poda
+     * @param i Posición de la jugada en el orden en que se probó
+     * @param profundidad Profundidad que quedaba en el nodo
+     * @param nivel Número de fichas colocadas desde la raíz
+     */
+    void anotarCorte(Hilo& h, const Tablero& t, int col, int i,
+                     int profundidad, int nivel);
+
+    /**
+     * @brief Evalúa heurísticamente un tablero sin explorar más jugadas,
+     * según las ventanas abiertas de cada jugador.
+     * @param t Tablero a evaluar
+     * @return Puntuación para el jugador al que le toca mover.
+     */
+    int evaluar(const Tablero& t) const;
+
+    /**
+     * @brief Negamax con poda alfa-beta.
+     * @param h Estado del hilo que busca
+     * @param t Tablero actual. Se modifica durante la búsqueda, pero se
+     * devuelve en el mismo estado.
+     * @param profundidad Número de fichas que quedan por colocar
+     * @param alfa Cota inferior de la ventana de búsqueda
+     * @param beta Cota superior de la ventana de búsqueda
+     * @param nivel Número de fichas colocadas desde la raíz
+     * @return Puntuación del tablero para el jugador al que le toca mover.
+     */
+    int negamax(Hilo& h, Tablero& t, int profundidad, int alfa, int beta,
+                int nivel);
+
+    /**
+     * @brief Convierte una puntuación de victoria o derrota relativa a la raíz
+     * en relativa al nodo actual, para guardarla en la tabla.
+     */
+    static int aTabla(int valor, int nivel);
+
+    /**
+     * @brief Convierte una puntuación de la tabla, relativa al nodo, en
+     * relativa a la raíz.
+     */
+    static int deTabla(int valor, int nivel);
+
+  public:
+    /// Puntuación de una victoria inmediata
+    const static int VICTORIA = 1000000;
+
+    /**
+     * @brief Constructor por defecto. No reserva tabla de transposición.
+     */
+    Busqueda();
+
+    /**
+     * @brief Constructor con parámetros.
+     * @param params Parámetros del motor (memoria de la tabla, profundidad,
+     * tiempo por jugada e hilos)
+     */
+    Busqueda(const ParametrosBusqueda& params);
+
+    /**
+     * @brief Destructor. Si está pensando, se detiene.
+     */
+    ~Busqueda();
+
+    Busqueda(Busqueda&&) = default;              // Sólo se puede mover (y
+    Busqueda& operator=(Busqueda&&) = default;   // sin estar pensando)
+
+    /**
+     * @brief Busca la mejor columna para el jugador al que le toca mover.
+     * Si hay límite de tiempo se profundiza hasta agotarlo (o hasta llenar el
+     * tablero); si no, hasta la profundidad de los parámetros.
+     * @param t Tablero actual de la partida
+     * @pre El tablero no está lleno y nadie ha ganado todavía
+     * @return Columna elegida
+     */
+    int mejorMovimiento(const Tablero& t);
+
+    /**
+     * @brief Empieza a buscar en segundo plano la mejor columna de un
+     * tablero, sin límite de tiempo, hasta que se llame a dejarDePensar() o
+     * a mejorMovimiento().
+     * @param t Tablero que se espera tener en el siguiente turno
+     * @pre El tablero no está lleno y nadie ha ganado todavía
+     */
+    void pensar(const Tablero& t);
+
+    /**
+     * @brief Detiene la búsqueda en segundo plano, si la hay, y espera a
+     * que termine. Lo buscado se conserva para el siguiente mejorMovimiento.
+     * @note Hay que llamarlo antes de consultar los nodos, las podas o el
+     * rendimiento mientras se piensa.
+     */
+    void dejarDePensar();
+
+    /**
+     * @brief Devuelve la respuesta del rival que espera la variante principal
+     * de la última búsqueda (su segunda jugada), o -1 si no la tiene.
+     */
+    int GetRespuestaEsperada() const;
+
+    /**
+     * @brief Devuelve el número de nodos visitados en la última búsqueda,
+     * sumando todos los hilos.
+     */
+    long GetNodos() const;
+
+    /**
+     * @brief Devuelve la profundidad de la última iteración completada por
+     * el hilo principal en la última búsqueda.
+     */
+    int GetProfundidad() const { return hilos[0].profundidad; }
+
+    /**
+     * @brief Devuelve el valor de la raíz en la última iteración completada:
+     * ±1 si la partida está resuelta y, si no, la evaluación pasada a (-1, 1)
+     * con una tangente hiperbólica.
+     */
+    double GetValor() const;
+
+    /**
+     * @brief Devuelve cuántas podas se han hecho en todas las búsquedas,
+     * sumando todos los hilos.
+     * @param primera Si se da, se deja en ella cuántas de esas podas las
+     * provocó la primera jugada probada en el nodo.
+     */
+    long GetCortes(long *primera = 0) const;
+
+    /**
+     * @brief Muestra los nodos por segundo de cada hilo, acumulados en todas
+     * las búsquedas hechas, y el porcentaje de podas que provocó la primera
+     * jugada probada.
+     * @param os Flujo de salida
+     */
+    void mostrarRendimiento(ostream& os) const;
+};
+
+#endif
+
+/* Fin fichero: busqueda.h */
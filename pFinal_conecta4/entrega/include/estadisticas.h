@@ -0,0 +1,176 @@
+/**
+ * @file estadisticas.h
+ * @brief Fichero de cabecera para el TDA Estadisticas
+ *
+ */
+
+#ifndef __ESTADISTICAS_H__
+#define __ESTADISTICAS_H__
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief T.D.A. Estadisticas
+ *
+ * Una instancia @e e del T.D.A. Estadisticas recoge lo que hace un jugador
+ * automático en cada jugada: los nodos del árbol de soluciones que expande y
+ * puntúa (y a qué nivel están), los nodos y podas de la búsqueda alfa-beta y
+ * del resolvedor, la memoria del árbol y el tiempo de cada fase. Al terminar
+ * cada jugada los datos se suman a los totales y, si se ha dado un fichero,
+ * se añaden a él como una línea en JSON.
+ *
+ * Las estadísticas sólo se recogen si se compila con la macro
+ * @e JUGADOR_ESTADISTICAS (make ESTADISTICAS=1). Si no, ACTIVAS vale false y
+ * todas las operaciones se quedan en nada: quien las use debe comprobar
+ * ACTIVAS antes de calcular datos que sólo sirven para las estadísticas,
+ * y así el compilador elimina ese código.
+ */
+class Estadisticas
+{
+  public:
+#ifdef JUGADOR_ESTADISTICAS
+    const static bool ACTIVAS = true;   ///< Se recogen las estadísticas
+#else
+    const static bool ACTIVAS = false;  ///< Se recogen las estadísticas
+#endif
+
+    /**
+     * @brief Fases de una jugada que se cronometran.
+     */
+    enum Fase
+    {
+      LIBRO,              ///< Consulta del libro de aperturas
+      RESOLVEDOR,         ///< Resolución exacta del final
+      ARBOL,              ///< Creación y puntuación de nodos del árbol
+      GANA_INMEDIATO,     ///< Búsqueda de una victoria inmediata
+      EVITA_PERDER,       ///< Búsqueda de las jugadas que no pierden
+      MAYOR_PUNTUACION,   ///< Elección de la jugada de mayor puntuación
+      BUSQUEDA,           ///< Búsqueda alfa-beta
+      NUM_FASES
+    };
+
+    /// Nombre de cada fase en el JSON
+    static const char *NOMBRE_FASE[NUM_FASES];
+
+    /**
+     * @brief Datos de una jugada (o, sumados, de todas).
+     */
+    struct Jugada
+    {
+      int numero;               ///< Fichas que había en el tablero
+      int jugador;              ///< Jugador que movía (1 o 2)
+      int metrica;              ///< Métrica con la que se eligió
+      int columna;              ///< Columna elegida
+      string origen;            ///< "libro", "resolvedor" o "metrica"
+      long expandidos;          ///< Nodos del árbol a los que se crean hijos
+      long evaluados;           ///< Nodos del árbol puntuados
+      vector<long> por_nivel;   ///< Nodos creados a cada nivel bajo la raíz
+      long nodos_busqueda;      ///< Nodos de la búsqueda alfa-beta
+      long cortes;              ///< Podas de la búsqueda alfa-beta
+      int profundidad;          ///< Profundidad completada por la búsqueda
+      long nodos_resolvedor;    ///< Nodos del resolvedor de finales
+      size_t memoria_arbol;     ///< Bytes del árbol al acabar la jugada
+      double segundos[NUM_FASES];  ///< Tiempo de cada fase
+
+      Jugada();
+    };
+
+    /**
+     * @brief Cronómetro de una fase: suma a la jugada actual el tiempo que
+     * pasa entre su construcción y su destrucción.
+     */
+    class Cronometro
+    {
+      private:
+        Estadisticas& e;        ///< Estadísticas donde se suma el tiempo
+        Fase fase;              ///< Fase que se cronometra
+        chrono::steady_clock::time_point inicio;  ///< Instante de construcción
+
+      public:
+        Cronometro(Estadisticas& est, Fase f) : e(est), fase(f)
+        {
+          if (ACTIVAS)
+            inicio = chrono::steady_clock::now();
+        }
+
+        ~Cronometro()
+        {
+          if (ACTIVAS)
+            e.actual.segundos[fase] +=
+              chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+        }
+    };
+
+  private:
+    Jugada actual;              ///< Jugada en curso
+    Jugada total;               ///< Suma de las jugadas terminadas
+    long jugadas;               ///< Jugadas terminadas
+    string fichero;             ///< Fichero JSON (vacío si no se guarda)
+
+    /**
+     * @brief Escribe una jugada como un objeto JSON en una línea.
+     */
+    static void escribirJSON(ostream& os, const Jugada& j);
+
+  public:
+    /**
+     * @brief Constructor.
+     * @param fichero Fichero al que se añade cada jugada en JSON, una por
+     * línea (vacío para no guardarlas).
+     */
+    Estadisticas(const string& fichero = "");
+
+    /**
+     * @brief Devuelve la jugada en curso, para anotar en ella.
+     */
+    Jugada& jugada() { return actual; }
+
+    /**
+     * @brief Anota los nodos creados en un nivel del árbol.
+     * @param nivel Nivel de los nodos bajo la raíz actual (desde 1)
+     * @param expandidos Nodos del nivel anterior a los que se han creado hijos
+     * @param creados Nodos creados (y puntuados)
+     */
+    void nivelArbol(int nivel, long expandidos, long creados)
+    {
+      if (ACTIVAS)
+      {
+        if ((int) actual.por_nivel.size() <= nivel)
+          actual.por_nivel.resize(nivel + 1, 0);
+        actual.por_nivel[nivel] += creados;
+        actual.expandidos += expandidos;
+        actual.evaluados += creados;
+      }
+    }
+
+    /**
+     * @brief Termina la jugada en curso: la suma a los totales, la guarda en
+     * el fichero (si hay) y empieza una nueva.
+     */
+    void terminarJugada();
+
+    /**
+     * @brief Devuelve la suma de todas las jugadas terminadas.
+     */
+    const Jugada& GetTotal() const { return total; }
+
+    /**
+     * @brief Devuelve el número de jugadas terminadas.
+     */
+    long GetJugadas() const { return jugadas; }
+
+    /**
+     * @brief Muestra un resumen de todas las jugadas.
+     * @param os Flujo de salida
+     */
+    void mostrar(ostream& os) const;
+};
+
+#endif
+
+/* Fin fichero: estadisticas.h */
@@ -0,0 +1,202 @@
+/**
+ * @file evaluador.h
+ * @brief Fichero de cabecera para el TDA Evaluador
+ *
+ */
+
+#ifndef __EVALUADOR_H__
+#define __EVALUADOR_H__
+
+#include <cstdint>
+#include "posicion.h"
+#include "tablero.h"
+
+using namespace std;
+
+/**
+ * @brief T.D.A. Evaluador
+ *
+ * Una instancia @e e del T.D.A. Evaluador cuenta las ventanas abiertas de
+ * cada jugador en los tableros de un tamaño dado, como
+ * Tablero::contarVentanas: una ventana son tantas casillas consecutivas de
+ * una fila, columna o diagonal como fichas hacen falta para ganar, y está
+ * abierta para un jugador si no tiene fichas del rival. Así, las ventanas
+ * abiertas con todas las fichas menos una son amenazas de ganar.
+ *
+ * El evaluador trabaja sobre las máscaras de bits de las fichas de cada
+ * jugador (como los bitboards del Tablero), así que sólo sirve para tableros
+ * de hasta 64 casillas; con los demás cuenta casilla a casilla. Al crearlo se
+ * calculan una vez las máscaras de las casillas en las que empieza una
+ * ventana en cada dirección, y cada cuenta suma en paralelo las fichas de
+ * todas las ventanas con contadores de bits. Las cuatro direcciones (con
+ * AVX2) o los dos jugadores (con SSE2) se procesan a la vez en los carriles
+ * de un registro vectorial. La implementación se elige al ejecutar, según lo
+ * que admita el procesador, y hay una versión escalar para los demás.
+ *
+ * También cuenta las alineaciones de la última ficha de una posición (ver
+ * contarAlineadas), con las mismas máscaras: desplazando las fichas del
+ * jugador a lo largo de cada dirección se obtienen a la vez las casillas
+ * desde las que sigue una línea de fichas suyas, y basta mirar el bit de la
+ * última ficha. Para los tamaños de tablero con detector de líneas
+ * especializado en el Tablero (hayLineaFija) hay también una versión con
+ * las máscaras, los desplazamientos y las fichas fijos al compilar.
+ *
+ * Un evaluador no cambia después de crearlo, así que lo pueden usar varios
+ * hilos a la vez.
+ */
+class Evaluador
+{
+  public:
+    /**
+     * @brief Implementaciones de la cuenta de ventanas.
+     */
+    enum Implementacion
+    {
+      ESCALAR,    ///< Sin instrucciones vectoriales
+      SSE2,       ///< Los dos jugadores a la vez, con SSE2
+      AVX2,       ///< Las cuatro direcciones a la vez, con AVX2
+      MEJOR       ///< La más rápida que admita el procesador
+    };
+
+    /// Nombre de cada implementación
+    static const char *NOMBRE_IMPLEMENTACION[MEJOR];
+
+  private:
+    /**
+     * @brief Función que cuenta las alineaciones de la última ficha (ver
+     * contarAlineadas) a partir de las fichas de su jugador.
+     */
+    typedef void (*ContadorAlineadas)(const Evaluador& e, uint64_t propias, uint64_t ultima,
+                                      int& alineadas1, int& alineadas2);
+
+    int filas;                  ///< Filas del tablero
+    int columnas;               ///< Columnas del tablero
+    int fichas_ganar;           ///< Fichas en línea para ganar (casillas de una ventana)
+    bool mascaras;              ///< El tablero cabe en una máscara de 64 bits
+    Implementacion impl;        ///< Implementación que se usa
+    int planos;                 ///< Bits de los contadores de fichas
+    uint64_t desp[4];           ///< Desplazamiento entre casillas vecinas de cada dirección
+    uint64_t inicio[4];         ///< Casillas en las que empieza una ventana de cada dirección
+    uint64_t validos[4];        ///< Casillas desde las que se avanza una casilla en cada dirección
+    ContadorAlineadas contador; ///< Cuenta las alineaciones (con máscaras)
+
+    /**
+     * @brief Versión de contarAlineadas con máscaras para cualquier tamaño
+     * de tablero que quepa en una.
+     * @param e Evaluador del tablero
+     * @param propias Fichas del jugador de la última ficha
+     * @param ultima Casilla de la última ficha
+     */
+    static void alineadasGenerica(const Evaluador& e, uint64_t propias, uint64_t ultima,
+                                  int& alineadas1, int& alineadas2);
+
+    /**
+     * @brief Versión de contarAlineadas que recorre las casillas, para los
+     * tableros que no caben en una máscara.
+     */
+    static int alineadasCasillas(const Posicion& p, int n);
+
+    /**
+     * @brief Cuenta las ventanas abiertas con cada implementación.
+     */
+    void contarEscalar(uint64_t fichas1, uint64_t fichas2,
+                       int ventanas[2][Tablero::MAX_FICHAS_GANAR + 1]) const;
+    void contarSSE2(uint64_t fichas1, uint64_t fichas2,
+                    int ventanas[2][Tablero::MAX_FICHAS_GANAR + 1]) const;
+    void contarAVX2(uint64_t fichas1, uint64_t fichas2,
+                    int ventanas[2][Tablero::MAX_FICHAS_GANAR + 1]) const;
+
+  public:
+    /**
+     * @brief Constructor por defecto. Crea el evaluador de un tablero 0x0.
+     */
+    Evaluador();
+
+    /**
+     * @brief Constructor.
+     * @param filas Filas del tablero
+     * @param columnas Columnas del tablero
+     * @param fichas_ganar Fichas en línea necesarias para ganar
+     * @param i Implementación que se quiere usar. Si el procesador no la
+     * admite, se usa la mejor que sí admita.
+     */
+    Evaluador(int filas, int columnas, int fichas_ganar, Implementacion i = MEJOR);
+
+    /**
+     * @brief Indica si un tablero de ese tamaño cabe en una máscara de 64 bits.
+     */
+    static bool cabe(int filas, int columnas)
+    {
+      return filas > 0 && filas < 64 && columnas > 0 && filas * columnas <= 64;
+    }
+
+    /**
+     * @brief Devuelve la implementación más rápida que admite el procesador.
+     */
+    static Implementacion mejorImplementacion();
+
+    /**
+     * @brief Devuelve la implementación que usa el evaluador (ESCALAR si el
+     * tablero no cabe en una máscara).
+     */
+    Implementacion GetImplementacion() const { return mascaras ? impl : ESCALAR; }
+
+    /**
+     * @brief Indica si el evaluador cuenta las alineaciones con una versión
+     * especializada para su tamaño de tablero y sus fichas para ganar.
+     */
+    bool EstaEspecializado() const
+    {
+      return mascaras && contador != &Evaluador::alineadasGenerica;
+    }
+
+    /**
+     * @brief Indica si el evaluador sirve para los tableros como t.
+     */
+    bool sirvePara(const Tablero& t) const
+    {
+      return t.GetFilas() == filas && t.GetColumnas() == columnas
+             && t.GetFichasGanar() == fichas_ganar;
+    }
+
+    /**
+     * @brief Cuenta las ventanas abiertas de cada jugador a partir de sus
+     * fichas.
+     * @param fichas1 Máscara con las fichas del jugador 1
+     * @param fichas2 Máscara con las fichas del jugador 2
+     * @param ventanas ventanas[j][k] recibe el número de ventanas abiertas del
+     * jugador j+1 con exactamente k fichas suyas (0 <= k <= fichas para ganar).
+     * @pre Evaluador::cabe(filas, columnas)
+     */
+    void contar(uint64_t fichas1, uint64_t fichas2,
+                int ventanas[2][Tablero::MAX_FICHAS_GANAR + 1]) const;
+
+    /**
+     * @brief Cuenta las ventanas abiertas de cada jugador en un tablero.
+     * @pre sirvePara(t)
+     */
+    void contar(const Tablero& t, int ventanas[2][Tablero::MAX_FICHAS_GANAR + 1]) const;
+
+    /**
+     * @brief Cuenta las ventanas abiertas de cada jugador en una posición.
+     * @pre La posición es de un tablero para el que sirve el evaluador.
+     */
+    void contar(const Posicion& p, int ventanas[2][Tablero::MAX_FICHAS_GANAR + 1]) const;
+
+    /**
+     * @brief Cuenta las alineaciones de la última ficha de una posición:
+     * en cuántas de las 8 direcciones (las 4 líneas en los dos sentidos) la
+     * siguen n - 1 fichas del mismo jugador, de forma que forman n en línea.
+     * @param p Posición, de un tablero para el que sirve el evaluador
+     * @param alineadas1 Recibe las alineaciones de fichas_ganar - 1 fichas
+     * (-1 si la posición está vacía)
+     * @param alineadas2 Recibe las alineaciones de fichas_ganar - 2 fichas
+     * (-1 si la posición está vacía)
+     * @note Con n = 1 cuenta las 8 direcciones, y con n = 0, ninguna.
+     */
+    void contarAlineadas(const Posicion& p, int& alineadas1, int& alineadas2) const;
+};
+
+#endif
+
+/* Fin fichero: evaluador.h */
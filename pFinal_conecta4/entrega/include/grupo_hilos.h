@@ -0,0 +1,91 @@
+/**
+ * @file grupo_hilos.h
+ * @brief Fichero de cabecera para el TDA GrupoHilos
+ *
+ */
+
+#ifndef __GRUPO_HILOS_H__
+#define __GRUPO_HILOS_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief T.D.A. GrupoHilos
+ *
+ * Una instancia @e g del T.D.A. GrupoHilos es un conjunto fijo de hilos de
+ * trabajo que se crean una sola vez y se reutilizan para repartir lotes de
+ * tareas independientes, numeradas de 0 a n-1.
+ *
+ * Cada lote se lanza con ejecutar(), que no vuelve hasta que se han terminado
+ * todas sus tareas. El hilo que llama también trabaja, así que un grupo de
+ * @e h hilos sólo crea @e h - 1 hilos nuevos. Las tareas se asignan por orden
+ * a medida que los hilos quedan libres, por lo que cada tarea debe escribir su
+ * resultado en una posición propia: así el resultado no depende de qué hilo
+ * ejecutó cada tarea.
+ */
+class GrupoHilos
+{
+  private:
+    vector<thread> hilos;                 ///< Hilos de trabajo (sin el llamante)
+    mutex cerrojo;                        ///< Protege el estado del lote
+    condition_variable hay_lote;          ///< Avisa a los hilos de un lote nuevo
+    condition_variable lote_terminado;    ///< Avisa al llamante del fin del lote
+
+    function<void(int)> tarea;            ///< Tarea del lote actual
+    int num_tareas;                       ///< Número de tareas del lote actual
+    atomic<int> siguiente;                ///< Siguiente tarea por asignar
+    int trabajando;                       ///< Hilos que aún no han acabado el lote
+    long lote;                            ///< Número de lote, para detectar uno nuevo
+    bool terminar;                        ///< Los hilos deben salir
+
+    /**
+     * @brief Bucle de cada hilo de trabajo.
+     */
+    void trabajar();
+
+    /**
+     * @brief Ejecuta tareas del lote actual hasta que no quede ninguna.
+     */
+    void repartir();
+
+    GrupoHilos(const GrupoHilos&);              // No se puede copiar
+    GrupoHilos& operator=(const GrupoHilos&);
+
+  public:
+    /**
+     * @brief Constructor. Crea un grupo de @e num_hilos hilos.
+     * @param num_hilos Número de hilos que ejecutan tareas, incluido el que
+     * llama a ejecutar(). Con 0 se usa el número de núcleos del equipo.
+     */
+    GrupoHilos(int num_hilos = 0);
+
+    /**
+     * @brief Destructor. Espera a que terminen los hilos.
+     */
+    ~GrupoHilos();
+
+    /**
+     * @brief Ejecuta las tareas 0, ..., n-1 repartidas entre los hilos.
+     * @param n Número de tareas
+     * @param f Función que ejecuta la tarea i. Puede llamarse a la vez desde
+     * varios hilos con distinto i.
+     * @post Todas las tareas han terminado.
+     */
+    void ejecutar(int n, const function<void(int)>& f);
+
+    /**
+     * @brief Número de hilos del grupo, incluido el que llama a ejecutar().
+     */
+    int size() const { return hilos.size() + 1; }
+};
+
+#endif
+
+/* Fin fichero: grupo_hilos.h */
@@ -7,7 +7,20 @@
 #ifndef __JUGADOR_AUTO_H__
 #define __JUGADOR_AUTO_H__
 
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+#include "aleatorio.h"
 #include "arbol_general.h"
+#include "busqueda.h"
+#include "estadisticas.h"
+#include "evaluador.h"
+#include "grupo_hilos.h"
+#include "libro_aperturas.h"
+#include "motor.h"
+#include "posicion.h"
+#include "resolvedor.h"
 #include "tablero.h"
 
 /**
@@ -15,48 +28,260 @@
  *
  * Una instancia @j del T.D.A. JugadorAuto representa un jugador automático
  * en el juego Conecta-4. Este jugador se encarga de decidir la columna donde
- * pondrá su ficha, apoyándose en una @e métrica determinada para hacerlo.
+ * pondrá su ficha, apoyándose en una @e métrica (una Estrategia) determinada
+ * para hacerlo.
  *
- * Estas métricas se basan en explorar el espacio de soluciones de la partida,
- * representado como un ArbolGeneral. Para aquellas métricas que lo empleen,
- * se define la profundidad máxima @e N que se puede explorar en el árbol.
+ * Las estrategias están registradas con un nombre y un número. Unas se
+ * basan en explorar el espacio de soluciones de la partida, representado
+ * como un ArbolGeneral, hasta una profundidad dada (como mucho @e N); cada
+ * una tiene su forma de puntuar los nodos y de elegir la jugada con el
+ * árbol. Las demás usan un Motor propio, que el jugador crea al construirse:
+ * así se pueden añadir motores nuevos con registrar(), sin tocar la clase.
+ * Las estrategias propias son:
+ * - 1 (amenazas): árbol de profundidad N, puntuando las amenazas.
+ * - 2 (arbol): árbol de profundidad N, puntuando las partidas ganadas.
+ * - 3 (segura): árbol de profundidad 2; juega al azar donde no pierde.
+ * - 4 (aleatoria): juega en una columna al azar.
+ * - 5 (alfabeta): Busqueda alfa-beta.
+ * - 6 (mcts): búsqueda de MonteCarlo en árbol, para tableros grandes.
+ *
+ * Los nodos del árbol guardan cada tablero como una Posicion compacta, que se
+ * expande a un Tablero sólo para generar sus hijos, junto con la puntuación
+ * acumulada del subárbol que cuelga de él (ver Solucion).
+ *
+ * El árbol se construye la primera vez que hace falta elegir una jugada
+ * con él, y se conserva de un turno a otro: tras cada jugada se queda el
+ * subárbol de la jugada hecha y se amplía un nivel más. El jugador guarda la
+ * frontera del árbol (las hojas que aún pueden tener hijos), de modo que
+ * ampliarlo sólo cuesta crear los nodos nuevos, sin recorrer el resto.
+ *
+ * Si se le da un LibroAperturas, las métricas 1, 2, 5 y 6 (las que usan
+ * atajos) consultan el libro antes de nada y, mientras la posición esté en
+ * él, juegan su columna sin construir el árbol ni buscar. Del mismo modo,
+ * si se pide en los parámetros (casillas_final), cuando quedan pocas
+ * casillas libres resuelven la partida de forma exacta con un Resolvedor y
+ * juegan la columna que gana o, si no se puede ganar, la que empata. Si la
+ * partida está perdida siguen con su métrica, que puede aprovechar un error
+ * del rival. Por defecto no se usa, y las métricas juegan el final como
+ * siempre.
+ *
+ * Si se compila con estadísticas (ver Estadisticas), el jugador anota en
+ * cada jugada los nodos que crea y busca, la memoria del árbol y el tiempo
+ * de cada fase.
+ *
+ * El jugador automático puede ser cualquiera de los dos jugadores: es el
+ * que tiene el turno cuando se construye el árbol.
+ *
+ * La métrica 5 no construye el árbol: su motor es una Busqueda alfa-beta
+ * iterativa sobre el tablero actual, limitada por profundidad o por tiempo
+ * según sus ParametrosBusqueda.
+ *
+ * Si los parámetros piden más de un hilo, el árbol se amplía repartiendo
+ * las jugadas de la raíz entre un GrupoHilos (o, si no hay bastantes para
+ * los hilos, los nodos de un nivel más abajo): cada hilo crea y puntúa el
+ * subárbol de sus nodos, y al terminar se suman a los nodos de encima los
+ * puntos de cada subárbol, siempre en el mismo orden. Cada nodo depende sólo
+ * de su posición, así que el árbol (y la columna elegida) es el mismo con
+ * cualquier número de hilos. La elección de la columna sólo recorre los
+ * hijos de la raíz, que ya guardan la puntuación de su subárbol.
+ *
+ * La métrica 5 sólo usa varios hilos (con Lazy SMP) si se pide al construir
+ * el jugador. Si los parámetros lo piden, tras cada jugada el motor sigue
+ * pensando en segundo plano durante el turno del rival, sobre la posición
+ * que espera tener (ver Motor::pensar).
  *
  */
 class JugadorAuto
 {
+  public:
+    /**
+     * @brief Etiqueta de un nodo del árbol de soluciones.
+     *
+     * Además de la posición, guarda las alineaciones de la última ficha y la
+     * puntuación del subárbol que cuelga del nodo, calculadas una sola vez.
+     * La puntuación de un nodo a nivel @e lvl (ver calcularPuntuacion) es
+     * lineal en el nivel, así que la del subárbol se guarda sin depender de
+     * él: vale suma + pendiente * (N - lvl). Al ampliar el árbol sólo cambian
+     * los antecesores de los nodos nuevos, y al cambiar de raíz no cambia
+     * nada.
+     */
+    struct Solucion
+    {
+      Posicion pos;         ///< Posición del tablero
+      int8_t alineadas3;    ///< Alineaciones de la última ficha a una ficha de ganar
+      int8_t alineadas2;    ///< Alineaciones de la última ficha a dos fichas de ganar
+      int64_t suma;         ///< Parte fija de la puntuación del subárbol
+      int64_t pendiente;    ///< Parte que se multiplica por (N - lvl)
+
+      Solucion() : alineadas3(0), alineadas2(0), suma(0), pendiente(0) { }
+      explicit Solucion(const Posicion& p)
+        : pos(p), alineadas3(0), alineadas2(0), suma(0), pendiente(0) { }
+    };
+
+    /// Unidad de las puntuaciones: las de la métrica 1 son múltiplos de 1/16
+    const static int UNIDAD = 16;
+
+    /**
+     * @brief Estrategia con la que el jugador elige sus jugadas.
+     *
+     * Una estrategia usa el árbol de soluciones (profundidad > 0, con las
+     * funciones puntuar y elegir) o un Motor, que crea la función crear.
+     * Las funciones del árbol son miembros privados del jugador, así que las
+     * estrategias que se registran desde fuera de la clase sólo pueden ser
+     * del segundo tipo.
+     */
+    struct Estrategia
+    {
+      /// Puntúa los nodos [desde, hasta) de un nivel recién creado
+      typedef void (JugadorAuto::*Puntuar)(const vector<ArbolGeneral<Solucion>::Nodo>& nodos,
+                                           size_t desde, size_t hasta);
+      /// Elige la columna con el árbol de soluciones
+      typedef int (JugadorAuto::*Elegir)();
+      /// Crea el motor de una estrategia que no usa el árbol
+      typedef unique_ptr<Motor> (*Crear)(const Tablero& inicial,
+                                         const ParametrosBusqueda& params,
+                                         bool lazy_smp);
+      /// Indica si la estrategia admite los tableros de un tamaño
+      typedef bool (*Cabe)(int filas, int columnas);
+
+      string nombre;          ///< Nombre (p.ej. para la opción -m)
+      int numero;             ///< Número de métrica (mayor que 0)
+      string descripcion;     ///< Descripción de una línea
+      bool atajos;            ///< Consulta el libro y el resolvedor de finales
+      int profundidad;        ///< Niveles del árbol (0 si no lo usa)
+      Puntuar puntuar;        ///< Puntuación de los nodos (si usa el árbol)
+      Elegir elegir;          ///< Elección con el árbol (si lo usa)
+      Crear crear;            ///< Creación del motor (si no usa el árbol)
+      Cabe cabe;              ///< Tamaños que admite (nulo si todos)
+    };
+
   private:
-    ArbolGeneral<Tablero> partida;   ///< Espacio de soluciones
-    int metrica;                     ///< Métrica escogida
+    ArbolGeneral<Solucion> partida;  ///< Espacio de soluciones
+    vector<ArbolGeneral<Solucion>::Nodo> frontera; ///< Hojas por expandir
+    Tablero actual;                  ///< Tablero actual de la partida
+    Estrategia estrategia;           ///< Métrica escogida
+    unique_ptr<Motor> motor;         ///< Motor de la estrategia (o nulo si usa el árbol)
+    Estrategia::Puntuar puntuar;     ///< Puntuación de los nodos del árbol
+    Evaluador evaluador;             ///< Cuenta las alineaciones de la última ficha
+    shared_ptr<GrupoHilos> grupo;    ///< Hilos para ampliar el árbol (o nulo)
+    LibroAperturas libro;            ///< Libro de aperturas (puede estar cerrado)
+    Resolvedor resolvedor;           ///< Resolvedor de finales
+    int casillas_final;              ///< Casillas libres para usar el resolvedor
+    bool arbol_construido;           ///< Ya se ha creado el árbol de soluciones
+    int jugador;                     ///< Jugador (1 o 2) que mueve en la raíz
+    long nodos;                      ///< Nodos creados o buscados en total
+    Estadisticas estadisticas;       ///< Datos de cada jugada (si se recogen)
+    bool anticipar;                  ///< Pensar en el turno del rival (con motor)
+    int respuesta_esperada;          ///< Respuesta del rival según el motor
+    Aleatorio aleatorio;             ///< Generador de la métrica 3
     const static int N = 5;          ///< Profundidad máxima a explorar
 
     /// Ver documentación adjunta: memoria.pdf
     int metrica1();
     int metrica2();
     int metrica3();
-    int metrica4();
 
     /**
-     * @brief Amplía el espacio de soluciones hasta una profundidad
-     * dada.
-     * @param profundidad Profundidad hasta la que se explora
+     * @brief Elige la columna con un motor y anota sus nodos, podas y
+     * profundidad.
+     * @param m Motor con el que se elige
+     */
+    int elegirConMotor(Motor& m);
+
+    /**
+     * @brief Devuelve las estrategias registradas, empezando por las propias.
+     * @note Se crean la primera vez que se llama.
+     */
+    static vector<Estrategia>& registro();
+
+    /**
+     * @brief Indica si la métrica del jugador explora el ArbolGeneral.
+     */
+    bool usaArbol() const { return estrategia.profundidad > 0; }
+
+    /**
+     * @brief Amplía el espacio de soluciones expandiendo las hojas de la
+     * frontera un número de niveles dado.
+     * @param profundidad Número de niveles que se añaden
+     * @post La frontera contiene las hojas del último nivel creado que no
+     * terminan la partida.
      */
     void generarArbolSoluciones(int profundidad);
 
+    /**
+     * @brief Expande en este hilo unas hojas un número de niveles dado,
+     * puntuando los nodos nuevos.
+     * @param hojas Hojas (al mismo nivel) que se expanden. Al acabar, las del
+     * último nivel creado que no terminan la partida.
+     * @param profundidad Número de niveles que se añaden
+     * @param tope Antecesor común de las hojas hasta el que se suman los
+     * puntos (nulo para sumarlos hasta la raíz)
+     * @param expandidos Se suman los nodos expandidos en cada nivel
+     * @param creados Se suman los nodos creados en cada nivel
+     * @note Sólo modifica el subárbol de @e tope, así que puede llamarse a la
+     * vez desde varios hilos con topes distintos que no cuelgan unos de otros.
+     */
+    void ampliarHojas(vector<ArbolGeneral<Solucion>::Nodo>& hojas, int profundidad,
+                      ArbolGeneral<Solucion>::Nodo tope, vector<long>& expandidos,
+                      vector<long>& creados);
+
+    /**
+     * @brief Quita de la frontera las hojas que no cuelgan de un hijo dado
+     * de la raíz, que dejarán de estar en el árbol al cambiar de raíz.
+     * @param n Hijo de la raíz que pasará a ser la nueva raíz
+     */
+    void podarFrontera(ArbolGeneral<Solucion>::Nodo n);
+
     /**
      * @brief Actualiza el espacio de soluciones de la partida
      * @param tablero Tablero actual
      */
     void actualizarSoluciones(const Tablero& tablero);
 
+    /**
+     * @brief Calcula los puntos de los nodos [desde, hasta) de un nivel
+     * recién creado, sin contar sus descendientes (que aún no tienen).
+     * @tparam Puntos Sistema de puntos de la métrica: Puntos::ALINEADAS indica
+     * si se cuentan las alineaciones de la última ficha del nodo y Puntos::sumar(sol) añade
+     * a la puntuación básica los puntos propios de la métrica. Se resuelve al
+     * compilar, así que puntuar un nodo no pregunta por la métrica.
+     * @param nodos Nodos del nivel
+     * @note Sólo modifica las etiquetas de esos nodos, así que puede llamarse
+     * a la vez desde varios hilos con rangos distintos.
+     */
+    template <class Puntos>
+    void puntuarNodos(const vector<ArbolGeneral<Solucion>::Nodo>& nodos,
+                      size_t desde, size_t hasta);
+
+    /**
+     * @brief Suma a los antecesores de un nodo los puntos de sus hijos
+     * recién creados.
+     * @param n Nodo que se acaba de expandir.
+     * @param tope Último antecesor al que se suman (nulo para llegar a la
+     * raíz)
+     */
+    void propagarPuntuacion(ArbolGeneral<Solucion>::Nodo n,
+                            ArbolGeneral<Solucion>::Nodo tope = 0);
+
+    /**
+     * @brief Suma a los antecesores de un nodo (sin contarlo) lo que ha
+     * recibido ese nodo de propagarPuntuacion.
+     * @param n Nodo
+     * @param suma Lo que ha aumentado la suma de n
+     * @param pendiente Lo que ha aumentado la pendiente de n
+     */
+    void sumarAntecesores(ArbolGeneral<Solucion>::Nodo n, int64_t suma, int64_t pendiente);
+
     /**
      * @brief Calcula los puntos de un nodo según el sistema de
      * puntos de la métrica del jugador automático.
      * @param n Nodo donde mirar.
      * @param lvl Nivel del nodo actual en el árbol.
      * @return Puntuación total obtenida por el jugador auto en el subárbol que
-     * cuelga de n.
+     * cuelga de n, en unidades de 1/UNIDAD. Se calcula a partir de los datos
+     * guardados en el nodo, sin recorrer el subárbol.
      */
-    int calcularPuntuacion(ArbolGeneral<Tablero>::Nodo n, int lvl);
+    int64_t calcularPuntuacion(ArbolGeneral<Solucion>::Nodo n, int lvl) const;
 
     /**
      * @brief Comprueba si el jugador automático puede ganar la partida
@@ -72,46 +297,177 @@ class JugadorAuto
      * @return Un vector de Nodo, con los nodos donde el jugador automático
      * puede insertar ficha sin miedo a perder en el siguiente turno.
      */
-    vector<ArbolGeneral<Tablero>::Nodo> evita_perder();
+    vector<ArbolGeneral<Solucion>::Nodo> evita_perder();
+
+    /**
+     * @brief Quita de las posibilidades las jugadas tras las que alguna
+     * respuesta del rival alinea fichas. Si todas lo permiten, no quita
+     * ninguna.
+     * @param posibilidades Nodos hijos de la raíz entre los que elegir
+     * @param alineadas Alineaciones del rival que se miran (alineadas3 o
+     * alineadas2)
+     */
+    void descartarSiAlinea(vector<ArbolGeneral<Solucion>::Nodo>& posibilidades,
+                           int8_t Solucion::*alineadas);
 
     /**
      * @brief Computa la columna donde se obtendría una mayor puntuación
-     * al insertar.
+     * al insertar. Sólo lee la puntuación guardada en cada nodo, así que se
+     * hace en un hilo.
      * @param v Vector de Nodo con los nodos donde buscar
-     * @see calcularPartidasGanadas
+     * @see calcularPuntuacion
+     */
+    int mayorPuntuacion(vector<ArbolGeneral<Solucion>::Nodo> v);
+
+    /**
+     * @brief Empieza a pensar en segundo plano la siguiente jugada, sobre el
+     * tablero que resulta si el rival responde lo que espera la búsqueda.
      */
-    int mayorPuntuacion(vector<ArbolGeneral<Tablero>::Nodo> v);
+    void anticiparRespuesta();
+
+    JugadorAuto(const JugadorAuto&);              // No se puede copiar: la
+    JugadorAuto& operator=(const JugadorAuto&);   // frontera apunta al árbol
 
   public:
     /**
      * @brief Constructor por defecto. Crea un árbol vacío,
      * con la métrica por defecto
      */
-    JugadorAuto() : metrica(1) { }
+    JugadorAuto();
 
     /**
      * @brief Construye un jugador automático, a partir de un tablero inicial
-     * y una métrica dados. Genera el árbol de soluciones.
+     * y una métrica dados. El árbol de soluciones se genera al elegir la
+     * primera jugada que no está en el libro.
      * @param inicial Tablero inicial de la partida
-     * @param metrica Número de métrica elegida (por defecto la mejor)
+     * @param metrica Número de métrica elegida (por defecto la mejor). Si no
+     * está registrada se usa la 1.
+     * @param params Parámetros del motor de búsqueda (métrica 5), número de
+     * hilos, libro de aperturas, casillas libres a partir de las que se
+     * resuelve el final, fichero de estadísticas, si se piensa en el turno
+     * del rival y semilla de las métricas que juegan al azar. Si el libro no
+     * existe o es de otro tamaño de tablero, se juega sin él.
+     * @param lazy_smp Si la búsqueda de la métrica 5 reparte el trabajo entre
+     * params.hilos hilos con Lazy SMP. Si no, usa uno solo.
+     * @pre La estrategia admite el tamaño del tablero (ver Estrategia::cabe):
+     * para las que usan el árbol (1 a 3), cabe en una Posicion.
+     */
+    JugadorAuto(const Tablero& inicial, int num_metrica = 1,
+                const ParametrosBusqueda& params = ParametrosBusqueda(),
+                bool lazy_smp = false);
+
+    /**
+     * @brief Registra una estrategia nueva, que pasan a poder usar los
+     * jugadores que se construyan después.
+     * @param e Estrategia. Si no usa el árbol (profundidad 0) debe tener
+     * la función crear.
+     * @return false si ya hay una con el mismo nombre o número, o si no es
+     * válida.
+     * @note No se debe llamar a la vez que se construyen jugadores en otros
+     * hilos: lo normal es registrar al empezar el programa.
+     */
+    static bool registrar(const Estrategia& e);
+
+    /**
+     * @brief Busca una estrategia registrada por su número.
+     * @param numero Número de métrica
+     * @param e Recibe la estrategia, si la hay
+     * @return Si está registrada
+     */
+    static bool buscarEstrategia(int numero, Estrategia& e);
+
+    /**
+     * @brief Busca una estrategia registrada por su nombre o por su número
+     * escrito como texto (p.ej. "alfabeta" o "5").
+     */
+    static bool buscarEstrategia(const string& nombre, Estrategia& e);
+
+    /**
+     * @brief Muestra una línea por estrategia registrada, con su número, su
+     * nombre y su descripción (para la ayuda de los programas).
+     * @param os Flujo de salida
+     * @param sangria Texto con el que empieza cada línea
+     */
+    static void mostrarEstrategias(ostream& os, const string& sangria = "");
+
+    /**
+     * @brief Devuelve la estrategia del jugador.
      */
-    JugadorAuto(const Tablero& inicial, int num_metrica = 1);
+    const Estrategia& GetEstrategia() const { return estrategia; }
+
+    /**
+     * @brief Crea el árbol de soluciones desde el tablero actual, para el
+     * jugador al que le toca mover en él. Si ya había uno, se descarta.
+     * @note elegirMovimiento lo llama la primera vez que lo necesita; hacerlo
+     * antes sólo adelanta el trabajo (o permite medirlo por separado).
+     */
+    void construirArbol();
+
+    /**
+     * @brief Devuelve las estadísticas de las jugadas hechas. Sólo tienen
+     * datos si Estadisticas::ACTIVAS.
+     */
+    const Estadisticas& GetEstadisticas() const { return estadisticas; }
+
+    /**
+     * @brief Devuelve el motor del jugador, o nulo si su estrategia usa el
+     * árbol de soluciones.
+     */
+    const Motor *GetMotor() const { return motor.get(); }
+
+    /**
+     * @brief Devuelve cuántos nodos ha creado o visitado el jugador en todas
+     * sus jugadas: los del árbol de soluciones, los de su motor y los del
+     * resolvedor de finales.
+     */
+    long GetNodos() const { return nodos + resolvedor.GetNodos(); }
 
     /**
      * @brief Devuelve el árbol que representa el espacio de soluciones.
      */
-    ArbolGeneral<Tablero> getArbol() { return partida; }
+    ArbolGeneral<Solucion> getArbol() { return partida; }
+
+    /**
+     * @brief Comprueba que la frontera contiene exactamente las hojas del
+     * árbol que no terminan la partida, todas al mismo nivel, recorriendo el
+     * árbol entero (para las pruebas).
+     * @return Si la frontera es correcta. Sin árbol, si está vacía.
+     */
+    bool comprobarFrontera() const;
+
+    /**
+     * @brief Comprueba que la puntuación guardada en cada nodo del árbol es
+     * la que se obtiene volviendo a puntuar todos los nodos y sumando el
+     * subárbol entero, como hacía calcularPuntuacion antes de guardarla
+     * (pero sin redondear cada suma). No mira la raíz, que no se puntúa.
+     * Deja el árbol como estaba (para las pruebas).
+     * @return Si todas coinciden. Sin árbol, true.
+     */
+    bool comprobarPuntuaciones();
 
     /**
      * @brief Simula un movimiento del jugador automático según
      * la métrica escogida. Es útil si queremos conocer la columna donde
      * insertaría el jugador, sin necesidad de realizar la inserción.
      * @param num_metrica Métrica elegida (0 significa la métrica asociada al jugador
-     * automático)
+     * automático). Si es otra que usa un motor, se crea uno para esta jugada;
+     * si usa el árbol, los nodos se puntúan como en la métrica del jugador
+     * (o como en la pedida, si el jugador no usa el árbol).
      * @return Columna donde se insertaría la ficha del jugador automático
      */
     int elegirMovimiento(int num_metrica = 0);
 
+    /**
+     * @brief Detiene lo que piense el motor en segundo plano, si lo hay. Hay
+     * que llamarlo antes de consultar GetMotor() si se piensa en el turno
+     * del rival.
+     */
+    void dejarDePensar()
+    {
+      if (motor)
+        motor->dejarDePensar();
+    }
+
     /**
      * @brief Procesa un turno del jugador automático.
      * @param actual Tablero actual de la partida
@@ -0,0 +1,126 @@
+/**
+ * @file libro_aperturas.h
+ * @brief Fichero de cabecera para el TDA LibroAperturas
+ *
+ */
+
+#ifndef __LIBRO_APERTURAS_H__
+#define __LIBRO_APERTURAS_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "tablero.h"
+
+using namespace std;
+
+/**
+ * @brief T.D.A. LibroAperturas
+ *
+ * Una instancia @e l del T.D.A. LibroAperturas da la mejor columna de las
+ * posiciones del principio de la partida, calculadas de antemano (con la
+ * herramienta generar_libro, ver make libro) y guardadas en un fichero.
+ *
+ * El fichero empieza con una Cabecera con el tamaño del tablero, seguida de
+ * las entradas (clave Zobrist del tablero, columna) ordenadas por clave. Al
+ * abrirlo se proyecta en memoria con mmap, sin leerlo entero, y cada consulta
+ * es una búsqueda binaria sobre las entradas. Como la clave Zobrist es la
+ * misma entre ejecuciones, el fichero sirve para cualquier partida con ese
+ * tamaño de tablero.
+ */
+class LibroAperturas
+{
+  public:
+    /**
+     * @brief Cabecera del fichero del libro.
+     */
+    struct Cabecera
+    {
+      char firma[8];          ///< FIRMA, para reconocer el fichero
+      int32_t filas;          ///< Filas del tablero
+      int32_t columnas;       ///< Columnas del tablero
+      int32_t fichas;         ///< Posiciones de hasta fichas - 1 fichas
+      int32_t profundidad;    ///< Profundidad con la que se buscaron
+      uint64_t num_entradas;  ///< Número de entradas que siguen
+    };
+
+    /**
+     * @brief Entrada del libro: la mejor columna de una posición.
+     */
+    struct Entrada
+    {
+      uint64_t clave;         ///< Clave Zobrist del tablero
+      int32_t columna;        ///< Mejor columna
+      int32_t reservado;      ///< Relleno, a 0
+    };
+
+    /// Firma de los ficheros de libro
+    static const char FIRMA[8];
+
+  private:
+    void *memoria;            ///< Fichero proyectado (0 si no hay)
+    size_t bytes;             ///< Tamaño del fichero proyectado
+    const Cabecera *cabecera; ///< Cabecera dentro de memoria
+    const Entrada *entradas;  ///< Entradas dentro de memoria
+
+    LibroAperturas(const LibroAperturas&);            // No se puede copiar
+    LibroAperturas& operator=(const LibroAperturas&);
+
+  public:
+    /**
+     * @brief Constructor por defecto. Crea un libro cerrado, sin entradas.
+     */
+    LibroAperturas();
+
+    /**
+     * @brief Destructor. Cierra el libro.
+     */
+    ~LibroAperturas();
+
+    /**
+     * @brief Proyecta en memoria un fichero de libro.
+     * @param fichero Ruta del fichero
+     * @param filas Filas del tablero de la partida
+     * @param columnas Columnas del tablero de la partida
+     * @return true si se ha abierto; false si no existe, no es un libro o es
+     * de otro tamaño de tablero (y el libro queda cerrado).
+     */
+    bool abrir(const string& fichero, int filas, int columnas);
+
+    /**
+     * @brief Cierra el libro y libera la proyección.
+     */
+    void cerrar();
+
+    /**
+     * @brief Indica si hay un libro abierto.
+     */
+    bool abierto() const { return memoria != 0; }
+
+    /**
+     * @brief Devuelve el número de entradas del libro.
+     */
+    size_t size() const { return abierto() ? cabecera->num_entradas : 0; }
+
+    /**
+     * @brief Busca la mejor columna de un tablero.
+     * @param t Tablero de la partida
+     * @return Columna guardada en el libro, o -1 si la posición no está (o
+     * la columna está llena).
+     */
+    int buscar(const Tablero& t) const;
+
+    /**
+     * @brief Escribe un fichero de libro.
+     * @param fichero Ruta del fichero
+     * @param c Cabecera. Su firma y su número de entradas se rellenan aquí.
+     * @param e Entradas, con claves distintas. Se ordenan por clave.
+     * @return true si se ha escrito el fichero.
+     */
+    static bool escribir(const string& fichero, Cabecera c, vector<Entrada>& e);
+};
+
+#endif
+
+/* Fin fichero: libro_aperturas.h */
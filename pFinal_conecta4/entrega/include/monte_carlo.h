@@ -0,0 +1,361 @@
+/**
+ * @file monte_carlo.h
+ * @brief Fichero de cabecera para el TDA MonteCarlo
+ *
+ */
+
+#ifndef __MONTE_CARLO_H__
+#define __MONTE_CARLO_H__
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "aleatorio.h"
+#include "busqueda.h"
+#include "grupo_hilos.h"
+#include "motor.h"
+#include "tablero.h"
+
+using namespace std;
+
+/**
+ * @brief T.D.A. MonteCarlo
+ *
+ * Una instancia @e m del T.D.A. MonteCarlo es un motor de búsqueda de Monte
+ * Carlo en árbol (MCTS) con UCT para el Conecta-4. En lugar de explorar todas
+ * las jugadas hasta una profundidad, como el árbol de soluciones del
+ * JugadorAuto o la Busqueda alfa-beta, repite muchas simulaciones:
+ * - Selección: desde la raíz baja por el árbol eligiendo en cada nodo el hijo
+ *   con mayor cota UCT, que suma a la media de puntos del hijo un término de
+ *   exploración que crece con las visitas del padre y baja con las del hijo.
+ * - Expansión: al llegar por segunda vez a una hoja se crean todos sus hijos.
+ * - Partida simulada: desde la hoja se juega hasta el final al azar, pero
+ *   ganando si se puede, tapando la victoria inmediata del rival y sin poner
+ *   ficha bajo una casilla en la que gana el rival.
+ * - Propagación: el resultado (2 medios puntos la victoria, 1 el empate) se
+ *   suma a los nodos del camino, visto desde el jugador que movió en cada uno.
+ * Al final se juega la columna del hijo de la raíz más visitado. Así, la
+ * fuerza del motor depende del número de simulaciones (o del tiempo por
+ * jugada) y no del tamaño del tablero.
+ *
+ * Las partidas simuladas se juegan sobre un bitboard propio de 128 bits, con
+ * una fila más por columna para que las líneas no pasen de una columna a la
+ * siguiente, así que el motor sirve para tableros de hasta 128 casillas con
+ * esa fila de más (ver cabe()): hasta 10x11, por ejemplo.
+ *
+ * Los nodos se guardan en un vector reservado al crear el motor, con los
+ * hijos de cada nodo seguidos. Tras cada jugada se conserva el subárbol de la
+ * posición a la que se llega, copiándolo al principio del vector, de modo
+ * que lo simulado en la jugada anterior (o pensando en el turno del rival) se
+ * aprovecha. Si el vector se llena, se deja de expandir hasta la jugada
+ * siguiente.
+ *
+ * Con más de un hilo, todos simulan a la vez sobre el mismo árbol. Al bajar
+ * por un nodo se cuenta ya su visita, con 0 puntos (pérdida virtual), y los
+ * puntos se suman al acabar la simulación: así los demás hilos ven ese camino
+ * peor mientras tanto y reparten las simulaciones por el árbol. Los campos
+ * de los nodos se leen y escriben con operaciones atómicas.
+ *
+ * Cada hilo tiene su propio generador Aleatorio, un flujo distinto de
+ * params.semilla. Con una semilla fija, un solo hilo y un número fijo de
+ * simulaciones (sin límite de tiempo), las jugadas se repiten exactamente.
+ *
+ * Es el Motor de la métrica 6 del JugadorAuto.
+ */
+class MonteCarlo : public Motor
+{
+  public:
+    /// Bits del bitboard de las partidas simuladas
+    typedef unsigned __int128 Bits;
+
+    /// Constante de exploración de la cota UCT
+    static const double EXPLORACION;
+
+  private:
+    /**
+     * @brief Final de la partida en un nodo.
+     */
+    enum Fin
+    {
+      SIGUE,      ///< La partida sigue
+      GANA,       ///< Gana el jugador que movió hasta el nodo
+      EMPATE      ///< Tablero lleno sin ganador
+    };
+
+    /**
+     * @brief Estado de expansión de un nodo.
+     */
+    enum Estado
+    {
+      HOJA,       ///< Sin hijos
+      EXPANDIENDO,///< Un hilo está creando sus hijos
+      EXPANDIDO   ///< Tiene hijos
+    };
+
+    /**
+     * @brief Nodo del árbol de búsqueda.
+     */
+    struct Nodo
+    {
+      int32_t visitas;      ///< Simulaciones que han pasado por el nodo
+      int32_t puntos;       ///< Medios puntos del jugador que movió hasta él
+      int32_t primer_hijo;  ///< Posición del primer hijo en el vector
+      uint8_t num_hijos;    ///< Número de hijos (seguidos en el vector)
+      uint8_t columna;      ///< Columna de la jugada que lleva al nodo
+      uint8_t estado;       ///< Estado de expansión (ver Estado)
+      uint8_t fin;          ///< Final de la partida en el nodo (ver Fin)
+    };
+
+    /**
+     * @brief Posición de una partida simulada: fichas del jugador al que le
+     * toca mover y casillas ocupadas. La casilla (fila i desde abajo,
+     * columna j) es el bit j * (filas + 1) + i.
+     */
+    struct PosicionBits
+    {
+      Bits propias;         ///< Fichas del jugador al que le toca mover
+      Bits ocupadas;        ///< Casillas ocupadas
+      int fichas;           ///< Fichas colocadas
+    };
+
+    /**
+     * @brief Estado propio de cada hilo.
+     */
+    struct Hilo
+    {
+      Aleatorio aleatorio;  ///< Generador de las simulaciones del hilo
+      long simulaciones;    ///< Simulaciones de la jugada actual
+      long simulaciones_total;  ///< Simulaciones de todas las jugadas
+      int profundidad;      ///< Nivel más hondo alcanzado en la jugada actual
+      vector<int32_t> camino;   ///< Nodos de la simulación en curso
+
+      Hilo() : simulaciones(0), simulaciones_total(0),
+               profundidad(0) { }
+    };
+
+    ParametrosBusqueda params;   ///< Parámetros del motor
+    int filas;                   ///< Filas del tablero
+    int columnas;                ///< Columnas del tablero
+    int fichas_ganar;            ///< Fichas en línea para ganar
+    int alto;                    ///< Bits por columna (filas + 1)
+    Bits abajo;                  ///< Casilla inferior de cada columna
+    Bits casillas;               ///< Todas las casillas del tablero
+
+    vector<Nodo> nodos;          ///< Árbol; el nodo 0 es la raíz
+    int32_t usados;              ///< Nodos en uso del vector
+    PosicionBits raiz;           ///< Posición de la raíz
+    bool hay_arbol;              ///< El árbol corresponde a una partida en curso
+
+    shared_ptr<GrupoHilos> grupo;  ///< Hilos que simulan (nulo con uno)
+    vector<Hilo> hilos;          ///< Estado de cada hilo
+    long pedidas;                ///< Simulaciones repartidas en la jugada actual
+    bool con_limite;             ///< Hay límite de tiempo
+    bool parar;                  ///< Los hilos deben terminar
+    chrono::steady_clock::time_point limite;  ///< Instante en que se agota el tiempo
+    double segundos_total;       ///< Tiempo total de todas las jugadas
+    int respuesta_esperada;      ///< Respuesta más visitada del rival
+    int ultima_columna;          ///< Columna elegida en la última jugada
+    double valor;                ///< Valor de la jugada elegida (ver GetValor)
+
+    unique_ptr<thread> pensador; ///< Hilo que piensa en el turno del rival (o nulo)
+
+    /**
+     * @brief Convierte un Tablero en la posición de una partida simulada.
+     */
+    PosicionBits aPosicion(const Tablero& t) const;
+
+    /**
+     * @brief Devuelve la posición tras jugar en una columna.
+     * @pre La columna no está llena
+     */
+    PosicionBits jugar(const PosicionBits& p, int col) const;
+
+    /**
+     * @brief Devuelve las casillas del tablero en las que un jugador
+     * completaría una línea, estén libres o no.
+     * @param b Fichas del jugador
+     */
+    Bits ganadoras(Bits b) const;
+
+    /**
+     * @brief Devuelve las casillas de una columna.
+     */
+    Bits columna(int col) const
+    {
+      return ((((Bits) 1) << filas) - 1) << (col * alto);
+    }
+
+    /**
+     * @brief Devuelve las casillas en las que se puede poner ficha.
+     */
+    Bits jugables(const PosicionBits& p) const
+    {
+      return (p.ocupadas + abajo) & casillas;
+    }
+
+    /**
+     * @brief Juega una partida simulada desde una posición.
+     * @param h Estado del hilo (su generador aleatorio)
+     * @param p Posición de partida
+     * @return Medios puntos del jugador que movió hasta p (2 si gana, 1 si
+     * empata, 0 si pierde).
+     */
+    int simular(Hilo& h, PosicionBits p) const;
+
+    /**
+     * @brief Crea los hijos de un nodo, si queda sitio en el vector.
+     * @param n Nodo que expandir, en estado EXPANDIENDO
+     * @param p Posición del nodo
+     * @return Si se han creado
+     */
+    bool expandir(int32_t n, const PosicionBits& p);
+
+    /**
+     * @brief Elige el hijo de un nodo con mayor cota UCT.
+     * @pre El nodo está expandido
+     */
+    int32_t elegirHijo(int32_t n) const;
+
+    /**
+     * @brief Hace una simulación completa: selección, expansión, partida
+     * simulada y propagación.
+     * @param h Estado del hilo que simula
+     */
+    void simulacion(Hilo& h);
+
+    /**
+     * @brief Simula desde la raíz con todos los hilos hasta agotar el tiempo,
+     * hacer las simulaciones pedidas o que se pida parar.
+     * @param inicio Instante en que empezó la jugada
+     */
+    void buscar(chrono::steady_clock::time_point inicio);
+
+    /**
+     * @brief Indica si dos posiciones son la misma.
+     */
+    static bool iguales(const PosicionBits& a, const PosicionBits& b)
+    {
+      return a.propias == b.propias && a.ocupadas == b.ocupadas;
+    }
+
+    /**
+     * @brief Deja una posición como raíz. Si es la raíz actual o está en
+     * los dos primeros niveles bajo ella, conserva su subárbol; si no,
+     * empieza un árbol nuevo.
+     */
+    void cambiarRaiz(const PosicionBits& p);
+
+    /**
+     * @brief Copia el subárbol de un nodo al principio del vector, con el
+     * nodo como raíz, y libera el resto.
+     */
+    void compactar(int32_t n);
+
+    /**
+     * @brief Simula con un hilo hasta que se acabe la jugada.
+     * @param h Estado del hilo
+     */
+    void bucle(Hilo& h);
+
+    /**
+     * @brief Devuelve el hijo más visitado de un nodo, o -1 si no tiene. Si
+     * alguno gana la partida, ése.
+     */
+    int32_t masVisitado(int32_t n) const;
+
+    MonteCarlo(const MonteCarlo&);              // No se puede copiar
+    MonteCarlo& operator=(const MonteCarlo&);
+
+  public:
+    /**
+     * @brief Constructor.
+     * @param inicial Tablero de la partida (sólo se usa su tamaño)
+     * @param params Parámetros del motor: memoria del árbol (memoria_tt),
+     * simulaciones por jugada si no hay límite de tiempo, tiempo por jugada e
+     * hilos
+     * @pre cabe(inicial.GetFilas(), inicial.GetColumnas())
+     */
+    MonteCarlo(const Tablero& inicial, const ParametrosBusqueda& params);
+
+    /**
+     * @brief Destructor. Si está pensando, se detiene.
+     */
+    ~MonteCarlo();
+
+    /**
+     * @brief Indica si un tablero de ese tamaño cabe en el bitboard de las
+     * partidas simuladas.
+     */
+    static bool cabe(int filas, int columnas)
+    {
+      return filas > 0 && columnas > 0 && columnas < 256
+             && (filas + 1) * columnas <= 128;
+    }
+
+    /**
+     * @brief Elige la columna del jugador al que le toca mover.
+     * @param t Tablero actual de la partida
+     * @pre El tablero no está lleno y nadie ha ganado todavía
+     * @return Columna elegida
+     */
+    int mejorMovimiento(const Tablero& t);
+
+    /**
+     * @brief Empieza a simular en segundo plano, hasta que se llame a
+     * dejarDePensar() o a mejorMovimiento(). Si el tablero cuelga de la
+     * jugada que acaba de hacer el motor, se simula desde esa jugada, de
+     * modo que se aprovecha responda lo que responda el rival.
+     * @param t Tablero que se espera tener en el siguiente turno
+     */
+    void pensar(const Tablero& t);
+
+    /**
+     * @brief Detiene la simulación en segundo plano, si la hay, y espera a
+     * que termine.
+     */
+    void dejarDePensar();
+
+    /**
+     * @brief Devuelve las simulaciones de la última jugada.
+     */
+    long GetNodos() const;
+
+    /**
+     * @brief Devuelve las simulaciones que han pasado por la raíz del árbol,
+     * contando las que se conservan de jugadas anteriores (o de pensar en el
+     * turno del rival).
+     */
+    long GetVisitasRaiz() const { return hay_arbol ? nodos[0].visitas : 0; }
+
+    /**
+     * @brief Devuelve el nivel más hondo del árbol al que se llegó en la
+     * última jugada.
+     */
+    int GetProfundidad() const;
+
+    /**
+     * @brief Devuelve la respuesta del rival más visitada tras la última
+     * jugada, o -1 si no hay.
+     */
+    int GetRespuestaEsperada() const { return respuesta_esperada; }
+
+    /**
+     * @brief Devuelve la media de puntos de la jugada elegida, pasada a
+     * [-1, 1] (1 si gana seguro).
+     */
+    double GetValor() const { return valor; }
+
+    /**
+     * @brief Muestra las simulaciones por segundo de cada hilo, acumuladas
+     * en todas las jugadas, y los nodos del árbol.
+     * @param os Flujo de salida
+     */
+    void mostrarRendimiento(ostream& os) const;
+};
+
+#endif
+
+/* Fin fichero: monte_carlo.h */
@@ -0,0 +1,101 @@
+/**
+ * @file motor.h
+ * @brief Fichero de cabecera para el TDA Motor
+ *
+ */
+
+#ifndef __MOTOR_H__
+#define __MOTOR_H__
+
+#include <iosfwd>
+#include "tablero.h"
+
+using namespace std;
+
+/**
+ * @brief T.D.A. Motor
+ *
+ * Interfaz de los motores de juego que eligen la jugada por su cuenta, sin
+ * el árbol de soluciones del JugadorAuto: la búsqueda alfa-beta, la métrica
+ * aleatoria, etc. Cada jugador automático crea su propio motor al
+ * construirse (ver JugadorAuto::Estrategia) y lo conserva durante toda la
+ * partida, así que el motor puede guardar lo que ha aprendido de una jugada
+ * para la siguiente.
+ *
+ * Sólo mejorMovimiento y GetNodos son obligatorias; el resto tienen una
+ * versión por defecto para los motores que no piensan en el turno del rival
+ * ni dan más datos.
+ */
+class Motor
+{
+  public:
+    /**
+     * @brief Destructor.
+     */
+    virtual ~Motor() { }
+
+    /**
+     * @brief Elige la columna en la que juega el jugador al que le toca mover.
+     * @param t Tablero actual de la partida
+     * @pre El tablero no está lleno y nadie ha ganado todavía
+     */
+    virtual int mejorMovimiento(const Tablero& t) = 0;
+
+    /**
+     * @brief Devuelve los nodos visitados en la última jugada.
+     */
+    virtual long GetNodos() const = 0;
+
+    /**
+     * @brief Devuelve las podas hechas en todas las jugadas (0 si el motor no
+     * poda).
+     * @param primera Si no es nulo, recibe cuántas de ellas provocó la
+     * primera jugada probada.
+     */
+    virtual long GetCortes(long *primera = 0) const
+    {
+      if (primera)
+        *primera = 0;
+      return 0;
+    }
+
+    /**
+     * @brief Devuelve la profundidad a la que llegó la última jugada.
+     */
+    virtual int GetProfundidad() const { return 0; }
+
+    /**
+     * @brief Devuelve la columna con la que el motor espera que responda el
+     * rival a su última jugada, o -1 si no lo sabe.
+     */
+    virtual int GetRespuestaEsperada() const { return -1; }
+
+    /**
+     * @brief Devuelve cómo ve el motor la posición de su última jugada, desde
+     * el punto de vista del jugador que movía: 1 si gana seguro, -1 si
+     * pierde seguro y un valor intermedio si no está decidida (0 si el motor
+     * no sabe valorarla).
+     */
+    virtual double GetValor() const { return 0; }
+
+    /**
+     * @brief Empieza a pensar en segundo plano la jugada del tablero que se
+     * espera tener en el siguiente turno. Por defecto no hace nada.
+     */
+    virtual void pensar(const Tablero& t) { (void) t; }
+
+    /**
+     * @brief Detiene lo que se esté pensando en segundo plano.
+     */
+    virtual void dejarDePensar() { }
+
+    /**
+     * @brief Muestra las medidas de rendimiento del motor. Por defecto no
+     * muestra nada.
+     */
+    virtual void mostrarRendimiento(ostream& os) const { (void) os; }
+};
+
+#endif
+
+/* Fin fichero: motor.h */
@@ -0,0 +1,110 @@
+/**
+ * @file partida.h
+ * @brief Fichero de cabecera para el TDA Partida
+ *
+ */
+
+#ifndef __PARTIDA_H__
+#define __PARTIDA_H__
+
+#include <iostream>
+#include <vector>
+#include "tablero.h"
+
+using namespace std;
+
+/**
+ * @brief T.D.A. Partida
+ *
+ * Una instancia @e p del T.D.A. Partida es el registro de una partida de
+ * Conecta-4: el tamaño del tablero, las fichas en línea para ganar, el
+ * jugador que empezó y las columnas (desde 0) de las jugadas hechas, en
+ * orden. A partir de él se puede reconstruir el tablero después de
+ * cualquier jugada.
+ *
+ * Se escribe en una sola línea de texto, que es el formato de los ficheros
+ * de partidas (ver conecta4 -d, torneo -d y analizar):
+ *
+ * <tt>filas columnas fichas_ganar primero : jugada1 jugada2 ...</tt>
+ *
+ * por ejemplo <tt>6 7 4 1 : 3 3 4 2 5</tt>. Al leer, se ignoran las líneas
+ * vacías y las que empiezan por #, y se comprueba que todas las jugadas se
+ * pueden hacer y que ninguna sigue a una partida ya acabada.
+ */
+class Partida
+{
+  private:
+    int filas;              ///< Filas del tablero
+    int columnas;           ///< Columnas del tablero
+    int fichas_ganar;       ///< Fichas en línea para ganar
+    int primero;            ///< Jugador (1 o 2) que hizo la primera jugada
+    vector<int> jugadas;    ///< Columna de cada jugada
+
+  public:
+    /// Filas y columnas máximas de una partida leída de un fichero
+    const static int MAX_LADO = 255;
+
+    /**
+     * @brief Constructor por defecto. Crea una partida vacía en un tablero
+     * de tamaño predefinido.
+     */
+    Partida();
+
+    /**
+     * @brief Constructor. Crea una partida sin jugadas que empieza en un
+     * tablero.
+     * @param inicial Tablero inicial, del que se toman el tamaño, las fichas
+     * para ganar y el jugador que empieza
+     * @pre El tablero está vacío
+     */
+    Partida(const Tablero& inicial);
+
+    /**
+     * @brief Añade una jugada a la partida.
+     * @param col Columna de la jugada
+     */
+    void anotar(int col) { jugadas.push_back(col); }
+
+    /**
+     * @brief Devuelve el número de jugadas.
+     */
+    size_t size() const { return jugadas.size(); }
+
+    /**
+     * @brief Devuelve la columna de la jugada i (desde 0).
+     */
+    int operator[](size_t i) const { return jugadas[i]; }
+
+    /**
+     * @brief Devuelve el tablero después de las n primeras jugadas.
+     * @pre n <= size()
+     */
+    Tablero tablero(size_t n) const;
+
+    /**
+     * @brief Devuelve el ganador de la partida (1 o 2), o 0 si ha acabado en
+     * empate o no ha acabado.
+     */
+    int GetGanador() const;
+
+    int GetFilas() const { return filas; }
+    int GetColumnas() const { return columnas; }
+    int GetFichasGanar() const { return fichas_ganar; }
+    int GetPrimero() const { return primero; }
+
+    /**
+     * @brief Escribe la partida en una línea (con su fin de línea).
+     */
+    friend ostream& operator<<(ostream& os, const Partida& p);
+
+    /**
+     * @brief Lee la siguiente partida, saltando las líneas vacías y los
+     * comentarios. Si la línea no es una partida correcta, activa el failbit
+     * del flujo (después de haberla consumido) y deja @e p sin cambios.
+     */
+    friend istream& operator>>(istream& is, Partida& p);
+};
+
+#endif
+
+/* Fin fichero: partida.h */
@@ -0,0 +1,165 @@
+/**
+ * @file posicion.h
+ * @brief Fichero de cabecera para el TDA Posicion
+ *
+ */
+
+#ifndef __POSICION_H__
+#define __POSICION_H__
+
+#include <cstdint>
+#include "tablero.h"
+
+using namespace std;
+
+/**
+ * @brief T.D.A. Posicion
+ *
+ * Una instancia @e p del T.D.A. Posicion es una copia compacta del estado de
+ * un Tablero: de tamaño fijo, sin memoria dinámica y copiable con memcpy. Es
+ * la etiqueta de los nodos del árbol de soluciones del JugadorAuto, que así
+ * ocupan una línea de caché en lugar de un Tablero completo.
+ *
+ * Las fichas de cada jugador se guardan como un conjunto de bits, una por
+ * casilla, por columnas y de abajo arriba (como los bitboards del Tablero):
+ * la casilla (i,j) es el bit j*filas + (filas-1-i). Además se guardan el
+ * turno, la última ficha colocada y si esa ficha ganó la partida, que se
+ * calcula una sola vez al crear la posición.
+ *
+ * Una Posicion sólo permite consultar el estado. Para jugar sobre ella hay
+ * que expandirla a un Tablero con aTablero().
+ */
+class Posicion
+{
+  public:
+    /// Número máximo de casillas del tablero
+    const static int MAX_CASILLAS = 128;
+
+  private:
+    const static int PALABRAS = MAX_CASILLAS / 64;  ///< Palabras por jugador
+
+    uint64_t fichas[2][PALABRAS];   ///< Casillas ocupadas por cada jugador
+    uint8_t filas;                  ///< Número de filas
+    uint8_t columnas;               ///< Número de columnas
+    uint8_t fichas_ganar;           ///< Fichas en línea necesarias para ganar
+    int8_t ult_col;                 ///< Columna de la última ficha (-1 si no hay)
+    int8_t ult_fila;                ///< Fila de la última ficha (-1 si no hay)
+    int8_t turno;                   ///< Jugador al que le toca mover
+    int8_t ganador;                 ///< Jugador al que dio la victoria la última ficha
+
+    /**
+     * @brief Bit que corresponde a la casilla (i,j).
+     */
+    int indice(int i, int j) const { return j * filas + (filas - 1 - i); }
+
+    /**
+     * @brief Comprueba si el jugador (0 ó 1) tiene ficha en el bit k.
+     */
+    bool tiene(int jugador, int k) const
+    {
+      return (fichas[jugador][k >> 6] >> (k & 63)) & 1;
+    }
+
+  public:
+    /**
+     * @brief Constructor por defecto. Crea la posición de un tablero 0x0.
+     */
+    Posicion();
+
+    /**
+     * @brief Constructor. Guarda el estado de un tablero.
+     * @param t Tablero a guardar
+     * @pre Posicion::cabe(t.GetFilas(), t.GetColumnas())
+     */
+    explicit Posicion(const Tablero& t);
+
+    /**
+     * @brief Indica si un tablero de ese tamaño cabe en una Posicion.
+     */
+    static bool cabe(int filas, int columnas)
+    {
+      return filas > 0 && columnas > 0 && filas * columnas <= MAX_CASILLAS;
+    }
+
+    /**
+     * @brief Expande la posición a un Tablero con el mismo estado.
+     */
+    Tablero aTablero() const;
+
+    /**
+     * @brief Devuelve el número de filas.
+     */
+    int GetFilas() const { return filas; }
+
+    /**
+     * @brief Devuelve el número de columnas.
+     */
+    int GetColumnas() const { return columnas; }
+
+    /**
+     * @brief Devuelve el número de fichas en línea necesarias para ganar.
+     */
+    int GetFichasGanar() const { return fichas_ganar; }
+
+    /**
+     * @brief Devuelve el contenido de la casilla (i,j): 0 si está vacía, o el
+     * jugador (1 ó 2) cuya ficha la ocupa.
+     */
+    int GetElemento(int i, int j) const
+    {
+      int k = indice(i, j);
+      return tiene(0, k) ? 1 : (tiene(1, k) ? 2 : 0);
+    }
+
+    /**
+     * @brief Devuelve la máscara con las fichas de un jugador, con la misma
+     * numeración que los bitboards del Tablero.
+     * @param jugador Jugador (1 ó 2)
+     * @pre GetFilas() * GetColumnas() <= 64
+     */
+    uint64_t GetMascara(int jugador) const { return fichas[jugador - 1][0]; }
+
+    /**
+     * @brief Devuelve la columna de la última ficha colocada (-1 si no hay).
+     */
+    int GetUltCol() const { return ult_col; }
+
+    /**
+     * @brief Devuelve la fila de la última ficha colocada (-1 si no hay).
+     */
+    int GetUltFila() const { return ult_fila; }
+
+    /**
+     * @brief Devuelve el jugador al que le toca mover.
+     */
+    int GetTurno() const { return turno; }
+
+    /**
+     * @brief Comprueba si no se ha colocado ninguna ficha (como
+     * Tablero::estaVacio).
+     */
+    bool estaVacio() const { return ult_col == -1; }
+
+    /**
+     * @brief Primera fila libre de una columna, como Tablero::hayHueco.
+     * @return Fila libre más baja, o -1 si la columna está llena o no existe.
+     */
+    int hayHueco(int pos) const;
+
+    /**
+     * @brief Comprueba si otra posición tiene el mismo estado de juego: el
+     * mismo tablero, las mismas fichas y el mismo turno (no mira la última
+     * ficha colocada).
+     */
+    bool mismoEstado(const Posicion& p) const;
+
+    /**
+     * @brief Jugador al que dio la victoria la última ficha colocada, como
+     * Tablero::quienGanaUltimo (0 si ninguno).
+     */
+    int quienGanaUltimo() const { return ganador; }
+};
+
+#endif
+
+/* Fin fichero: posicion.h */
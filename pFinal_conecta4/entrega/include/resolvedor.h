@@ -0,0 +1,92 @@
+/**
+ * @file resolvedor.h
+ * @brief Fichero de cabecera para el TDA Resolvedor
+ *
+ */
+
+#ifndef __RESOLVEDOR_H__
+#define __RESOLVEDOR_H__
+
+#include "tabla_transposicion.h"
+#include "tablero.h"
+
+using namespace std;
+
+/**
+ * @brief T.D.A. Resolvedor
+ *
+ * Una instancia @e r del T.D.A. Resolvedor resuelve de forma exacta los
+ * finales de partida: explora todas las jugadas hasta llenar el tablero y
+ * demuestra si el jugador al que le toca mover gana, empata o pierde con
+ * juego perfecto. Sólo es práctico cuando quedan pocas casillas libres.
+ *
+ * Como sólo hay tres resultados, la búsqueda es un negamax con ventana nula:
+ * para cada jugada se pregunta si mejora el mejor resultado conocido, en
+ * lugar de buscar su valor exacto. Los nodos ya resueltos se guardan en una
+ * TablaTransposicion propia. Además, el resultado de cada posición resuelta
+ * desde la raíz se guarda en una caché compartida por todos los
+ * resolvedores del programa, de modo que un final que se repite (por ejemplo
+ * en varias partidas seguidas) no se vuelve a buscar. La caché tiene un
+ * número fijo de entradas y guarda la posición de cada una, así que no crece
+ * y nunca devuelve el resultado de otra posición.
+ */
+class Resolvedor
+{
+  public:
+    /**
+     * @brief Resultado de una posición para el jugador al que le toca mover.
+     */
+    enum Resultado
+    {
+      PIERDE = -1,
+      EMPATA = 0,
+      GANA = 1
+    };
+
+  private:
+    TablaTransposicion tabla;   ///< Nodos ya resueltos
+    long nodos;                 ///< Nodos visitados en total
+
+    /**
+     * @brief Negamax con poda alfa-beta sobre el resultado.
+     * @param t Tablero actual. Se modifica durante la búsqueda, pero se
+     * devuelve en el mismo estado.
+     * @param alfa Cota inferior de la ventana de búsqueda
+     * @param beta Cota superior de la ventana de búsqueda
+     * @return Resultado del tablero para el jugador al que le toca mover
+     * (una cota si queda fuera de la ventana).
+     */
+    int negamax(Tablero& t, int alfa, int beta);
+
+  public:
+    /**
+     * @brief Constructor.
+     * @param megas Memoria (en MB) de la tabla de transposición. Con 0 no
+     * se guardan los nodos resueltos (sí las posiciones de la raíz).
+     */
+    Resolvedor(int megas = 0);
+
+    /**
+     * @brief Cuenta las casillas libres de un tablero.
+     */
+    static int casillasLibres(const Tablero& t);
+
+    /**
+     * @brief Resuelve un tablero.
+     * @param t Tablero de la partida
+     * @param columna Se deja en ella la mejor columna: una que gana si se
+     * puede ganar, si no una que empata, y si no una cualquiera.
+     * @pre El tablero no está lleno y nadie ha ganado todavía
+     * @return Resultado del tablero para el jugador al que le toca mover.
+     */
+    Resultado resolver(const Tablero& t, int& columna);
+
+    /**
+     * @brief Devuelve el número de nodos visitados en todas las búsquedas.
+     */
+    long GetNodos() const { return nodos; }
+};
+
+#endif
+
+/* Fin fichero: resolvedor.h */
@@ -0,0 +1,129 @@
+/**
+ * @file tabla_transposicion.h
+ * @brief Fichero de cabecera para el TDA TablaTransposicion
+ *
+ */
+
+#ifndef __TABLA_TRANSPOSICION_H__
+#define __TABLA_TRANSPOSICION_H__
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief T.D.A. TablaTransposicion
+ *
+ * Una instancia @e t del T.D.A. TablaTransposicion guarda los resultados de
+ * una búsqueda indexados por la clave Zobrist del tablero, de forma que una
+ * posición a la que se llega por distintos órdenes de jugadas sólo se evalúa
+ * una vez.
+ *
+ * La tabla tiene un número fijo de entradas (una potencia de dos), calculado a
+ * partir de la memoria que se le asigna. Cada clave va a una única entrada; si
+ * está ocupada por otra posición se reemplaza, y si es la misma posición sólo
+ * se reemplaza con una búsqueda al menos igual de profunda.
+ *
+ * La tabla puede compartirse entre varios hilos sin cerrojos. Cada celda
+ * guarda los datos y la clave combinada con ellos mediante XOR; si dos hilos
+ * escriben a la vez la misma celda y queda la clave de uno con los datos del
+ * otro, la combinación no coincide con ninguna de las dos claves y la celda
+ * se trata como vacía en lugar de devolver datos de otra posición.
+ */
+class TablaTransposicion
+{
+  public:
+    /**
+     * @brief Tipo de cota que representa el valor guardado.
+     */
+    enum TipoCota
+    {
+      EXACTA,     ///< El valor es exacto
+      INFERIOR,   ///< El valor real es mayor o igual (hubo poda beta)
+      SUPERIOR    ///< El valor real es menor o igual (ninguna jugada superó alfa)
+    };
+
+    /**
+     * @brief Información guardada para una posición.
+     */
+    struct Entrada
+    {
+      int valor;          ///< Puntuación de la posición
+      int profundidad;    ///< Profundidad con la que se buscó
+      TipoCota cota;      ///< Tipo de cota de valor
+      int mejor_col;      ///< Mejor columna encontrada (-1 si no hay)
+    };
+
+  private:
+    /**
+     * @brief Celda de la tabla: los datos empaquetados en 64 bits (valor,
+     * profundidad, cota y mejor columna) y la clave XOR los datos.
+     */
+    struct Celda
+    {
+      uint64_t clave;
+      uint64_t datos;
+    };
+
+    vector<Celda> celdas;   ///< Celdas de la tabla
+    uint64_t mascara;       ///< Número de celdas - 1, para obtener el índice
+
+    /**
+     * @brief Empaqueta una entrada en 64 bits.
+     */
+    static uint64_t empaquetar(const Entrada& e);
+
+    /**
+     * @brief Desempaqueta los 64 bits de datos de una celda.
+     */
+    static Entrada desempaquetar(uint64_t datos);
+
+    /**
+     * @brief Lee los datos de una celda si pertenecen a la clave dada.
+     * @return Los datos, o 0 si la celda está vacía o es de otra posición.
+     */
+    uint64_t leer(uint64_t clave) const;
+
+    /// Las pruebas de test_componentes dejan celdas a medio escribir
+    friend struct PruebaTablaTransposicion;
+
+  public:
+    /**
+     * @brief Constructor. Crea una tabla que ocupa como mucho @e megas MB.
+     * @param megas Memoria máxima de la tabla, en MB. Con 0 la tabla no
+     * guarda nada.
+     */
+    TablaTransposicion(int megas = 0);
+
+    /**
+     * @brief Busca una posición en la tabla.
+     * @param clave Clave Zobrist de la posición
+     * @param e Entrada donde se copia la información si se encuentra
+     * @return true si la posición está en la tabla, false si no.
+     * @note Puede llamarse a la vez que guardar() desde otros hilos.
+     */
+    bool buscar(uint64_t clave, Entrada& e) const;
+
+    /**
+     * @brief Guarda la información de una posición.
+     * @param clave Clave Zobrist de la posición
+     * @param e Información a guardar
+     * @note Puede llamarse a la vez desde varios hilos.
+     */
+    void guardar(uint64_t clave, const Entrada& e);
+
+    /**
+     * @brief Vacía la tabla sin cambiar su tamaño.
+     */
+    void limpiar();
+
+    /**
+     * @brief Número de entradas de la tabla.
+     */
+    size_t size() const { return celdas.size(); }
+};
+
+#endif
+
+/* Fin fichero: tabla_transposicion.h */
@@ -10,6 +10,7 @@
 #include <iosfwd>
 #include <vector>
 #include <string>
+#include <cstdint>
 
 using namespace std;
 
@@ -19,23 +20,115 @@ using namespace std;
  *
  * Diremos que un tablero está vacío cuando la última columna donde se insertó
  * una ficha valga -1.
+ *
+ * Si se compila con la macro @e TABLERO_BITBOARD, los tableros de hasta
+ * @e MAX_CASILLAS_BB casillas (por ejemplo 6x7 o 7x9) se representan con dos
+ * máscaras de 64 bits, una por jugador, y la altura de cada columna. El bit
+ * de la casilla (i,j) es j*filas + (filas-1-i), es decir, cada columna ocupa
+ * @e filas bits consecutivos empezando por la fila inferior. Los tableros
+ * mayores siguen usando la matriz de enteros.
+ *
+ * El número de fichas en línea que hacen falta para ganar también es un
+ * parámetro del tablero (4 por defecto). Con bitboards, las líneas se
+ * buscan con una función que se elige al crear el tablero: para los tamaños
+ * más habituales (ver reserve()) es una instancia de una plantilla con las
+ * filas, las columnas y las fichas para ganar fijas, de modo que las
+ * máscaras y los desplazamientos son constantes y el compilador puede
+ * desenrollar los bucles; para el resto, una versión genérica.
+ *
+ * Cada tablero mantiene además una clave Zobrist: el XOR de una clave
+ * pseudoaleatoria por cada ficha (según casilla y jugador) y otra si le toca
+ * al jugador 2. Se actualiza en cada colocarFicha, quitarFicha y cambiarTurno,
+ * y es la misma con ambas representaciones y entre ejecuciones.
  */
 class Tablero
 {
+  public:
+    /// Número máximo de casillas de un tablero representado con bitboards
+    const static int MAX_CASILLAS_BB = 64;
+    /// Número máximo de columnas de un tablero representado con bitboards
+    const static int MAX_COLUMNAS_BB = 16;
+    /// Número máximo de fichas en línea para ganar
+    const static int MAX_FICHAS_GANAR = 8;
+
+    /**
+     * @brief Máscara con todas las casillas de un tablero representado con
+     * bitboards. Se puede calcular al compilar.
+     */
+    static constexpr uint64_t mascaraLleno(int filas, int columnas)
+    {
+      return columnas == 0 ? 0
+             : mascaraLleno(filas, columnas - 1)
+               | ((((uint64_t)1 << filas) - 1) << ((columnas - 1) * filas));
+    }
+
+    /**
+     * @brief Máscara con la fila inferior de un tablero representado con
+     * bitboards. Se puede calcular al compilar.
+     */
+    static constexpr uint64_t mascaraFilaInf(int filas, int columnas)
+    {
+      return columnas == 0 ? 0
+             : mascaraFilaInf(filas, columnas - 1) | ((uint64_t)1 << ((columnas - 1) * filas));
+    }
+
   private:
-    vector<vector<int> > tablero;  ///< Matriz que representa un estado del juego.
+    /**
+     * @brief Función que comprueba si hay una línea ganadora en una máscara
+     * de un tablero representado con bitboards.
+     */
+    typedef bool (*DetectorLinea)(const Tablero& t, uint64_t b);
+
+    vector<vector<int> > tablero;  ///< Matriz que representa un estado del juego (si no se usan bitboards).
     const int filas;               ///< Número de filas que tiene el tablero.
     const int columnas;            ///< Número de columnas que tiene el tablero.
+    int fichas_ganar;              ///< Número de fichas en línea necesarias para ganar.
     int turno;                     ///< Indica a qué jugador le toca poner ficha. 1 para el jugador 1, 2 para el jugador 2.
     int ult_col;                   ///< Columna donde se insertó la última ficha
+    int ult_fila;                  ///< Fila donde quedó la última ficha insertada
+    uint64_t clave;                ///< Clave Zobrist del estado del juego
+
+    bool bitboard;                 ///< Indica si el estado se guarda en bitboards.
+    uint64_t fichas[2];            ///< Máscara con las fichas de cada jugador (bitboard).
+    uint64_t lleno;                ///< Máscara con todas las casillas del tablero (bitboard).
+    uint64_t fila_inf;             ///< Máscara con la fila inferior del tablero (bitboard).
+    int alturas[MAX_COLUMNAS_BB];  ///< Número de fichas de cada columna (bitboard).
+    DetectorLinea detector;        ///< Busca las líneas ganadoras (bitboard).
+
+    /**
+     * @brief Crea el tablero de tamaño filas/columnas y elige el detector de
+     *        líneas: uno especializado si hay una instancia para el tamaño y
+     *        las fichas para ganar del tablero, o el genérico si no.
+     * @param usar_bitboard : Con false se usa la matriz aunque quepa.
+     */
+    void reserve(bool usar_bitboard = true);
+
+    /**
+     * @brief Carga en los bitboards el estado de una matriz de juego.
+     * @param m : Matriz de tamaño filas x columnas.
+     */
+    void cargarBitboard(const vector<vector<int> >& m);
+
+    /**
+     * @brief Comprueba si hay fichas_ganar fichas alineadas en una máscara.
+     * @param b : Máscara con las fichas de un jugador.
+     * @return true si hay alguna alineación ganadora, false si no.
+     */
+    bool hayLineaBB(uint64_t b) const { return detector(*this, b); }
 
     /**
-     * @brief Crea el tablero de tamaño filas/columnas
+     * @brief Detector de líneas genérico, para cualquier tamaño de tablero y
+     *        número de fichas para ganar.
      */
-    void reserve();
+    static bool hayLineaGenerica(const Tablero& t, uint64_t b);
+
+    /**
+     * @brief Recalcula la clave Zobrist a partir del estado completo.
+     */
+    void calcularClave();
 
 public:
-    /// Representa el número de fichas necesarias para ganar
+    /// Representa el número de fichas necesarias para ganar (por defecto)
     const static int N_FICHAS_GANAR = 4;
     /// Carácter que representa una ficha del Jugador 1
     const static char CHAR_J1 = 'x';
@@ -57,8 +150,13 @@ public:
      *        está libre. El turno inicial es el del jugador 1.
      * @param filas : Número de filas que tendrá el tablero.
      * @param columnas : Nümero de columnas del tablero.
+     * @param fichas_ganar : Número de fichas en línea necesarias para ganar.
+     * @param usar_bitboard : Con false se usa la matriz de enteros aunque el
+     *        tablero quepa en bitboards (p.ej. para comparar ambas).
+     * @pre 2 <= fichas_ganar <= MAX_FICHAS_GANAR
      */
-    Tablero(const int filas, const int columnas);
+    Tablero(const int filas, const int columnas,
+            const int fichas_ganar = N_FICHAS_GANAR, const bool usar_bitboard = true);
 
     /**
      * @brief Constructor de copia. Crea un tablero a partir de otro dado.
@@ -66,6 +164,13 @@ public:
      */
     Tablero(const Tablero& t);
 
+    /**
+     * @brief Constructor de movimiento. Crea un tablero quedándose con la
+     *        matriz de otro, que no debe volver a usarse salvo para destruirlo.
+     * @param t : Tablero origen que se va a mover.
+     */
+    Tablero(Tablero&& t);
+
 
     /**
      * @brief Destructor.
@@ -79,7 +184,7 @@ public:
      * @return Devuelve la fila en la que hay hueco (en esa columna).
      *         Si no hay hueco devuelve -1.
      */
-    int hayHueco(int pos);
+    int hayHueco(int pos) const;
 
     /**
      * @brief Comprueba si el tablero está lleno.
@@ -108,6 +213,17 @@ public:
      */
     bool colocarFicha(int pos);
 
+    /**
+     * @brief Quita la ficha más alta de una columna, deshaciendo un
+     *        colocarFicha. No cambia el turno.
+     * @param pos : Columna de la que se quita la ficha.
+     * @param col_anterior : Columna de la jugada anterior a la que se deshace,
+     *        que vuelve a ser la última columna (-1 si el tablero queda vacío).
+     * @return Devuelve true si se ha quitado la ficha. False si la columna
+     *         estaba vacía o fuera del tablero.
+     */
+    bool quitarFicha(int pos, int col_anterior);
+
     /**
      * @brief Cambia el turno del jugador que toca.
      * @return Devuelve el turno que toca.
@@ -126,23 +242,71 @@ public:
      */
     const int GetFilas() const { return filas; }
 
+    /**
+     * @brief Indica si el tablero está representado con bitboards.
+     * @return true si usa bitboards, false si usa la matriz de enteros.
+     */
+    bool UsaBitboard() const { return bitboard; }
+
+    /**
+     * @brief Devuelve el número de fichas en línea necesarias para ganar.
+     */
+    int GetFichasGanar() const { return fichas_ganar; }
+
+    /**
+     * @brief Indica si el tablero busca las líneas ganadoras con un detector
+     *        especializado para su tamaño y sus fichas para ganar.
+     * @return true si usa bitboards y hay una instancia para su tamaño.
+     */
+    bool EstaEspecializado() const
+    {
+      return bitboard && detector != &Tablero::hayLineaGenerica;
+    }
+
+    /**
+     * @brief Devuelve la máscara con las fichas de un jugador (ver la
+     *        numeración de los bits en la descripción de la clase).
+     * @param jugador : Jugador (1 ó 2).
+     * @pre UsaBitboard()
+     */
+    uint64_t GetMascara(int jugador) const { return fichas[jugador - 1]; }
+
     /**
      * @brief Devuelve la columna donde se insertó la última ficha.
      */
     int GetUltCol() const { return ult_col; }
 
+    /**
+     * @brief Devuelve la fila donde quedó la última ficha insertada (-1 si el
+     *        tablero está vacío).
+     */
+    int GetUltFila() const { return ult_fila; }
+
+    /**
+     * @brief Devuelve la clave Zobrist del tablero. Dos tableros del mismo
+     *        tamaño con las mismas fichas y el mismo turno tienen la misma clave.
+     */
+    uint64_t GetClave() const { return clave; }
+
     /**
      * @brief Función que devuelve el atributo tablero.
      * @return Devuelve un vector de vectores de enteros (una matriz) de enteros
      *         representando un tablero.
      */
-    vector<vector<int> > GetTablero() const { return tablero; }
+    vector<vector<int> > GetTablero() const;
 
     /**
      * @brief Devuelve el elemento en la posición (i,j) del tablero.
      * @pre 0 <= i < filas; 0 <= j < columnas
      */
-    int GetElemento(int i, int j) const { return tablero[i][j]; }
+    int GetElemento(int i, int j) const
+    {
+      if (!bitboard)
+        return tablero[i][j];
+
+      uint64_t bit = (uint64_t)1 << (j * filas + filas - 1 - i);
+      return (fichas[0] & bit) ? 1 : ((fichas[1] & bit) ? 2 : 0);
+    }
 
     /**
      * @brief Asigna un tablero introducido como parámetro.
@@ -155,7 +319,7 @@ public:
      * @brief Turno del estado actual.
      * @return Devuelve el turno del jugador. {1, 2}
      */
-    int GetTurno() { return turno; }
+    int GetTurno() const { return turno; }
 
     /**
      * @brief Operador de igualdad. Asigna los valores del tablero de la derecha
@@ -180,6 +344,28 @@ public:
      *         jugador 1 y 2 si ha ganado el jugador 2.
      */
     int quienGana();
+
+    /**
+     * @brief Comprueba si la última ficha insertada ha formado una línea
+     *        ganadora. Sólo examina las líneas que pasan por la casilla
+     *        (ult_fila, ult_col), por lo que su coste no depende del tamaño del
+     *        tablero.
+     * @pre Antes de la última ficha no había ningún ganador.
+     * @return Devuelve {0, 1, 2} 0 si no ha ganado nadie. 1 si ha ganado el
+     *         jugador 1 y 2 si ha ganado el jugador 2.
+     */
+    int quienGanaUltimo() const;
+
+    /**
+     * @brief Cuenta las ventanas abiertas de cada jugador. Una ventana son
+     *        GetFichasGanar() casillas consecutivas de una fila, columna o
+     *        diagonal, y está abierta para un jugador si no contiene fichas
+     *        del rival.
+     * @param ventanas : ventanas[j][k] recibe el número de ventanas abiertas
+     *        del jugador j+1 con exactamente k fichas suyas (0 <= k <=
+     *        GetFichasGanar()).
+     */
+    void contarVentanas(int ventanas[2][MAX_FICHAS_GANAR + 1]) const;
 };
 
 /**
@@ -0,0 +1,56 @@
+/**
+ * @file aleatorio.cpp
+ * @brief Implementación de funciones del TDA Aleatorio
+ *
+ */
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include "aleatorio.h"
+
+using namespace std;
+
+// Funciones auxiliares
+namespace
+{
+  /**
+   * @brief Generador splitmix64, con el que se amplía la semilla.
+   */
+  uint64_t splitmix64(uint64_t& x)
+  {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+}
+
+/* _________________________________________________________________________ */
+
+Aleatorio::Aleatorio(uint64_t semilla, uint64_t flujo)
+{
+  if (semilla == 0)
+    semilla = semillaAleatoria();
+
+  // Cada flujo empieza en otro punto de la secuencia de splitmix64
+  uint64_t x = semilla;
+  x ^= splitmix64(flujo);
+  for (int i = 0; i < 4; i++)
+    estado[i] = splitmix64(x);
+}
+
+/* _________________________________________________________________________ */
+
+uint64_t Aleatorio::semillaAleatoria()
+{
+  static atomic<uint64_t> llamadas(0);
+  uint64_t x = random_device()();
+  x = (x << 32) ^ chrono::steady_clock::now().time_since_epoch().count();
+  x ^= ++llamadas * 0xD1B54A32D192ED03ULL;
+
+  uint64_t semilla = splitmix64(x);
+  return semilla ? semilla : 1;
+}
+
+/* Fin fichero: aleatorio.cpp */
@@ -0,0 +1,326 @@
+/**
+ * @file analizar.cpp
+ * @brief Analiza con un motor las jugadas de un fichero de partidas
+ *
+ * Este programa lee un fichero de partidas (ver Partida; se guardan con la
+ * opción -d de conecta4 y de torneo) y valora con un motor cada jugada de
+ * cada partida. Escribe en formato CSV una fila por jugada, con la columna
+ * jugada, la que habría elegido el motor, el valor de las dos para el
+ * jugador que movía y la diferencia entre ellos, que mide lo que se ha
+ * perdido con la jugada (0 si se ha jugado la del motor).
+ *
+ * El valor de una jugada es el de la posición a la que lleva, que el motor
+ * valora desde el punto de vista del rival, cambiado de signo; si la partida
+ * acaba con ella, es el resultado: 1 si gana y 0 si empata. Los valores van
+ * de -1 (pierde seguro) a 1 (gana seguro), ver Motor::GetValor. Como las dos
+ * jugadas se valoran igual, la diferencia no depende de la paridad de la
+ * profundidad de la búsqueda, aunque puede ser negativa si al mirar más
+ * allá la jugada del motor resulta peor que la hecha.
+ *
+ * El fichero se lee por lotes de partidas, así que puede tener cualquier
+ * tamaño. Las partidas de cada lote se reparten entre los núcleos del
+ * equipo: cada hilo analiza una de cada tantas con su propio motor, que
+ * conserva lo aprendido de una posición a la siguiente. La salida sale en
+ * el orden del fichero y, con el mismo número de hilos y sin límite de
+ * tiempo, es siempre la misma.
+ *
+ * Para ver la lista de argumentos que admite, ejecutar el programa
+ * con el modificador -h para ver la ayuda.
+ */
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "grupo_hilos.h"
+#include "jugador_auto.h"
+#include "partida.h"
+
+using namespace std;
+
+/// Partidas que se leen y se reparten entre los hilos de una vez
+const size_t LOTE = 1024;
+
+/**
+ * @brief Motor de un hilo de análisis, con el tamaño de tablero para el que
+ * se creó.
+ */
+struct Analista
+{
+  unique_ptr<Motor> motor;  ///< Motor (nulo hasta la primera partida)
+  int filas;                ///< Filas del tablero del motor
+  int columnas;             ///< Columnas del tablero del motor
+  int fichas_ganar;         ///< Fichas para ganar del tablero del motor
+
+  Analista() : filas(0), columnas(0), fichas_ganar(0) { }
+};
+
+/**
+ * @brief Partida leída del fichero.
+ */
+struct PartidaLeida
+{
+  Partida partida;          ///< Jugadas
+  long linea;               ///< Línea del fichero en la que está
+  string analisis;          ///< Filas CSV de sus jugadas, al analizarla
+};
+
+/**
+ * @brief Valora una posición para el jugador al que le toca mover en ella.
+ * @param motor Motor con el que se valora
+ * @param t Posición
+ * @param mejor Recibe la columna que elige el motor (-1 si la partida ha
+ * acabado)
+ * @return El valor del motor, o -1 si ha ganado el rival y 0 si el tablero
+ * está lleno.
+ */
+double Valorar(Motor& motor, Tablero& t, int& mejor)
+{
+  mejor = -1;
+  if (t.quienGanaUltimo())
+    return -1;
+  if (t.estaLleno())
+    return 0;
+
+  mejor = motor.mejorMovimiento(t);
+  return motor.GetValor();
+}
+
+/**
+ * @brief Analiza las jugadas de una partida.
+ * @param p Partida. Se guardan en p.analisis las filas CSV de sus jugadas.
+ * @param a Motor del hilo. Se crea de nuevo si es de otro tamaño de tablero.
+ * @param estrategia Estrategia del motor
+ * @param params Parámetros del motor
+ */
+void AnalizarPartida(PartidaLeida& p, Analista& a,
+                     const JugadorAuto::Estrategia& estrategia,
+                     const ParametrosBusqueda& params)
+{
+  const Partida& partida = p.partida;
+  size_t n = partida.size();
+  Tablero t = partida.tablero(0);
+
+  if (!a.motor || a.filas != t.GetFilas() || a.columnas != t.GetColumnas()
+      || a.fichas_ganar != t.GetFichasGanar())
+  {
+    a.motor = estrategia.crear(t, params, false);
+    a.filas = t.GetFilas();
+    a.columnas = t.GetColumnas();
+    a.fichas_ganar = t.GetFichasGanar();
+  }
+
+  // Valor de cada posición de la partida, columna del motor en cada una y,
+  // si no es la jugada hecha, valor de la posición a la que lleva
+  vector<double> valores(n + 1), valores_mejor(n);
+  vector<int> mejores(n + 1), jugadores(n);
+
+  for (size_t i = 0; i <= n; i++)
+  {
+    valores[i] = Valorar(*a.motor, t, mejores[i]);
+    if (i == n)
+      break;
+
+    jugadores[i] = t.GetTurno();
+    if (mejores[i] != partida[i])
+    {
+      Tablero u(t);
+      int col;
+      u.colocarFicha(mejores[i]);
+      u.cambiarTurno();
+      valores_mejor[i] = -Valorar(*a.motor, u, col);
+    }
+
+    t.colocarFicha(partida[i]);
+    t.cambiarTurno();
+  }
+
+  ostringstream os;
+  os << fixed << setprecision(4);
+  for (size_t i = 0; i < n; i++)
+  {
+    double valor_jugada = -valores[i + 1];
+    double valor_mejor = (mejores[i] == partida[i]) ? valor_jugada : valores_mejor[i];
+
+    os << p.linea << ',' << i + 1 << ',' << jugadores[i] << ',' << partida[i]
+       << ',' << mejores[i] << ',' << valor_mejor << ',' << valor_jugada << ','
+       << valor_mejor - valor_jugada << '\n';
+  }
+  p.analisis = os.str();
+}
+
+/**
+ * @brief Lee el siguiente lote de partidas, saltando (con un aviso) las
+ * líneas incorrectas y las partidas en tableros que el motor no admite.
+ * @param entrada Fichero de partidas
+ * @param num_linea Última línea leída; se actualiza
+ * @param estrategia Estrategia del motor
+ * @param lote Vector donde se dejan las partidas leídas
+ * @return Número de partidas saltadas.
+ */
+long LeerLote(istream& entrada, long& num_linea,
+              const JugadorAuto::Estrategia& estrategia,
+              vector<PartidaLeida>& lote)
+{
+  string linea;
+  long saltadas = 0;
+
+  lote.clear();
+  while (lote.size() < LOTE && getline(entrada, linea))
+  {
+    num_linea++;
+    if (linea.find_first_not_of(" \t\r") == string::npos || linea[0] == '#')
+      continue;
+
+    istringstream is(linea);
+    PartidaLeida p;
+    p.linea = num_linea;
+    if (!(is >> p.partida))
+    {
+      cerr << "Aviso: la línea " << num_linea << " no es una partida correcta" << endl;
+      saltadas++;
+    }
+    else if (estrategia.cabe && !estrategia.cabe(p.partida.GetFilas(),
+                                                 p.partida.GetColumnas()))
+    {
+      cerr << "Aviso: la métrica " << estrategia.numero << " no admite el tablero de "
+           << "la línea " << num_linea << endl;
+      saltadas++;
+    }
+    else
+      lote.push_back(p);
+  }
+
+  return saltadas;
+}
+
+int main(int argc, char **argv)
+{
+  string fichero, fichero_salida, nombre_metrica = "5";
+  int hilos = 0;
+  ParametrosBusqueda params;
+  bool opc_ayuda = false;
+
+  // Análisis reproducible por defecto
+  params.semilla = 1;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (string(argv[i]) == "-i" && i + 1 < argc)
+      fichero = argv[++i];
+    else if (string(argv[i]) == "-m" && i + 1 < argc)
+      nombre_metrica = argv[++i];
+    else if (string(argv[i]) == "-p" && i + 1 < argc)
+      params.profundidad = stoi(argv[++i]);
+    else if (string(argv[i]) == "-l" && i + 1 < argc)
+      params.tiempo_ms = stoi(argv[++i]);
+    else if (string(argv[i]) == "-u" && i + 1 < argc)
+      params.simulaciones = stoi(argv[++i]);
+    else if (string(argv[i]) == "-r" && i + 1 < argc)
+      params.memoria_tt = stoi(argv[++i]);
+    else if (string(argv[i]) == "-z" && i + 1 < argc)
+      params.semilla = stoull(argv[++i]);
+    else if (string(argv[i]) == "-j" && i + 1 < argc)
+      hilos = stoi(argv[++i]);
+    else if (string(argv[i]) == "-o" && i + 1 < argc)
+      fichero_salida = argv[++i];
+    else
+      opc_ayuda = true;
+  }
+
+  if (opc_ayuda || fichero.empty())
+  {
+    cout << "uso: analizar -i fichero [-m métrica] [-p número] [-l número] [-u número]" << endl;
+    cout << "              [-r número] [-z número] [-j número] [-o fichero]" << endl;
+    cout << "i : fichero de partidas (ver conecta4 -d y torneo -d; - para la entrada" << endl;
+    cout << "    estándar)" << endl;
+    cout << "m : métrica con la que se analiza, por número o por nombre (por defecto 5;" << endl;
+    cout << "    sólo las que usan un motor, como la 5 y la 6):" << endl;
+    JugadorAuto::mostrarEstrategias(cout, "    ");
+    cout << "p : profundidad de la búsqueda alfa-beta (métrica 5, por defecto 10)" << endl;
+    cout << "l : tiempo máximo por posición en ms (métricas 5 y 6, 0 sin límite)" << endl;
+    cout << "u : simulaciones por posición de la métrica 6 si no hay límite de tiempo" << endl;
+    cout << "    (por defecto 20000)" << endl;
+    cout << "r : memoria (MB) de la tabla de transposición (o del árbol de la métrica 6)" << endl;
+    cout << "    de cada hilo" << endl;
+    cout << "z : semilla de la métrica 6 (por defecto 1; 0 para una distinta cada vez)" << endl;
+    cout << "j : hilos que analizan partidas a la vez (0 para usar todos los núcleos)" << endl;
+    cout << "o : escribe el análisis en un fichero CSV (por defecto, en pantalla)" << endl;
+    return 1;
+  }
+
+  JugadorAuto::Estrategia estrategia;
+  if (!JugadorAuto::buscarEstrategia(nombre_metrica, estrategia))
+  {
+    cout << "Error: no hay ninguna métrica " << nombre_metrica << "." << endl;
+    return 1;
+  }
+  if (!estrategia.crear)
+  {
+    cout << "Error: la métrica " << estrategia.numero << " no usa un motor." << endl;
+    return 1;
+  }
+
+  ifstream fentrada;
+  if (fichero != "-")
+  {
+    fentrada.open(fichero.c_str());
+    if (!fentrada)
+    {
+      cout << "Error: no se ha podido abrir " << fichero << endl;
+      return 1;
+    }
+  }
+  istream& entrada = (fichero == "-") ? cin : fentrada;
+
+  ofstream fsalida;
+  if (!fichero_salida.empty())
+  {
+    fsalida.open(fichero_salida.c_str());
+    if (!fsalida)
+    {
+      cout << "Error: no se ha podido abrir " << fichero_salida << endl;
+      return 1;
+    }
+  }
+  ostream& salida = fichero_salida.empty() ? cout : fsalida;
+
+  // Cada motor busca en un solo hilo: el paralelismo está en analizar
+  // varias partidas a la vez
+  params.hilos = 1;
+  params.anticipar = false;
+  GrupoHilos grupo(hilos);
+  vector<Analista> analistas(grupo.size());
+  vector<PartidaLeida> lote;
+  long num_linea = 0, analizadas = 0, saltadas = 0;
+
+  salida << "linea,jugada,jugador,columna,mejor,valor_mejor,valor_jugada,delta\n";
+
+  do
+  {
+    saltadas += LeerLote(entrada, num_linea, estrategia, lote);
+
+    // El hilo k analiza las partidas k, k + h, k + 2h... del lote
+    int num_analistas = analistas.size();
+    grupo.ejecutar(num_analistas, [&](int k) {
+      for (size_t i = k; i < lote.size(); i += num_analistas)
+        AnalizarPartida(lote[i], analistas[k], estrategia, params);
+    });
+
+    for (size_t i = 0; i < lote.size(); i++)
+      salida << lote[i].analisis;
+    analizadas += lote.size();
+  } while (lote.size() == LOTE);
+
+  salida.flush();
+  cerr << analizadas << " partidas analizadas";
+  if (saltadas)
+    cerr << ", " << saltadas << " saltadas";
+  cerr << endl;
+
+  return salida ? 0 : 1;
+}
+
+/* Fin fichero: analizar.cpp */
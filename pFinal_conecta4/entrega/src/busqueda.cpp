@@ -0,0 +1,586 @@
+/**
+ * @file busqueda.cpp
+ * @brief Implementación de funciones del TDA Busqueda
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "busqueda.h"
+
+// Funciones auxiliares
+namespace
+{
+  /// Evaluación que GetValor pasa a tanh(1) = 0,76: unas diez ventanas más
+  /// que el rival a falta de una ficha
+  const double ESCALA_VALOR = 50.0;
+
+  /**
+   * @brief Peso de una ventana abierta según el número de fichas propias que
+   * contiene. Sólo cuentan las que están a una o dos fichas de ser ganadoras.
+   * @param fichas Fichas propias de la ventana
+   * @param n Fichas en línea necesarias para ganar
+   */
+  int pesoVentana(int fichas, int n)
+  {
+    if (fichas == n - 1)
+      return 5;
+    if (fichas == n - 2)
+      return 1;
+    return 0;
+  }
+
+  /**
+   * @brief Columna que ocupa la posición i en el orden de exploración: primero
+   * la central y después alternando a izquierda y derecha, que suelen ser las
+   * jugadas más fuertes y provocan antes las podas.
+   */
+  inline int columnaOrden(int i, int num_cols)
+  {
+    int mitad = num_cols / 2;
+    return (i % 2 == 0) ? mitad + i / 2 : mitad - (i + 1) / 2;
+  }
+}
+
+/* _________________________________________________________________________ */
+
+Busqueda::Busqueda()
+  : hilos(1), con_limite(false), parar(false), segundos_total(0),
+    pensada(false), clave_pensada(0), col_pensada(-1), pensada_completa(false)
+{
+}
+
+/* _________________________________________________________________________ */
+
+Busqueda::Busqueda(const ParametrosBusqueda& params)
+  : params(params), tabla(params.memoria_tt), con_limite(false), parar(false),
+    segundos_total(0), pensada(false), clave_pensada(0), col_pensada(-1),
+    pensada_completa(false)
+{
+  if (params.hilos != 1)
+    grupo = make_shared<GrupoHilos>(params.hilos);
+  hilos.resize(grupo ? grupo->size() : 1);
+}
+
+/* _________________________________________________________________________ */
+
+Busqueda::~Busqueda()
+{
+  dejarDePensar();
+}
+
+/* _________________________________________________________________________ */
+
+int Busqueda::aTabla(int valor, int nivel)
+{
+  // Las victorias se miden desde la raíz: en la tabla, desde el nodo
+  if (valor > VICTORIA / 2)
+    return valor + nivel;
+  if (valor < -VICTORIA / 2)
+    return valor - nivel;
+  return valor;
+}
+
+/* _________________________________________________________________________ */
+
+int Busqueda::deTabla(int valor, int nivel)
+{
+  if (valor > VICTORIA / 2)
+    return valor - nivel;
+  if (valor < -VICTORIA / 2)
+    return valor + nivel;
+  return valor;
+}
+
+/* _________________________________________________________________________ */
+
+int Busqueda::evaluar(const Tablero& t) const
+{
+  int ventanas[2][Tablero::MAX_FICHAS_GANAR + 1];
+  int propio = t.GetTurno() - 1;
+  int puntos = 0;
+
+  evaluador.contar(t, ventanas);
+  for (int k = 0; k < t.GetFichasGanar(); k++)
+    puntos += pesoVentana(k, t.GetFichasGanar())
+              * (ventanas[propio][k] - ventanas[1 - propio][k]);
+
+  return puntos;
+}
+
+/* _________________________________________________________________________ */
+
+void Busqueda::ordenarJugadas(const Hilo& h, Tablero& t, int nivel,
+                              int col_vp, int col_tabla,
+                              vector<int>& orden) const
+{
+  int num_cols = t.GetColumnas();
+
+  orden.clear();
+  if (col_vp != -1 && t.hayHueco(col_vp) > -1)
+    orden.push_back(col_vp);
+  if (col_tabla != -1 && col_tabla != col_vp && t.hayHueco(col_tabla) > -1)
+    orden.push_back(col_tabla);
+
+  // Jugadas asesinas del nivel, si se pueden jugar aquí
+  if (params.orden_dinamico)
+    for (int k = 0; k < 2; k++)
+    {
+      int col = h.asesinas[2 * nivel + k];
+      if (col != -1 && t.hayHueco(col) > -1
+          && find(orden.begin(), orden.end(), col) == orden.end())
+        orden.push_back(col);
+    }
+
+  // El resto, desde el centro hacia los lados
+  size_t resto = orden.size();
+  for (int i = 0; i < num_cols; i++)
+  {
+    int col = columnaOrden(i, num_cols);
+    if (t.hayHueco(col) > -1
+        && find(orden.begin(), orden.begin() + resto, col) == orden.begin() + resto)
+      orden.push_back(col);
+  }
+
+  // Ordenar el resto por historia. Son pocas columnas, así que basta con
+  // inserción, que además mantiene el orden desde el centro en los empates
+  if (params.orden_dinamico)
+  {
+    int casillas = t.GetFilas() * num_cols;
+    const long *historia = &h.historia[(t.GetTurno() - 1) * casillas];
+
+    for (size_t i = resto + 1; i < orden.size(); i++)
+    {
+      int col = orden[i];
+      long p = historia[col * t.GetFilas() + t.hayHueco(col)];
+      size_t k = i;
+      while (k > resto
+             && historia[orden[k - 1] * t.GetFilas() + t.hayHueco(orden[k - 1])] < p)
+      {
+        orden[k] = orden[k - 1];
+        k--;
+      }
+      orden[k] = col;
+    }
+  }
+}
+
+/* _________________________________________________________________________ */
+
+void Busqueda::anotarCorte(Hilo& h, const Tablero& t, int col, int i,
+                           int profundidad, int nivel)
+{
+  h.cortes++;
+  if (i == 0)
+    h.cortes_primera++;
+
+  if (!params.orden_dinamico)
+    return;
+
+  // La última asesina pasa a ser la primera
+  int *asesinas = &h.asesinas[2 * nivel];
+  if (asesinas[0] != col)
+  {
+    asesinas[1] = asesinas[0];
+    asesinas[0] = col;
+  }
+
+  // Las podas cerca de la raíz ahorran más nodos: pesan más
+  int casillas = t.GetFilas() * t.GetColumnas();
+  h.historia[(t.GetTurno() - 1) * casillas + col * t.GetFilas() + t.hayHueco(col)]
+    += profundidad * profundidad;
+}
+
+/* _________________________________________________________________________ */
+
+int Busqueda::negamax(Hilo& h, Tablero& t, int profundidad, int alfa,
+                      int beta, int nivel)
+{
+  h.nodos++;
+  h.long_vp[nivel] = 0;
+
+  // Comprobar de vez en cuando si se ha agotado el tiempo o si el hilo
+  // principal ya ha terminado
+  if ((h.nodos & 1023) == 0)
+  {
+    if (con_limite && chrono::steady_clock::now() >= limite)
+      h.cancelada = true;
+    if (__atomic_load_n(&parar, __ATOMIC_RELAXED))
+      h.cancelada = true;
+  }
+  if (h.cancelada)
+    return 0;
+
+  // Empate o fin de la exploración
+  if (t.estaLleno())
+    return 0;
+  if (profundidad == 0)
+    return evaluar(t);
+
+  // Columna de la variante principal anterior, mientras sigamos en ella
+  int col_vp = -1;
+  if (h.sigue_vp && nivel < (int) h.vp_anterior.size())
+    col_vp = h.vp_anterior[nivel];
+  else
+    h.sigue_vp = false;
+
+  // Consultar la tabla de transposición (en la raíz siempre se busca, para
+  // obtener la variante principal)
+  TablaTransposicion::Entrada e;
+  int col_tabla = -1;
+  int alfa_inicial = alfa;
+  if (tabla.buscar(t.GetClave(), e))
+  {
+    col_tabla = e.mejor_col;
+    if (e.profundidad >= profundidad && nivel > 0)
+    {
+      int valor = deTabla(e.valor, nivel);
+      if (e.cota == TablaTransposicion::EXACTA
+          || (e.cota == TablaTransposicion::INFERIOR && valor >= beta)
+          || (e.cota == TablaTransposicion::SUPERIOR && valor <= alfa))
+        return valor;
+    }
+  }
+
+  int col_anterior = t.GetUltCol();
+  int mejor = -VICTORIA;
+  int mejor_col = -1;
+  vector<int> orden;
+
+  ordenarJugadas(h, t, nivel, col_vp, col_tabla, orden);
+
+  for (size_t i = 0; i < orden.size() && alfa < beta; i++)
+  {
+    int col = orden[i];
+    int puntos;
+
+    // Al probar otra jugada dejamos de seguir la variante anterior
+    if (col != col_vp)
+      h.sigue_vp = false;
+
+    t.colocarFicha(col);
+
+    // Si la ficha gana no hace falta seguir bajando
+    if (t.quienGanaUltimo())
+    {
+      puntos = VICTORIA - nivel - 1;
+      h.long_vp[nivel + 1] = 0;
+    }
+    else
+    {
+      t.cambiarTurno();
+      puntos = -negamax(h, t, profundidad - 1, -beta, -alfa, nivel + 1);
+      t.cambiarTurno();
+    }
+    t.quitarFicha(col, col_anterior);
+
+    if (h.cancelada)
+      return 0;
+
+    if (puntos > mejor)
+    {
+      mejor = puntos;
+      mejor_col = col;
+    }
+    if (mejor > alfa)
+    {
+      alfa = mejor;
+
+      // La variante principal es esta jugada seguida de la del hijo
+      h.vp[nivel][0] = col;
+      for (int k = 0; k < h.long_vp[nivel + 1]; k++)
+        h.vp[nivel][k + 1] = h.vp[nivel + 1][k];
+      h.long_vp[nivel] = h.long_vp[nivel + 1] + 1;
+
+      if (alfa >= beta)
+        anotarCorte(h, t, col, i, profundidad, nivel);
+    }
+  }
+
+  // Guardar el resultado en la tabla
+  e.valor = aTabla(mejor, nivel);
+  e.profundidad = profundidad;
+  e.mejor_col = mejor_col;
+  if (mejor <= alfa_inicial)
+    e.cota = TablaTransposicion::SUPERIOR;
+  else if (mejor >= beta)
+    e.cota = TablaTransposicion::INFERIOR;
+  else
+    e.cota = TablaTransposicion::EXACTA;
+  tabla.guardar(t.GetClave(), e);
+
+  return mejor;
+}
+
+/* _________________________________________________________________________ */
+
+int Busqueda::iterar(Hilo& h, Tablero& t, int primera, int max_prof,
+                     chrono::steady_clock::time_point inicio)
+{
+  int mejor_col = -1;
+
+  for (int prof = primera; prof <= max_prof; prof++)
+  {
+    if (__atomic_load_n(&parar, __ATOMIC_RELAXED))
+    {
+      h.cancelada = true;
+      break;
+    }
+
+    h.sigue_vp = true;
+    int valor = negamax(h, t, prof, -VICTORIA - 1, VICTORIA + 1, 0);
+    if (h.cancelada)
+      break;
+
+    mejor_col = h.vp[0][0];
+    h.vp_anterior.assign(h.vp[0].begin(), h.vp[0].begin() + h.long_vp[0]);
+    h.profundidad = prof;
+    h.valor = valor;
+
+    // Partida resuelta: buscar más profundo no cambia el resultado
+    if (valor > VICTORIA / 2 || valor < -VICTORIA / 2)
+      break;
+
+    // Si ya se ha gastado la mitad del tiempo, la siguiente iteración
+    // (más costosa) no llegaría a terminar
+    if (con_limite && chrono::steady_clock::now() - inicio
+                      > chrono::milliseconds(params.tiempo_ms / 2))
+      break;
+  }
+
+  return mejor_col;
+}
+
+/* _________________________________________________________________________ */
+
+void Busqueda::prepararHilos(const Tablero& t, int max_prof, bool reanudar)
+{
+  int num_cols = t.GetColumnas();
+
+  if (!evaluador.sirvePara(t))
+    evaluador = Evaluador(t.GetFilas(), num_cols, t.GetFichasGanar());
+
+  for (size_t i = 0; i < hilos.size(); i++)
+  {
+    hilos[i].nodos = 0;
+    hilos[i].cancelada = false;
+    hilos[i].vp.assign(max_prof + 2, vector<int>(max_prof + 2, -1));
+    hilos[i].long_vp.assign(max_prof + 2, 0);
+    hilos[i].asesinas.assign(2 * (max_prof + 2), -1);
+    if (reanudar)
+      continue;
+
+    hilos[i].profundidad = 0;
+    hilos[i].valor = 0;
+    hilos[i].vp_anterior.clear();
+
+    // Las asesinas dependen del nivel, que cambia con la raíz; la historia
+    // se conserva, pero pesa la mitad en cada búsqueda nueva
+    vector<long>& historia = hilos[i].historia;
+    if (historia.size() != (size_t) 2 * t.GetFilas() * num_cols)
+      historia.assign(2 * t.GetFilas() * num_cols, 0);
+    for (size_t k = 0; k < historia.size(); k++)
+      historia[k] /= 2;
+  }
+}
+
+/* _________________________________________________________________________ */
+
+int Busqueda::buscar(const Tablero& t, int primera, int max_prof,
+                     chrono::steady_clock::time_point inicio)
+{
+  int mejor_col = -1;
+
+  if (!grupo)
+  {
+    Tablero tablero(t);
+    mejor_col = iterar(hilos[0], tablero, primera, max_prof, inicio);
+  }
+  else
+  {
+    // Cada hilo busca sobre su propia copia del tablero. Los auxiliares
+    // empiezan a profundidades alternas para no ir todos a la par
+    grupo->ejecutar(hilos.size(), [&](int i) {
+      Tablero tablero(t);
+      if (i == 0)
+      {
+        mejor_col = iterar(hilos[0], tablero, primera, max_prof, inicio);
+        __atomic_store_n(&parar, true, __ATOMIC_RELAXED);
+      }
+      else
+        iterar(hilos[i], tablero, min(primera + i % 2, max_prof), max_prof, inicio);
+    });
+  }
+
+  for (size_t i = 0; i < hilos.size(); i++)
+    hilos[i].nodos_total += hilos[i].nodos;
+  segundos_total += chrono::duration<double>(chrono::steady_clock::now()
+                                             - inicio).count();
+
+  return mejor_col;
+}
+
+/* _________________________________________________________________________ */
+
+int Busqueda::mejorMovimiento(const Tablero& t)
+{
+  // Si se ha pensado esta misma posición, se aprovecha lo buscado
+  dejarDePensar();
+  bool acierto = pensada && clave_pensada == t.GetClave();
+  pensada = false;
+
+  chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+  int num_cols = t.GetColumnas();
+  int libres = 0;
+  int mejor_col = -1;
+
+  // Casillas libres: no tiene sentido buscar más allá de llenar el tablero
+  for (int col = 0; col < num_cols; col++)
+    libres += t.hayHueco(col) + 1;
+
+  con_limite = params.tiempo_ms > 0;
+  limite = inicio + chrono::milliseconds(params.tiempo_ms);
+  parar = false;
+  int max_prof = con_limite ? libres : min(params.profundidad, libres);
+
+  if (acierto && pensada_completa)
+  {
+    // La búsqueda ya terminó mientras pensaba el rival
+    for (size_t i = 0; i < hilos.size(); i++)
+      hilos[i].nodos = 0;
+    mejor_col = col_pensada;
+  }
+  else
+  {
+    // Si se acertó, se sigue desde la profundidad a la que se llegó
+    int primera = 1;
+    if (acierto && hilos[0].profundidad > 0)
+    {
+      primera = min(hilos[0].profundidad + 1, max_prof);
+      mejor_col = col_pensada;
+    }
+
+    prepararHilos(t, max_prof, primera > 1);
+    int col = buscar(t, primera, max_prof, inicio);
+    if (col != -1)
+      mejor_col = col;
+  }
+
+  // Por si no dio tiempo a completar ninguna iteración
+  for (int i = 0; i < num_cols && mejor_col == -1; i++)
+    if (t.hayHueco(columnaOrden(i, num_cols)) > -1)
+      mejor_col = columnaOrden(i, num_cols);
+
+  return mejor_col;
+}
+
+/* _________________________________________________________________________ */
+
+void Busqueda::pensar(const Tablero& t)
+{
+  dejarDePensar();
+
+  int libres = 0;
+  for (int col = 0; col < t.GetColumnas(); col++)
+    libres += t.hayHueco(col) + 1;
+
+  // Sin límite de tiempo: se busca hasta donde se buscaría en el turno, o
+  // hasta que llegue la jugada del rival
+  int max_prof = params.tiempo_ms > 0 ? libres : min(params.profundidad, libres);
+  con_limite = false;
+  parar = false;
+  prepararHilos(t, max_prof, false);
+
+  pensada = true;
+  clave_pensada = t.GetClave();
+  col_pensada = -1;
+  pensada_completa = false;
+
+  pensador.reset(new thread([this, t, max_prof]() {
+    col_pensada = buscar(t, 1, max_prof, chrono::steady_clock::now());
+    pensada_completa = !hilos[0].cancelada;
+  }));
+}
+
+/* _________________________________________________________________________ */
+
+void Busqueda::dejarDePensar()
+{
+  if (!pensador)
+    return;
+
+  __atomic_store_n(&parar, true, __ATOMIC_RELAXED);
+  pensador->join();
+  pensador.reset();
+}
+
+/* _________________________________________________________________________ */
+
+int Busqueda::GetRespuestaEsperada() const
+{
+  return hilos[0].vp_anterior.size() > 1 ? hilos[0].vp_anterior[1] : -1;
+}
+
+/* _________________________________________________________________________ */
+
+double Busqueda::GetValor() const
+{
+  int valor = hilos[0].valor;
+
+  if (valor > VICTORIA / 2)
+    return 1;
+  if (valor < -VICTORIA / 2)
+    return -1;
+  return tanh(valor / ESCALA_VALOR);
+}
+
+/* _________________________________________________________________________ */
+
+long Busqueda::GetNodos() const
+{
+  long total = 0;
+  for (size_t i = 0; i < hilos.size(); i++)
+    total += hilos[i].nodos;
+  return total;
+}
+
+/* _________________________________________________________________________ */
+
+long Busqueda::GetCortes(long *primera) const
+{
+  long total = 0, total_primera = 0;
+  for (size_t i = 0; i < hilos.size(); i++)
+  {
+    total += hilos[i].cortes;
+    total_primera += hilos[i].cortes_primera;
+  }
+
+  if (primera)
+    *primera = total_primera;
+  return total;
+}
+
+/* _________________________________________________________________________ */
+
+void Busqueda::mostrarRendimiento(ostream& os) const
+{
+  long total = 0;
+
+  for (size_t i = 0; i < hilos.size(); i++)
+  {
+    total += hilos[i].nodos_total;
+    os << "Hilo " << i << ": " << hilos[i].nodos_total << " nodos, "
+       << (long) (segundos_total > 0 ? hilos[i].nodos_total / segundos_total : 0)
+       << " nodos/s" << endl;
+  }
+  os << "Total: " << total << " nodos, "
+     << (long) (segundos_total > 0 ? total / segundos_total : 0)
+     << " nodos/s" << endl;
+
+  long primera;
+  long cortes = GetCortes(&primera);
+  os << "Podas: " << cortes << ", con la primera jugada: "
+     << (cortes > 0 ? 100.0 * primera / cortes : 0) << "%" << endl;
+}
+
+/* Fin fichero: busqueda.cpp */
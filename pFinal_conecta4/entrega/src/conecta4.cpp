@@ -10,7 +10,10 @@
  * con el modificador -h para ver la ayuda.
  */
 
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <string>
 #include <vector>
 #include <ctime>
 #include <cstdlib>
@@ -18,6 +21,7 @@
 #include <unistd.h>
 #include "mando.h"
 #include "jugador_auto.h"
+#include "partida.h"
 
 #ifdef __APPLE__
   #include <termios.h>  // macOS
@@ -72,6 +76,54 @@ void ImprimeTablero(Tablero& t, Mando& m)
   cout << m.GetMando() << endl;
 }
 
+/**
+ * @brief Abre un fichero de partidas para añadirle la partida que empieza y
+ * escribe su cabecera (tamaño del tablero, fichas para ganar y jugador que
+ * empieza; ver Partida). Si el fichero no acaba en un fin de línea, porque se
+ * cortó la partida anterior, lo añade antes.
+ * @param fichero Nombre del fichero de partidas.
+ * @param inicial Tablero inicial de la partida.
+ * @param registro Flujo en el que se abre el fichero.
+ * @return true si se ha podido abrir y escribir la cabecera.
+ */
+bool AbrirRegistro(const string& fichero, const Tablero& inicial, ofstream& registro)
+{
+  bool corta = false;
+  ifstream previo(fichero.c_str(), ios::binary | ios::ate);
+  if (previo && previo.tellg() > 0)
+  {
+    previo.seekg(-1, ios::end);
+    corta = previo.get() != '\n';
+  }
+  previo.close();
+
+  // La línea de una partida sin jugadas, sin su fin de línea
+  ostringstream os;
+  os << Partida(inicial);
+  string cabecera = os.str();
+  cabecera.erase(cabecera.size() - 1);
+
+  registro.open(fichero.c_str(), ios::app);
+  if (corta)
+    registro << '\n';
+  registro << cabecera << flush;
+
+  return bool(registro);
+}
+
+/**
+ * @brief Añade una jugada a la partida del fichero de partidas y la vuelca,
+ * de modo que el fichero guarda las jugadas hechas aunque el programa acabe
+ * antes que la partida.
+ * @param registro Fichero de partidas (si no está abierto, no se hace nada).
+ * @param col Columna de la jugada.
+ */
+void AnotarJugada(ofstream& registro, int col)
+{
+  if (registro.is_open())
+    registro << ' ' << col << flush;
+}
+
 /**
  * @brief Implementa el desarrollo de una partida de Conecta 4 sobre un tablero de
  *        tamaño variable, pidiendo por teclado los movimientos de el/los jugador(es)
@@ -79,12 +131,21 @@ void ImprimeTablero(Tablero& t, Mando& m)
  * @param tablero Tablero inicial de la partida
  * @param metrica Métrica para aplicar al jugador automático (0 si los dos jugadores son
  *                humanos).
+ * @param params Parámetros del motor de búsqueda del jugador automático.
+ * @param lazy_smp Si la búsqueda alfa-beta usa varios hilos con Lazy SMP. Si
+ *                 la métrica usa un motor, al acabar se muestra su rendimiento
+ *                 (con la 5, los nodos por segundo de cada hilo y las podas de
+ *                 la búsqueda). Si se ha compilado con estadísticas, se
+ *                 muestra también su resumen.
+ * @param registro Fichero de partidas al que se añade cada jugada en cuanto
+ *                 se hace (ver AbrirRegistro), o flujo sin abrir.
  * @return Identificador (int) del jugador que gana la partida (1 o 2), o 0 en
  *         caso de empate o partida sin finalizar.
  */
-int JugarPartida(Tablero& tablero, int metrica)
+int JugarPartida(Tablero& tablero, int metrica, const ParametrosBusqueda& params,
+                 bool lazy_smp, ofstream& registro)
 {
-  JugadorAuto j2(tablero, metrica);
+  JugadorAuto j2(tablero, metrica, params, lazy_smp);
   Mando mando(tablero);
   char c = 1;
   int quienGana = 0;
@@ -96,6 +157,7 @@ int JugarPartida(Tablero& tablero, int metrica)
     if (metrica != 0 && tablero.GetTurno() == 2)
     {
       j2.turnoAutomatico(tablero);
+      AnotarJugada(registro, tablero.GetUltCol());
       system("clear");
       ImprimeTablero(tablero, mando);
       c = 1;
@@ -105,6 +167,8 @@ int JugarPartida(Tablero& tablero, int metrica)
     {
       system("clear");
       colocada = mando.actualizarJuego(c,tablero);
+      if (colocada)
+        AnotarJugada(registro, tablero.GetUltCol());
       ImprimeTablero(tablero, mando);
       if (!colocada || metrica == 0)
         c = getch();
@@ -112,26 +176,36 @@ int JugarPartida(Tablero& tablero, int metrica)
         c = 1;
     }
 
-    // Comprobar si hay ganador
-    quienGana = tablero.quienGana();
+    // Comprobar si la última ficha da la victoria a alguien
+    quienGana = tablero.quienGanaUltimo();
   }
 
   // Imprimir el tablero final
+  j2.dejarDePensar();
   c = 1;
   system("clear");
   mando.actualizarJuego(c, tablero);
   ImprimeTablero(tablero, mando);
 
+  if (metrica != 0 && j2.GetMotor())
+    j2.GetMotor()->mostrarRendimiento(cout);
+  if (metrica != 0)
+    j2.GetEstadisticas().mostrar(cout);
+
   return quienGana;
 }
 
 int main(int argc, char **argv)
 {
   int primerJugador = 1, metrica = 1, filas = 4, cols = 4;
-  bool opc_ayuda = false;
+  int fichas_ganar = Tablero::N_FICHAS_GANAR;
+  string nombre_metrica = "1";
+  string fichero_partidas;
+  ParametrosBusqueda params;
+  bool opc_ayuda = false, lazy_smp = false;
 
   // Argumentos del programa
-  if (argc > 9) {
+  if (argc > 30) {
     cout << "Error en los argumentos, utiliza -h para ver la ayuda." << endl;
     return 1;
   }
@@ -148,16 +222,74 @@ int main(int argc, char **argv)
       if (i + 1 < argc)
 	      cols  = stoi(argv[i+1]);
     }
+    else if (string(argv[i]) == "-n")
+    {
+      if (i + 1 < argc)
+	      fichas_ganar = stoi(argv[i+1]);
+    }
     else if (string(argv[i]) == "-m")
     {
       if (i + 1 < argc)
-	      metrica  = stoi(argv[i+1]);
+	      nombre_metrica = argv[i+1];
     }
     else if (string(argv[i]) == "-t")
     {
       if (i + 1 < argc)
 	      primerJugador = stoi(argv[i+1]);
     }
+    else if (string(argv[i]) == "-r")
+    {
+      if (i + 1 < argc)
+	      params.memoria_tt = stoi(argv[i+1]);
+    }
+    else if (string(argv[i]) == "-l")
+    {
+      if (i + 1 < argc)
+	      params.tiempo_ms = stoi(argv[i+1]);
+    }
+    else if (string(argv[i]) == "-u")
+    {
+      if (i + 1 < argc)
+	      params.simulaciones = stoi(argv[i+1]);
+    }
+    else if (string(argv[i]) == "-z")
+    {
+      if (i + 1 < argc)
+	      params.semilla = stoull(argv[i+1]);
+    }
+    else if (string(argv[i]) == "-j")
+    {
+      if (i + 1 < argc)
+	      params.hilos = stoi(argv[i+1]);
+    }
+    else if (string(argv[i]) == "-s")
+    {
+      lazy_smp = true;
+    }
+    else if (string(argv[i]) == "-b")
+    {
+      if (i + 1 < argc)
+	      params.libro = argv[i+1];
+    }
+    else if (string(argv[i]) == "-e")
+    {
+      if (i + 1 < argc)
+	      params.casillas_final = stoi(argv[i+1]);
+    }
+    else if (string(argv[i]) == "-a")
+    {
+      params.anticipar = true;
+    }
+    else if (string(argv[i]) == "-g")
+    {
+      if (i + 1 < argc)
+	      params.estadisticas = argv[i+1];
+    }
+    else if (string(argv[i]) == "-d")
+    {
+      if (i + 1 < argc)
+	      fichero_partidas = argv[i+1];
+    }
     else if (string(argv[i]) == "-h")
     {
 	    opc_ayuda = true;
@@ -166,19 +298,79 @@ int main(int argc, char **argv)
 
   if (opc_ayuda)
   {
-    cout << "uso: conecta4 [-f número] [-c número] [-m número] [-t número]" << endl;
+    cout << "uso: conecta4 [-f número] [-c número] [-n número] [-m métrica] [-t número]" << endl;
+    cout << "               [-r número] [-l número] [-j número] [-s] [-b fichero] [-e número]" << endl;
+    cout << "               [-u número] [-z número] [-g fichero] [-a]" << endl;
+    cout << "               [-d fichero]" << endl;
     cout << "f : especifica el número de filas" << endl;
     cout << "c : especifica el número de columnas" << endl;
-    cout << "m : especifica la métrica a utilizar (0 para jugar sin IA, 1 la más eficiente)" << endl;
+    cout << "n : especifica el número de fichas en línea para ganar (por defecto 4)" << endl;
+    cout << "m : especifica la métrica a utilizar, por número o por nombre (0 para jugar" << endl;
+    cout << "    sin IA):" << endl;
+    JugadorAuto::mostrarEstrategias(cout, "    ");
     cout << "t : especifica qué jugador tiene el primer turno (1, 2)" << endl;
+    cout << "r : especifica la memoria (MB) de la tabla de transposición (métrica 5) o del" << endl;
+    cout << "    árbol (métrica 6)" << endl;
+    cout << "l : especifica el tiempo máximo por jugada en ms (métricas 5 y 6, 0 sin límite)" << endl;
+    cout << "u : especifica las simulaciones por jugada de la métrica 6 si no hay límite" << endl;
+    cout << "    de tiempo (por defecto 20000)" << endl;
+    cout << "z : especifica la semilla de las métricas 3, 4 y 6 (por defecto 0, una" << endl;
+    cout << "    distinta en cada partida). Con la misma semilla se repite la partida" << endl;
+    cout << "j : especifica el número de hilos (0 para usar todos los núcleos)" << endl;
+    cout << "s : la métrica 5 reparte la búsqueda entre los hilos con Lazy SMP" << endl;
+    cout << "b : libro de aperturas para las métricas 1, 2, 5 y 6 (ver make libro)" << endl;
+    cout << "e : con menos casillas libres, las métricas 1, 2, 5 y 6 resuelven el final" << endl;
+    cout << "    de forma exacta (por defecto 0, nunca; p.ej. -e 14)" << endl;
+    cout << "a : las métricas 5 y 6 siguen pensando durante el turno del rival" << endl;
+    cout << "g : añade las estadísticas de cada jugada en JSON a un fichero (sólo si se" << endl;
+    cout << "    ha compilado con make ESTADISTICAS=1)" << endl;
+    cout << "d : añade la partida a un fichero de partidas (ver analizar); cada jugada" << endl;
+    cout << "    se escribe en cuanto se hace" << endl;
     return 0;
   }
 
+  if (fichas_ganar < 2 || fichas_ganar > Tablero::MAX_FICHAS_GANAR)
+  {
+    cout << "Error: el número de fichas para ganar debe estar entre 2 y "
+         << Tablero::MAX_FICHAS_GANAR << "." << endl;
+    return 1;
+  }
+
+  JugadorAuto::Estrategia estrategia;
+  if (nombre_metrica == "0")
+    metrica = 0;
+  else if (JugadorAuto::buscarEstrategia(nombre_metrica, estrategia))
+    metrica = estrategia.numero;
+  else
+  {
+    cout << "Error: no hay ninguna métrica " << nombre_metrica << "." << endl;
+    return 1;
+  }
+
+  // Las métricas que usan el árbol guardan los tableros como Posicion, y la
+  // de Monte Carlo los simula en un bitboard
+  if (metrica != 0 && estrategia.cabe && !estrategia.cabe(filas, cols))
+  {
+    cout << "Error: la métrica " << metrica << " no admite tableros de "
+         << filas << "x" << cols << "." << endl;
+    return 1;
+  }
+
   // Jugar partida
-  Tablero tablero(filas, cols);
+  Tablero tablero(filas, cols, fichas_ganar);
   if (primerJugador == 2)
     tablero.cambiarTurno();
-  int ganador = JugarPartida(tablero, metrica);
+  ofstream registro;
+  if (!fichero_partidas.empty() && !AbrirRegistro(fichero_partidas, tablero, registro))
+  {
+    cout << "Error: no se ha podido escribir en " << fichero_partidas << endl;
+    return 1;
+  }
+
+  int ganador = JugarPartida(tablero, metrica, params, lazy_smp, registro);
+
+  if (registro.is_open() && !(registro << '\n' << flush))
+    cout << "Error: no se ha podido escribir en " << fichero_partidas << endl;
 
   // Mostrar ganador
   if (ganador == 0)
@@ -0,0 +1,119 @@
+/**
+ * @file estadisticas.cpp
+ * @brief Implementación de funciones del TDA Estadisticas
+ *
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include "estadisticas.h"
+
+using namespace std;
+
+const char *Estadisticas::NOMBRE_FASE[NUM_FASES] =
+  {"libro", "resolvedor", "arbol", "gana_inmediato", "evita_perder",
+   "mayor_puntuacion", "busqueda"};
+
+// Funciones auxiliares
+namespace
+{
+  mutex cerrojo;    ///< Varios jugadores pueden escribir en el mismo fichero
+}
+
+/* _________________________________________________________________________ */
+
+Estadisticas::Jugada::Jugada()
+  : numero(0), jugador(0), metrica(0), columna(-1), expandidos(0), evaluados(0),
+    nodos_busqueda(0), cortes(0), profundidad(0), nodos_resolvedor(0),
+    memoria_arbol(0)
+{
+  for (int f = 0; f < NUM_FASES; f++)
+    segundos[f] = 0;
+}
+
+/* _________________________________________________________________________ */
+
+Estadisticas::Estadisticas(const string& f)
+  : jugadas(0), fichero(f)
+{
+}
+
+/* _________________________________________________________________________ */
+
+void Estadisticas::escribirJSON(ostream& os, const Jugada& j)
+{
+  os << "{\"jugada\":" << j.numero << ",\"jugador\":" << j.jugador
+     << ",\"metrica\":" << j.metrica
+     << ",\"columna\":" << j.columna << ",\"origen\":\"" << j.origen << "\""
+     << ",\"nodos_expandidos\":" << j.expandidos
+     << ",\"nodos_evaluados\":" << j.evaluados << ",\"nodos_por_nivel\":[";
+  for (size_t n = 1; n < j.por_nivel.size(); n++)
+    os << (n > 1 ? "," : "") << j.por_nivel[n];
+  os << "],\"nodos_busqueda\":" << j.nodos_busqueda << ",\"cortes\":" << j.cortes
+     << ",\"profundidad\":" << j.profundidad
+     << ",\"nodos_resolvedor\":" << j.nodos_resolvedor
+     << ",\"memoria_arbol\":" << j.memoria_arbol << ",\"tiempo_us\":{";
+  for (int f = 0; f < NUM_FASES; f++)
+    os << (f > 0 ? "," : "") << "\"" << NOMBRE_FASE[f] << "\":"
+       << (long) (j.segundos[f] * 1e6);
+  os << "}}" << endl;
+}
+
+/* _________________________________________________________________________ */
+
+void Estadisticas::terminarJugada()
+{
+  if (!ACTIVAS)
+    return;
+
+  jugadas++;
+  total.expandidos += actual.expandidos;
+  total.evaluados += actual.evaluados;
+  if (total.por_nivel.size() < actual.por_nivel.size())
+    total.por_nivel.resize(actual.por_nivel.size(), 0);
+  for (size_t n = 0; n < actual.por_nivel.size(); n++)
+    total.por_nivel[n] += actual.por_nivel[n];
+  total.nodos_busqueda += actual.nodos_busqueda;
+  total.cortes += actual.cortes;
+  total.profundidad = max(total.profundidad, actual.profundidad);
+  total.nodos_resolvedor += actual.nodos_resolvedor;
+  total.memoria_arbol = max(total.memoria_arbol, actual.memoria_arbol);
+  for (int f = 0; f < NUM_FASES; f++)
+    total.segundos[f] += actual.segundos[f];
+
+  if (!fichero.empty())
+  {
+    lock_guard<mutex> lock(cerrojo);
+    ofstream salida(fichero.c_str(), ios::app);
+    escribirJSON(salida, actual);
+  }
+
+  actual = Jugada();
+}
+
+/* _________________________________________________________________________ */
+
+void Estadisticas::mostrar(ostream& os) const
+{
+  if (!ACTIVAS)
+    return;
+
+  os << "Jugadas: " << jugadas << endl;
+  os << "Árbol: " << total.expandidos << " nodos expandidos, "
+     << total.evaluados << " puntuados, hasta " << total.memoria_arbol
+     << " bytes" << endl;
+  os << "Nodos por nivel:";
+  for (size_t n = 1; n < total.por_nivel.size(); n++)
+    os << " " << total.por_nivel[n];
+  os << endl;
+  os << "Búsqueda: " << total.nodos_busqueda << " nodos, " << total.cortes
+     << " podas, profundidad máxima " << total.profundidad << endl;
+  os << "Resolvedor: " << total.nodos_resolvedor << " nodos" << endl;
+  os << "Tiempo (ms):";
+  for (int f = 0; f < NUM_FASES; f++)
+    os << " " << NOMBRE_FASE[f] << " " << total.segundos[f] * 1e3;
+  os << endl;
+}
+
+/* Fin fichero: estadisticas.cpp */
@@ -0,0 +1,468 @@
+/**
+ * @file evaluador.cpp
+ * @brief Implementación de funciones del TDA Evaluador
+ *
+ */
+
+#include "evaluador.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+  #define EVALUADOR_X86
+  #include <immintrin.h>
+#endif
+
+using namespace std;
+
+const char *Evaluador::NOMBRE_IMPLEMENTACION[MEJOR] = {"escalar", "sse2", "avx2"};
+
+// Funciones auxiliares
+namespace
+{
+  /**
+   * @brief Desplaza una máscara n bits hacia las casillas de menor índice.
+   * Los desplazamientos de 64 bits o más dejan la máscara vacía.
+   */
+  inline uint64_t desplazar(uint64_t b, int n)
+  {
+    return n < 64 ? b >> n : 0;
+  }
+
+  /**
+   * @brief Suma las alineaciones de la última ficha en los dos sentidos de
+   * una dirección, con el desplazamiento y las fichas para ganar fijos.
+   * Hace lo mismo que cada vuelta de Evaluador::alineadasGenerica.
+   */
+  template <int DESP, int N>
+  inline void alineadasDireccion(uint64_t propias, uint64_t ultima, uint64_t validos,
+                                 int& alineadas1, int& alineadas2)
+  {
+    uint64_t delante = ~(uint64_t)0, detras = ~(uint64_t)0;
+    for (int k = 1; k < N - 1; k++)
+    {
+      delante = validos & ((propias & delante) >> DESP);
+      detras = (propias & detras & validos) << DESP;
+      if (k == N - 3)
+        alineadas2 += ((delante & ultima) != 0) + ((detras & ultima) != 0);
+      if (k == N - 2)
+        alineadas1 += ((delante & ultima) != 0) + ((detras & ultima) != 0);
+    }
+  }
+
+  /**
+   * @brief Cuenta las alineaciones de la última ficha en un tablero de
+   * FILAS x COLUMNAS en el que se gana con N fichas en línea. Hace lo mismo
+   * que Evaluador::alineadasGenerica, pero todas las máscaras son
+   * constantes y los bucles se desenrollan.
+   */
+  template <int FILAS, int COLUMNAS, int N>
+  void alineadasFija(const Evaluador&, uint64_t propias, uint64_t ultima,
+                     int& alineadas1, int& alineadas2)
+  {
+    static_assert(FILAS > 1 && FILAS * COLUMNAS <= 64,
+                  "El tablero debe caber en una máscara");
+
+    constexpr uint64_t LLENO = Tablero::mascaraLleno(FILAS, COLUMNAS);
+    constexpr uint64_t FILA_INF = Tablero::mascaraFilaInf(FILAS, COLUMNAS);
+    constexpr uint64_t SIN_FILA_SUP = LLENO & ~(FILA_INF << (FILAS - 1));
+    constexpr uint64_t SIN_FILA_INF = LLENO & ~FILA_INF;
+    constexpr uint64_t SIN_ULT_COL = LLENO >> FILAS;
+
+    alineadas1 = (N - 1 == 1) ? 8 : 0;
+    alineadas2 = (N - 2 == 1) ? 8 : 0;
+    alineadasDireccion<1, N>(propias, ultima, SIN_FILA_SUP, alineadas1, alineadas2);
+    alineadasDireccion<FILAS, N>(propias, ultima, SIN_ULT_COL, alineadas1, alineadas2);
+    alineadasDireccion<FILAS - 1, N>(propias, ultima, SIN_FILA_INF & SIN_ULT_COL,
+                                     alineadas1, alineadas2);
+    alineadasDireccion<FILAS + 1, N>(propias, ultima, SIN_FILA_SUP & SIN_ULT_COL,
+                                     alineadas1, alineadas2);
+  }
+
+  /**
+   * @brief Instancia de alineadasFija para un tamaño de tablero.
+   */
+  struct Especializacion
+  {
+    int filas;
+    int columnas;
+    int fichas_ganar;
+    void (*contador)(const Evaluador&, uint64_t, uint64_t, int&, int&);
+  };
+
+  /// Los mismos tamaños que tienen detector de líneas en el Tablero
+  const Especializacion ESPECIALIZACIONES[] =
+  {
+    {6, 7, 4, alineadasFija<6, 7, 4> },
+    {4, 4, 4, alineadasFija<4, 4, 4> },
+    {5, 6, 4, alineadasFija<5, 6, 4> },
+    {6, 6, 4, alineadasFija<6, 6, 4> },
+    {7, 7, 4, alineadasFija<7, 7, 4> },
+    {6, 9, 4, alineadasFija<6, 9, 4> },
+    {7, 9, 4, alineadasFija<7, 9, 4> },
+    {6, 7, 5, alineadasFija<6, 7, 5> },
+    {8, 8, 5, alineadasFija<8, 8, 5> },
+    {3, 3, 3, alineadasFija<3, 3, 3> }
+  };
+}
+
+/* _________________________________________________________________________ */
+
+Evaluador::Evaluador()
+  : filas(0), columnas(0), fichas_ganar(Tablero::N_FICHAS_GANAR), mascaras(false),
+    impl(ESCALAR), planos(0), contador(&Evaluador::alineadasGenerica)
+{
+  for (int d = 0; d < 4; d++)
+    desp[d] = inicio[d] = validos[d] = 0;
+}
+
+/* _________________________________________________________________________ */
+
+Evaluador::Evaluador(int filas, int columnas, int fichas_ganar, Implementacion i)
+  : filas(filas), columnas(columnas), fichas_ganar(fichas_ganar),
+    mascaras(cabe(filas, columnas)), impl(i), planos(0),
+    contador(&Evaluador::alineadasGenerica)
+{
+  // Si el procesador no admite la implementación pedida, se usa la mejor
+  Implementacion mejor = mejorImplementacion();
+  if (impl == MEJOR || impl > mejor)
+    impl = mejor;
+
+  // Número de bits necesarios para contar hasta fichas_ganar
+  while ((1 << planos) <= fichas_ganar)
+    planos++;
+
+  for (int d = 0; d < 4; d++)
+    desp[d] = inicio[d] = validos[d] = 0;
+  if (!mascaras)
+    return;
+
+  // Máscaras del tablero, con la misma numeración que los bitboards
+  uint64_t lleno = 0, fila_inf = 0;
+  uint64_t columna = ((uint64_t)1 << filas) - 1;
+  for (int j = 0; j < columnas; j++)
+  {
+    lleno |= columna << (j * filas);
+    fila_inf |= (uint64_t)1 << (j * filas);
+  }
+
+  uint64_t sin_fila_sup = lleno & ~(fila_inf << (filas - 1));
+  uint64_t sin_fila_inf = lleno & ~fila_inf;
+  uint64_t sin_ult_col = lleno >> filas;
+  const int d_casilla[4] = {1, filas, filas - 1, filas + 1};
+  validos[0] = sin_fila_sup;
+  validos[1] = sin_ult_col;
+  validos[2] = sin_fila_inf & sin_ult_col;
+  validos[3] = sin_fila_sup & sin_ult_col;
+
+  for (int d = 0; d < 4; d++)
+  {
+    // Casillas en las que empieza una ventana completa en esta dirección
+    desp[d] = d_casilla[d];
+    inicio[d] = lleno;
+    for (int k = 0; k < fichas_ganar - 1; k++)
+      inicio[d] &= desplazar(validos[d], k * d_casilla[d]);
+  }
+
+  for (const Especializacion& e : ESPECIALIZACIONES)
+    if (e.filas == filas && e.columnas == columnas && e.fichas_ganar == fichas_ganar)
+      contador = e.contador;
+}
+
+/* _________________________________________________________________________ */
+
+Evaluador::Implementacion Evaluador::mejorImplementacion()
+{
+#ifdef EVALUADOR_X86
+  static const Implementacion mejor =
+    __builtin_cpu_supports("avx2") ? AVX2
+    : (__builtin_cpu_supports("sse2") ? SSE2 : ESCALAR);
+  return mejor;
+#else
+  return ESCALAR;
+#endif
+}
+
+/* _________________________________________________________________________ */
+
+void Evaluador::contar(uint64_t fichas1, uint64_t fichas2,
+                       int ventanas[2][Tablero::MAX_FICHAS_GANAR + 1]) const
+{
+  for (int j = 0; j < 2; j++)
+    for (int k = 0; k <= Tablero::MAX_FICHAS_GANAR; k++)
+      ventanas[j][k] = 0;
+
+  switch (impl)
+  {
+    case AVX2: contarAVX2(fichas1, fichas2, ventanas); break;
+    case SSE2: contarSSE2(fichas1, fichas2, ventanas); break;
+    default:   contarEscalar(fichas1, fichas2, ventanas); break;
+  }
+}
+
+/* _________________________________________________________________________ */
+
+void Evaluador::contar(const Tablero& t, int ventanas[2][Tablero::MAX_FICHAS_GANAR + 1]) const
+{
+  if (mascaras && t.UsaBitboard())
+    contar(t.GetMascara(1), t.GetMascara(2), ventanas);
+  else
+    t.contarVentanas(ventanas);
+}
+
+/* _________________________________________________________________________ */
+
+void Evaluador::contar(const Posicion& p, int ventanas[2][Tablero::MAX_FICHAS_GANAR + 1]) const
+{
+  if (mascaras)
+    contar(p.GetMascara(1), p.GetMascara(2), ventanas);
+  else
+    p.aTablero().contarVentanas(ventanas);
+}
+
+/* _________________________________________________________________________ */
+
+void Evaluador::contarEscalar(uint64_t fichas1, uint64_t fichas2,
+                              int ventanas[2][Tablero::MAX_FICHAS_GANAR + 1]) const
+{
+  const uint64_t fichas[2] = {fichas1, fichas2};
+
+  for (int d = 0; d < 4; d++)
+  {
+    for (int jug = 0; jug < 2; jug++)
+    {
+      // Sumamos en paralelo las fichas propias de todas las ventanas: el
+      // bit p del plano b es el bit b de la cuenta de la ventana que empieza en p
+      uint64_t plano[4] = {0, 0, 0, 0};
+      uint64_t propias = fichas[jug], rival = fichas[1 - jug], cubre = 0;
+      for (int k = 0; k < fichas_ganar; k++)
+      {
+        uint64_t acarreo = propias;
+        for (int b = 0; b < planos && acarreo; b++)
+        {
+          uint64_t t = plano[b] & acarreo;
+          plano[b] ^= acarreo;
+          acarreo = t;
+        }
+        cubre |= rival;
+        propias = desplazar(propias, desp[d]);
+        rival = desplazar(rival, desp[d]);
+      }
+
+      uint64_t abiertas = inicio[d] & ~cubre;
+      for (int c = 0; c <= fichas_ganar && abiertas; c++)
+      {
+        uint64_t iguales = abiertas;
+        for (int b = 0; b < planos; b++)
+          iguales &= ((c >> b) & 1) ? plano[b] : ~plano[b];
+        ventanas[jug][c] += __builtin_popcountll(iguales);
+      }
+    }
+  }
+}
+
+/* _________________________________________________________________________ */
+
+#ifdef EVALUADOR_X86
+
+// Los dos carriles de 64 bits son los dos jugadores; las direcciones se
+// recorren una a una, porque SSE2 desplaza los dos carriles lo mismo
+__attribute__((target("sse2")))
+void Evaluador::contarSSE2(uint64_t fichas1, uint64_t fichas2,
+                           int ventanas[2][Tablero::MAX_FICHAS_GANAR + 1]) const
+{
+  const __m128i todos = _mm_set1_epi32(-1);
+
+  for (int d = 0; d < 4; d++)
+  {
+    __m128i cuenta = _mm_cvtsi32_si128((int) desp[d]);
+    __m128i fichas = _mm_set_epi64x(fichas2, fichas1);
+    __m128i plano[4], cubre = _mm_setzero_si128();
+    for (int b = 0; b < planos; b++)
+      plano[b] = _mm_setzero_si128();
+
+    for (int k = 0; k < fichas_ganar; k++)
+    {
+      __m128i acarreo = fichas;
+      for (int b = 0; b < planos; b++)
+      {
+        __m128i t = _mm_and_si128(plano[b], acarreo);
+        plano[b] = _mm_xor_si128(plano[b], acarreo);
+        acarreo = t;
+      }
+      cubre = _mm_or_si128(cubre, fichas);
+      fichas = _mm_srl_epi64(fichas, cuenta);
+    }
+
+    // Las casillas que cubre cada jugador son las del rival del otro carril
+    __m128i rival = _mm_shuffle_epi32(cubre, _MM_SHUFFLE(1, 0, 3, 2));
+    __m128i abiertas = _mm_andnot_si128(rival, _mm_set1_epi64x(inicio[d]));
+
+    for (int c = 0; c <= fichas_ganar; c++)
+    {
+      __m128i iguales = abiertas;
+      for (int b = 0; b < planos; b++)
+        iguales = _mm_and_si128(iguales, ((c >> b) & 1) ? plano[b]
+                                         : _mm_xor_si128(plano[b], todos));
+
+      uint64_t carril[2];
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(carril), iguales);
+      ventanas[0][c] += __builtin_popcountll(carril[0]);
+      ventanas[1][c] += __builtin_popcountll(carril[1]);
+    }
+  }
+}
+
+/* _________________________________________________________________________ */
+
+// Los cuatro carriles de 64 bits son las cuatro direcciones, que AVX2 puede
+// desplazar cada una lo suyo
+__attribute__((target("avx2,popcnt")))
+void Evaluador::contarAVX2(uint64_t fichas1, uint64_t fichas2,
+                           int ventanas[2][Tablero::MAX_FICHAS_GANAR + 1]) const
+{
+  const uint64_t fichas[2] = {fichas1, fichas2};
+  const __m256i todos = _mm256_set1_epi32(-1);
+  const __m256i cuenta = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(desp));
+  const __m256i comienzo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inicio));
+
+  for (int jug = 0; jug < 2; jug++)
+  {
+    __m256i propias = _mm256_set1_epi64x(fichas[jug]);
+    __m256i rival = _mm256_set1_epi64x(fichas[1 - jug]);
+    __m256i plano[4], cubre = _mm256_setzero_si256();
+    for (int b = 0; b < planos; b++)
+      plano[b] = _mm256_setzero_si256();
+
+    for (int k = 0; k < fichas_ganar; k++)
+    {
+      __m256i acarreo = propias;
+      for (int b = 0; b < planos; b++)
+      {
+        __m256i t = _mm256_and_si256(plano[b], acarreo);
+        plano[b] = _mm256_xor_si256(plano[b], acarreo);
+        acarreo = t;
+      }
+      cubre = _mm256_or_si256(cubre, rival);
+      propias = _mm256_srlv_epi64(propias, cuenta);
+      rival = _mm256_srlv_epi64(rival, cuenta);
+    }
+
+    __m256i abiertas = _mm256_andnot_si256(cubre, comienzo);
+
+    for (int c = 0; c <= fichas_ganar; c++)
+    {
+      __m256i iguales = abiertas;
+      for (int b = 0; b < planos; b++)
+        iguales = _mm256_and_si256(iguales, ((c >> b) & 1) ? plano[b]
+                                            : _mm256_xor_si256(plano[b], todos));
+
+      uint64_t carril[4];
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(carril), iguales);
+      ventanas[jug][c] += __builtin_popcountll(carril[0]) + __builtin_popcountll(carril[1])
+                          + __builtin_popcountll(carril[2]) + __builtin_popcountll(carril[3]);
+    }
+  }
+}
+
+#else
+
+// Sin instrucciones vectoriales de x86 nunca se eligen SSE2 ni AVX2
+
+/* _________________________________________________________________________ */
+
+void Evaluador::contarSSE2(uint64_t fichas1, uint64_t fichas2,
+                           int ventanas[2][Tablero::MAX_FICHAS_GANAR + 1]) const
+{
+  contarEscalar(fichas1, fichas2, ventanas);
+}
+
+/* _________________________________________________________________________ */
+
+void Evaluador::contarAVX2(uint64_t fichas1, uint64_t fichas2,
+                           int ventanas[2][Tablero::MAX_FICHAS_GANAR + 1]) const
+{
+  contarEscalar(fichas1, fichas2, ventanas);
+}
+
+#endif
+
+void Evaluador::contarAlineadas(const Posicion& p, int& alineadas1, int& alineadas2) const
+{
+  alineadas1 = alineadas2 = -1;
+  if (p.estaVacio())
+    return;
+
+  int n1 = fichas_ganar - 1, n2 = fichas_ganar - 2;
+  if (!mascaras)
+  {
+    alineadas1 = alineadasCasillas(p, n1);
+    alineadas2 = alineadasCasillas(p, n2);
+    return;
+  }
+
+  int fila = p.GetUltFila(), col = p.GetUltCol();
+  uint64_t propias = p.GetMascara(p.GetElemento(fila, col));
+  uint64_t ultima = (uint64_t)1 << (col * filas + (filas - 1 - fila));
+  contador(*this, propias, ultima, alineadas1, alineadas2);
+}
+
+/* _________________________________________________________________________ */
+
+void Evaluador::alineadasGenerica(const Evaluador& e, uint64_t propias, uint64_t ultima,
+                                  int& alineadas1, int& alineadas2)
+{
+  int n1 = e.fichas_ganar - 1, n2 = e.fichas_ganar - 2;
+
+  // Con n = 1 la ficha sola ya forma la línea en todas las direcciones; con
+  // n = 0, en ninguna
+  alineadas1 = (n1 == 1) ? 8 : 0;
+  alineadas2 = (n2 == 1) ? 8 : 0;
+
+  for (int d = 0; d < 4; d++)
+  {
+    // Tras k pasos, delante tiene las casillas con k fichas propias seguidas
+    // en el sentido de la dirección, y detras las que las tienen en el
+    // contrario
+    uint64_t delante = ~(uint64_t)0, detras = ~(uint64_t)0;
+    for (int k = 1; k < n1; k++)
+    {
+      delante = e.validos[d] & desplazar(propias & delante, e.desp[d]);
+      detras = ((propias & detras & e.validos[d]) << e.desp[d]);
+      if (k == n2 - 1)
+        alineadas2 += ((delante & ultima) != 0) + ((detras & ultima) != 0);
+      if (k == n1 - 1)
+        alineadas1 += ((delante & ultima) != 0) + ((detras & ultima) != 0);
+    }
+  }
+}
+
+/* _________________________________________________________________________ */
+
+int Evaluador::alineadasCasillas(const Posicion& p, int n)
+{
+  // Las 8 direcciones posibles
+  const int DIRECCIONES[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1},
+                                 {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+  int fila = p.GetUltFila(), col = p.GetUltCol();
+  int ficha = p.GetElemento(fila, col);
+  int encontradas = 0;
+
+  for (int d = 0; d < 8; d++)
+  {
+    // La propia ficha cuenta como una ficha alineada
+    int alineados = 1;
+    int i = fila + DIRECCIONES[d][0], j = col + DIRECCIONES[d][1];
+    while (alineados < n && i >= 0 && i < p.GetFilas() && j >= 0
+           && j < p.GetColumnas() && p.GetElemento(i, j) == ficha)
+    {
+      alineados++;
+      i += DIRECCIONES[d][0];
+      j += DIRECCIONES[d][1];
+    }
+    if (alineados == n)
+      encontradas++;
+  }
+
+  return encontradas;
+}
+
+/* Fin fichero: evaluador.cpp */
@@ -0,0 +1,142 @@
+/**
+ * @file generar_libro.cpp
+ * @brief Genera el libro de aperturas de un tamaño de tablero
+ *
+ * Este programa recorre todas las posiciones a las que se puede llegar desde
+ * el tablero vacío con menos de un número dado de fichas, busca la mejor
+ * columna de cada una con el motor alfa-beta y guarda el resultado en un
+ * fichero que el jugador automático puede usar como LibroAperturas.
+ *
+ * Para ver la lista de argumentos que admite, ejecutar el programa
+ * con el modificador -h para ver la ayuda.
+ */
+
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+#include "busqueda.h"
+#include "grupo_hilos.h"
+#include "libro_aperturas.h"
+#include "tablero.h"
+
+using namespace std;
+
+/**
+ * @brief Añade a un vector, sin repetir, las posiciones que se alcanzan
+ *        desde un tablero colocando menos de un número de fichas.
+ * @param t Tablero actual. Se modifica, pero se devuelve en el mismo estado.
+ * @param quedan Fichas que aún se pueden colocar, más una
+ * @param vistas Claves de las posiciones ya encontradas
+ * @param posiciones Posiciones encontradas, en el orden en que se encuentran
+ */
+void RecorrerPosiciones(Tablero& t, int quedan, set<uint64_t>& vistas,
+                        vector<Tablero>& posiciones)
+{
+  if (quedan == 0 || t.estaLleno() || t.quienGanaUltimo()
+      || !vistas.insert(t.GetClave()).second)
+    return;
+
+  posiciones.push_back(t);
+
+  int col_anterior = t.GetUltCol();
+  for (int col = 0; col < t.GetColumnas(); col++)
+  {
+    if (t.hayHueco(col) > -1)
+    {
+      t.colocarFicha(col);
+      t.cambiarTurno();
+      RecorrerPosiciones(t, quedan - 1, vistas, posiciones);
+      t.cambiarTurno();
+      t.quitarFicha(col, col_anterior);
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int filas = 6, cols = 7, fichas = 4, hilos = 0;
+  string fichero;
+  ParametrosBusqueda params;
+  bool opc_ayuda = false;
+
+  params.profundidad = 12;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (string(argv[i]) == "-f" && i + 1 < argc)
+      filas = stoi(argv[++i]);
+    else if (string(argv[i]) == "-c" && i + 1 < argc)
+      cols = stoi(argv[++i]);
+    else if (string(argv[i]) == "-k" && i + 1 < argc)
+      fichas = stoi(argv[++i]);
+    else if (string(argv[i]) == "-p" && i + 1 < argc)
+      params.profundidad = stoi(argv[++i]);
+    else if (string(argv[i]) == "-r" && i + 1 < argc)
+      params.memoria_tt = stoi(argv[++i]);
+    else if (string(argv[i]) == "-j" && i + 1 < argc)
+      hilos = stoi(argv[++i]);
+    else if (string(argv[i]) == "-o" && i + 1 < argc)
+      fichero = argv[++i];
+    else
+      opc_ayuda = true;
+  }
+
+  if (opc_ayuda || fichero.empty())
+  {
+    cout << "uso: generar_libro -o fichero [-f número] [-c número] [-k número] [-p número]" << endl;
+    cout << "                   [-r número] [-j número]" << endl;
+    cout << "o : fichero donde se escribe el libro" << endl;
+    cout << "f : especifica el número de filas (por defecto 6)" << endl;
+    cout << "c : especifica el número de columnas (por defecto 7)" << endl;
+    cout << "k : guarda las posiciones con menos de k fichas (por defecto 4)" << endl;
+    cout << "p : profundidad de la búsqueda de cada posición (por defecto 12)" << endl;
+    cout << "r : memoria (en MB) de la tabla de transposición de cada hilo" << endl;
+    cout << "j : número de hilos (por defecto todos los núcleos)" << endl;
+    return 1;
+  }
+
+  // Posiciones del libro
+  Tablero inicial(filas, cols);
+  set<uint64_t> vistas;
+  vector<Tablero> posiciones;
+  RecorrerPosiciones(inicial, fichas, vistas, posiciones);
+
+  // Las posiciones se buscan por bloques consecutivos, cada uno con su propio
+  // motor. Así el resultado no depende del número de hilos, y las posiciones
+  // de un bloque (que comparten jugadas) aprovechan la misma tabla
+  const int BLOQUE = 64;
+  int num_bloques = (posiciones.size() + BLOQUE - 1) / BLOQUE;
+  vector<LibroAperturas::Entrada> entradas(posiciones.size());
+  GrupoHilos grupo(hilos);
+
+  cout << "Buscando " << posiciones.size() << " posiciones con profundidad "
+       << params.profundidad << " (" << grupo.size() << " hilos)..." << endl;
+
+  grupo.ejecutar(num_bloques, [&](int b) {
+    Busqueda busqueda(params);
+    for (size_t i = b * BLOQUE; i < posiciones.size() && i < (size_t) (b + 1) * BLOQUE; i++)
+    {
+      entradas[i].clave = posiciones[i].GetClave();
+      entradas[i].columna = busqueda.mejorMovimiento(posiciones[i]);
+      entradas[i].reservado = 0;
+    }
+  });
+
+  LibroAperturas::Cabecera cabecera;
+  cabecera.filas = filas;
+  cabecera.columnas = cols;
+  cabecera.fichas = fichas;
+  cabecera.profundidad = params.profundidad;
+
+  if (!LibroAperturas::escribir(fichero, cabecera, entradas))
+  {
+    cout << "Error: no se ha podido escribir " << fichero << endl;
+    return 1;
+  }
+
+  cout << "Libro escrito en " << fichero << endl;
+  return 0;
+}
+
+/* Fin fichero: generar_libro.cpp */
@@ -0,0 +1,106 @@
+/**
+ * @file grupo_hilos.cpp
+ * @brief Implementación de funciones del TDA GrupoHilos
+ *
+ */
+
+#include "grupo_hilos.h"
+
+using namespace std;
+
+/* _________________________________________________________________________ */
+
+GrupoHilos::GrupoHilos(int num_hilos)
+  : num_tareas(0), siguiente(0), trabajando(0), lote(0), terminar(false)
+{
+  if (num_hilos <= 0)
+    num_hilos = thread::hardware_concurrency();
+  if (num_hilos <= 0)
+    num_hilos = 1;
+
+  for (int i = 1; i < num_hilos; i++)
+    hilos.push_back(thread(&GrupoHilos::trabajar, this));
+}
+
+/* _________________________________________________________________________ */
+
+GrupoHilos::~GrupoHilos()
+{
+  {
+    lock_guard<mutex> lock(cerrojo);
+    terminar = true;
+  }
+  hay_lote.notify_all();
+
+  for (size_t i = 0; i < hilos.size(); i++)
+    hilos[i].join();
+}
+
+/* _________________________________________________________________________ */
+
+void GrupoHilos::repartir()
+{
+  for (int i = siguiente++; i < num_tareas; i = siguiente++)
+    tarea(i);
+}
+
+/* _________________________________________________________________________ */
+
+void GrupoHilos::trabajar()
+{
+  long visto = 0;
+
+  while (true)
+  {
+    {
+      unique_lock<mutex> lock(cerrojo);
+      while (!terminar && lote == visto)
+        hay_lote.wait(lock);
+      if (terminar)
+        return;
+      visto = lote;
+    }
+
+    repartir();
+
+    {
+      lock_guard<mutex> lock(cerrojo);
+      if (--trabajando == 0)
+        lote_terminado.notify_one();
+    }
+  }
+}
+
+/* _________________________________________________________________________ */
+
+void GrupoHilos::ejecutar(int n, const function<void(int)>& f)
+{
+  // Sin hilos de trabajo no hace falta sincronizar nada
+  if (hilos.empty())
+  {
+    for (int i = 0; i < n; i++)
+      f(i);
+    return;
+  }
+
+  {
+    lock_guard<mutex> lock(cerrojo);
+    tarea = f;
+    num_tareas = n;
+    siguiente = 0;
+    trabajando = hilos.size();
+    lote++;
+  }
+  hay_lote.notify_all();
+
+  // El hilo que llama también ejecuta tareas
+  repartir();
+
+  // Esperar a que todos los hilos hayan salido del lote, para que ninguno
+  // siga usando la tarea cuando se lance el siguiente
+  unique_lock<mutex> lock(cerrojo);
+  while (trabajando > 0)
+    lote_terminado.wait(lock);
+}
+
+/* Fin fichero: grupo_hilos.cpp */
@@ -4,90 +4,202 @@
  *
  */
 
-#include <ctime>
-#include <cstdlib>
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <utility>
 #include "jugador_auto.h"
+#include "monte_carlo.h"
 
 // Funciones auxiliares
 namespace
 {
   /**
-   * Genera un entero aleatorio en el rango [min,max]
+   * @brief Motor de la métrica 4: juega en una columna libre al azar.
    */
-  int GeneraEnteroAleatorio(int min, int max)
+  class MotorAleatorio : public Motor
   {
-    int tam = max - min + 1;
-    return ((rand() % tam) + min);
+    private:
+      Aleatorio aleatorio;
+
+    public:
+      MotorAleatorio(uint64_t semilla) : aleatorio(semilla) { }
+
+      int mejorMovimiento(const Tablero& t)
+      {
+        int col;
+        do
+        {
+          col = aleatorio.entre(0, t.GetColumnas() - 1);
+        } while (t.hayHueco(col) < 0);
+
+        return col;
+      }
+
+      long GetNodos() const { return 0; }
+  };
+
+  /**
+   * @brief Crea el motor de la métrica 4.
+   */
+  unique_ptr<Motor> CrearAleatorio(const Tablero& inicial,
+                                   const ParametrosBusqueda& params, bool lazy_smp)
+  {
+    return unique_ptr<Motor>(new MotorAleatorio(params.semilla));
   }
 
   /**
-   * @brief Devuelve cuántas alineaciones de nRaya fichas hay en un tablero
-   * dado, para el último jugador que insertó ficha.
-   * @param tab Tablero donde buscar las alineaciones
-   * @param nRaya Número de fichas en línea a buscar
+   * @brief Crea el motor de la métrica 5. Sólo usa varios hilos con Lazy SMP.
    */
-  int cantidadAlineada(const Tablero& tab, int nRaya)
+  unique_ptr<Motor> CrearAlfaBeta(const Tablero& inicial,
+                                  const ParametrosBusqueda& params, bool lazy_smp)
   {
-    // Estructura para representar una dirección
-    struct Direccion
-    {
-      int i;
-      int j;
-    };
+    ParametrosBusqueda params_busqueda(params);
+    if (!lazy_smp)
+      params_busqueda.hilos = 1;
+    return unique_ptr<Motor>(new Busqueda(params_busqueda));
+  }
 
-    // Almaceno las 8 direcciones posibles
-    Direccion direccion[8] = {{-1,-1},{-1, 0},{-1, 1},{0, -1},{0, 1},{1, -1},{1, 0},{1, 1}};
-    // Nº de n-lineas encontradas (-1 si ha habido fallos)
-    int encontrados = -1;
+  /**
+   * @brief Crea el motor de la métrica 6, con params.hilos hilos.
+   */
+  unique_ptr<Motor> CrearMonteCarlo(const Tablero& inicial,
+                                    const ParametrosBusqueda& params, bool lazy_smp)
+  {
+    return unique_ptr<Motor>(new MonteCarlo(inicial, params));
+  }
+
+  /**
+   * @brief Indica si la partida ha terminado en una posición: la última
+   * ficha ha ganado o no quedan huecos.
+   */
+  bool terminada(const Posicion& p)
+  {
+    if (p.quienGanaUltimo())
+      return true;
+    for (int col = 0; col < p.GetColumnas(); col++)
+      if (p.hayHueco(col) > -1)
+        return false;
+    return true;
+  }
 
-    if (!tab.estaVacio())
+  /**
+   * @brief Puntos de las métricas 2 y 3: sólo la puntuación básica.
+   */
+  struct PuntosBasicos
+  {
+    static const bool ALINEADAS = false;
+    static void sumar(JugadorAuto::Solucion& sol) { }
+  };
+
+  /**
+   * @brief Puntos de la métrica 1: 0.25 por cada 3 en raya, 0.0625 por cada
+   * 2 en raya de la última ficha y (N - lvl) más.
+   */
+  struct PuntosAlineadas
+  {
+    static const bool ALINEADAS = true;
+    static void sumar(JugadorAuto::Solucion& sol)
     {
-      encontrados = 0;
-      int col = tab.GetUltCol();
-      int fil;
+      sol.suma += JugadorAuto::UNIDAD / 4 * sol.alineadas3
+                  + JugadorAuto::UNIDAD / 16 * sol.alineadas2;
+      sol.pendiente += JugadorAuto::UNIDAD;
+    }
+  };
+}
 
-      // Bajamos hasta llegar a la fila donde se insertó la última ficha
-      for (fil = 0; tab.GetElemento(fil,col) == 0; ++fil);
+/* _________________________________________________________________________ */
 
-      // Cogemos la ficha para buscar las alineaciones n-raya
-      int ficha = tab.GetElemento(fil,col);
+vector<JugadorAuto::Estrategia>& JugadorAuto::registro()
+{
+  static vector<Estrategia> estrategias = {
+    {"amenazas", 1, "árbol de soluciones, puntuando las amenazas (la más eficiente)",
+     true, N, &JugadorAuto::puntuarNodos<PuntosAlineadas>, &JugadorAuto::metrica1, 0,
+     &Posicion::cabe},
+    {"arbol", 2, "árbol de soluciones, puntuando las partidas ganadas",
+     true, N, &JugadorAuto::puntuarNodos<PuntosBasicos>, &JugadorAuto::metrica2, 0,
+     &Posicion::cabe},
+    {"segura", 3, "al azar entre las columnas que no pierden enseguida",
+     false, 2, &JugadorAuto::puntuarNodos<PuntosBasicos>, &JugadorAuto::metrica3, 0,
+     &Posicion::cabe},
+    {"aleatoria", 4, "en una columna libre al azar",
+     false, 0, 0, 0, &CrearAleatorio, 0},
+    {"alfabeta", 5, "búsqueda alfa-beta",
+     true, 0, 0, 0, &CrearAlfaBeta, 0},
+    {"mcts", 6, "búsqueda de Monte Carlo en árbol (para tableros grandes)",
+     true, 0, 0, 0, &CrearMonteCarlo, &MonteCarlo::cabe}
+  };
+  return estrategias;
+}
 
-      // Recorro cada dirección, si hay n en línea suma 1 al nº de n-lineas que se han dado al poner la ficha en ult_pos
-      for (int d = 0; d < 8; d++)
-      {
-        // La propia ficha cuenta como una ficha alineada
-        int alineados = 1;
-        bool sigue = true;
-        // Fijo la i,j de la última posición
-        int i = fil;
-        int j = col;
-        while (sigue && alineados < nRaya)
-        {
-          //  Me muevo en la direccion que me dan
-          i += direccion[d].i;
-          j += direccion[d].j;
-          sigue = i >= 0 && i < tab.GetFilas() && j >= 0 && j < tab.GetColumnas()
-                  && ficha == tab.GetElemento(i, j);
-          if (sigue)
-            alineados++;
-          }
-          if (alineados == nRaya)
-            encontrados++;
-        }
+/* _________________________________________________________________________ */
+
+bool JugadorAuto::registrar(const Estrategia& e)
+{
+  bool valida = e.numero > 0 && !e.nombre.empty()
+                && (e.profundidad > 0 ? e.puntuar && e.elegir : e.crear != 0);
+  Estrategia otra;
+  if (!valida || buscarEstrategia(e.numero, otra) || buscarEstrategia(e.nombre, otra))
+    return false;
+
+  registro().push_back(e);
+  return true;
+}
+
+/* _________________________________________________________________________ */
+
+bool JugadorAuto::buscarEstrategia(int numero, Estrategia& e)
+{
+  const vector<Estrategia>& estrategias = registro();
+  for (size_t k = 0; k < estrategias.size(); k++)
+  {
+    if (estrategias[k].numero == numero)
+    {
+      e = estrategias[k];
+      return true;
     }
+  }
+  return false;
+}
+
+/* _________________________________________________________________________ */
+
+bool JugadorAuto::buscarEstrategia(const string& nombre, Estrategia& e)
+{
+  if (!nombre.empty() && all_of(nombre.begin(), nombre.end(),
+                                [](char c) { return isdigit((unsigned char) c); }))
+    return buscarEstrategia(stoi(nombre), e);
 
-    return encontrados;
+  const vector<Estrategia>& estrategias = registro();
+  for (size_t k = 0; k < estrategias.size(); k++)
+  {
+    if (estrategias[k].nombre == nombre)
+    {
+      e = estrategias[k];
+      return true;
+    }
   }
+  return false;
+}
+
+/* _________________________________________________________________________ */
+
+void JugadorAuto::mostrarEstrategias(ostream& os, const string& sangria)
+{
+  const vector<Estrategia>& estrategias = registro();
+  for (size_t k = 0; k < estrategias.size(); k++)
+    os << sangria << estrategias[k].numero << " (" << estrategias[k].nombre
+       << "): " << estrategias[k].descripcion << endl;
 }
 
 /* _________________________________________________________________________ */
 
 int JugadorAuto::metrica1()
 {
-  int num_cols = partida.etiqueta(partida.raiz()).GetColumnas();
+  int num_cols = partida.etiqueta(partida.raiz()).pos.GetColumnas();
 
   // Si se puede, insertar en el primer turno en el centro
-  if (partida.etiqueta(partida.raiz()).estaVacio())
+  if (partida.etiqueta(partida.raiz()).pos.estaVacio())
   {
     return num_cols / 2;
   }
@@ -98,7 +210,7 @@ int JugadorAuto::metrica1()
     return gana_IA;
 
   // Evitar perder, si es posible
-  vector<ArbolGeneral<Tablero>::Nodo> posibilidades = evita_perder();
+  vector<ArbolGeneral<Solucion>::Nodo> posibilidades = evita_perder();
   int num_nodos = posibilidades.size();
 
   if (num_nodos)
@@ -106,13 +218,12 @@ int JugadorAuto::metrica1()
     int max_alineadas = 0;
     int nodo_max = 0;
     int alineadas;
-    bool humano_alinea;
     int i;
 
     // Ver si puedo conseguir el mayor número de 3-en-raya
     for (i = 0; i < num_nodos; i++)
     {
-      alineadas = cantidadAlineada(partida.etiqueta(posibilidades[i]), 3);
+      alineadas = partida.etiqueta(posibilidades[i]).alineadas3;
       if (alineadas > max_alineadas)
       {
         max_alineadas = alineadas;
@@ -120,28 +231,17 @@ int JugadorAuto::metrica1()
       }
     }
     if (max_alineadas > 0)
-      return partida.etiqueta(posibilidades[nodo_max]).GetUltCol();
+      return partida.etiqueta(posibilidades[nodo_max]).pos.GetUltCol();
 
     // Ver si puedo evitar que el jugador humano consiga 3-en-raya
-    for (vector<ArbolGeneral<Tablero>::Nodo>::iterator it = posibilidades.begin();
-         it != posibilidades.end(); ++it)
-    {
-      humano_alinea = false;
-      for (ArbolGeneral<Tablero>::Nodo n = partida.hijomasizquierda(*it);
-           n && !humano_alinea; n = partida.hermanoderecha(n))
-      {
-        if (cantidadAlineada(partida.etiqueta(*it), 3) > 0)
-          humano_alinea = true;
-      }
-      // Si hemos provocado que el humano alinee 3, eliminamos esa posibilidad
-      if (humano_alinea)
-        posibilidades.erase(it);
-    }
+    descartarSiAlinea(posibilidades, &Solucion::alineadas3);
+    num_nodos = posibilidades.size();
 
     // Ver si puedo conseguir el mayor número de 2-en-raya
+    nodo_max = 0;
     for (i = 0; i < num_nodos; i++)
     {
-      alineadas = cantidadAlineada(partida.etiqueta(posibilidades[i]), 2);
+      alineadas = partida.etiqueta(posibilidades[i]).alineadas2;
       if (alineadas > max_alineadas)
       {
         max_alineadas = alineadas;
@@ -149,23 +249,10 @@ int JugadorAuto::metrica1()
       }
     }
     if (max_alineadas > 0)
-      return partida.etiqueta(posibilidades[nodo_max]).GetUltCol();
+      return partida.etiqueta(posibilidades[nodo_max]).pos.GetUltCol();
 
     // Ver si puedo evitar que el jugador humano consiga 2-en-raya
-    for (vector<ArbolGeneral<Tablero>::Nodo>::iterator it = posibilidades.begin();
-         it != posibilidades.end(); ++it)
-    {
-      humano_alinea = false;
-      for (ArbolGeneral<Tablero>::Nodo n = partida.hijomasizquierda(*it);
-           n && !humano_alinea; n = partida.hermanoderecha(n))
-      {
-        if (cantidadAlineada(partida.etiqueta(*it), 2) > 0)
-          humano_alinea = true;
-      }
-      // Si hemos provocado que el humano alinee 2, eliminamos esa posibilidad
-      if (humano_alinea)
-        posibilidades.erase(it);
-    }
+    descartarSiAlinea(posibilidades, &Solucion::alineadas2);
 
     // De las posibilidades restantes, insertar en la columna de mayor puntuación
     return mayorPuntuacion(posibilidades);
@@ -174,18 +261,42 @@ int JugadorAuto::metrica1()
   // El jugador automático pierde, elegimos la primera columna libre
   else
   {
-    return partida.etiqueta(partida.hijomasizquierda(partida.raiz())).GetUltCol();
+    return partida.etiqueta(partida.hijomasizquierda(partida.raiz())).pos.GetUltCol();
   }
 }
 
 /* _________________________________________________________________________ */
 
+void JugadorAuto::descartarSiAlinea(vector<ArbolGeneral<Solucion>::Nodo>& posibilidades,
+                                    int8_t Solucion::*alineadas)
+{
+  // Una posibilidad es mala si alguna respuesta del humano alinea fichas
+  auto humano_alinea = [&](ArbolGeneral<Solucion>::Nodo p) {
+    for (ArbolGeneral<Solucion>::Nodo n = partida.hijomasizquierda(p);
+         n; n = partida.hermanoderecha(n))
+    {
+      if (partida.etiqueta(n).*alineadas > 0)
+        return true;
+    }
+    return false;
+  };
+
+  vector<ArbolGeneral<Solucion>::Nodo> quedan(posibilidades);
+  quedan.erase(remove_if(quedan.begin(), quedan.end(), humano_alinea), quedan.end());
+
+  // Si todas dejan alinear al humano, se siguen considerando todas
+  if (!quedan.empty())
+    posibilidades.swap(quedan);
+}
+
+/* _________________________________________________________________________ */
+
 int JugadorAuto::metrica2()
 {
-  int num_cols = partida.etiqueta(partida.raiz()).GetColumnas();
+  int num_cols = partida.etiqueta(partida.raiz()).pos.GetColumnas();
 
   // Si se puede, inserto en el primer turno en el centro (o lo más cerca posible)
-  if (partida.etiqueta(partida.raiz()).estaVacio())
+  if (partida.etiqueta(partida.raiz()).pos.estaVacio())
   {
     return num_cols / 2;
   }
@@ -196,7 +307,7 @@ int JugadorAuto::metrica2()
     return gana_IA;
 
   // Evitar perder, si es posible
-  vector<ArbolGeneral<Tablero>::Nodo> posibilidades = evita_perder();
+  vector<ArbolGeneral<Solucion>::Nodo> posibilidades = evita_perder();
 
   // Calculamos de entre las posibilidades aquella con mayor puntuación
   if (posibilidades.size())
@@ -207,7 +318,7 @@ int JugadorAuto::metrica2()
   // El jugador automático pierde, elegimos la primera columna libre
   else
   {
-    return partida.etiqueta(partida.hijomasizquierda(partida.raiz())).GetUltCol();
+    return partida.etiqueta(partida.hijomasizquierda(partida.raiz())).pos.GetUltCol();
   }
 }
 
@@ -221,225 +332,474 @@ int JugadorAuto::metrica3()
     return gana_IA;
 
   // Evitar perder, si es posible
-  vector<ArbolGeneral<Tablero>::Nodo> posibilidades = evita_perder();
+  vector<ArbolGeneral<Solucion>::Nodo> posibilidades = evita_perder();
 
   if (posibilidades.size())
   {
     // Introducimos aleatoriamente donde el jugador humano no gane
-    return partida.etiqueta(posibilidades[GeneraEnteroAleatorio(0, posibilidades.size() - 1)]).GetUltCol();
+    return partida.etiqueta(posibilidades[aleatorio.entero(posibilidades.size())]).pos.GetUltCol();
   }
 
   else
   {
     // Caso trivial: el jugador automático pierde. Elegimos la primera columna libre
-    return partida.etiqueta(partida.hijomasizquierda(partida.raiz())).GetUltCol();
+    return partida.etiqueta(partida.hijomasizquierda(partida.raiz())).pos.GetUltCol();
   }
 }
 
 /* _________________________________________________________________________ */
 
-int JugadorAuto::metrica4()
+int JugadorAuto::elegirConMotor(Motor& m)
 {
-  int columnas = (partida.etiqueta(partida.raiz())).GetColumnas();
-  int col;
-  do
-  {
-    col = GeneraEnteroAleatorio(0, columnas - 1);
-  } while((partida.etiqueta(partida.raiz())).hayHueco(col) < 0);
+  Estadisticas::Cronometro c(estadisticas, Estadisticas::BUSQUEDA);
+  if (Estadisticas::ACTIVAS)
+    m.dejarDePensar();
+  long cortes_antes = Estadisticas::ACTIVAS ? m.GetCortes() : 0;
+
+  int columna = m.mejorMovimiento(actual);
+  nodos += m.GetNodos();
+  respuesta_esperada = m.GetRespuestaEsperada();
 
-  return col;
+  if (Estadisticas::ACTIVAS)
+  {
+    Estadisticas::Jugada& j = estadisticas.jugada();
+    j.nodos_busqueda += m.GetNodos();
+    j.cortes += m.GetCortes() - cortes_antes;
+    j.profundidad = m.GetProfundidad();
+  }
+  return columna;
 }
 
 /* _________________________________________________________________________ */
 
-void JugadorAuto::generarArbolSoluciones(int profundidad)
+void JugadorAuto::ampliarHojas(vector<ArbolGeneral<Solucion>::Nodo>& hojas, int profundidad,
+                               ArbolGeneral<Solucion>::Nodo tope, vector<long>& expandidos,
+                               vector<long>& creados)
 {
-  ArbolGeneral<Tablero>::Nodo raiz = partida.raiz();
-  ArbolGeneral<Tablero>::Nodo n = raiz;
-
-  // Bajar hasta el hijo más a la izquierda
-  while (partida.hijomasizquierda(n))
-    n = partida.hijomasizquierda(n);
+  int num_cols = partida.etiqueta(partida.raiz()).pos.GetColumnas();
+  vector<ArbolGeneral<Solucion>::Nodo> siguiente;
 
-  do
+  for (int nivel = 0; nivel < profundidad && !hojas.empty(); nivel++)
   {
-    ArbolGeneral<Tablero>::Nodo hoja = n;
-
-    // Nivel relativo al primero
-    int i = 0;
-    do
+    siguiente.clear();
+    for (size_t k = 0; k < hojas.size(); k++)
     {
-      bool creado = true;
+      ArbolGeneral<Solucion>::Nodo n = hojas[k];
 
-      // Crear los hijos del nodo
-      while (i < profundidad && creado)
-      {
-        creado = false;
-        Tablero tablero_original(partida.etiqueta(n));
-        int num_cols = tablero_original.GetColumnas();
+      // Si la partida ha acabado, el nodo no tiene hijos
+      if (partida.etiqueta(n).pos.quienGanaUltimo())
+        continue;
+      expandidos[nivel]++;
 
-        // Generar todos los tableros posibles
-        for (int col = 0; col < num_cols; ++col)
+      // La posición sólo se expande a un Tablero para jugar sobre él
+      Tablero tablero(partida.etiqueta(n).pos.aTablero());
+      int col_anterior = tablero.GetUltCol();
+
+      for (int col = 0; col < num_cols; ++col)
+      {
+        if (tablero.hayHueco(col) > -1)
         {
-          if ((tablero_original.hayHueco(col) > -1) && !tablero_original.quienGana())
-          {
-            // Crear tablero, meter ficha, cambiar turno e insertar
-            creado = true;
-            Tablero tablero_nuevo(tablero_original);
-            tablero_nuevo.colocarFicha(col);
-            tablero_nuevo.cambiarTurno();
-            ArbolGeneral<Tablero> hijo(tablero_nuevo);
-            partida.insertar_hijomasizquierda(n, hijo);
-          }
+          // Meter ficha, cambiar turno y guardar la posición; después se
+          // deshace la jugada
+          tablero.colocarFicha(col);
+          tablero.cambiarTurno();
+          partida.insertar_hijomasizquierda(n, ArbolGeneral<Solucion>(Solucion(Posicion(tablero))));
+          siguiente.push_back(partida.hijomasizquierda(n));
+          tablero.cambiarTurno();
+          tablero.quitarFicha(col, col_anterior);
         }
-        ++i;  // Aumentar el nivel
+      }
+    }
+    creados[nivel] += siguiente.size();
+
+    // Puntuar los nodos nuevos y sumar después sus puntos a sus antecesores
+    (this->*puntuar)(siguiente, 0, siguiente.size());
+    for (size_t k = 0; k < hojas.size(); k++)
+      propagarPuntuacion(hojas[k], tope);
+
+    // Los nodos que terminan la partida no tendrán hijos: no son frontera
+    siguiente.erase(remove_if(siguiente.begin(), siguiente.end(),
+                              [this](ArbolGeneral<Solucion>::Nodo h) {
+                                return terminada(partida.etiqueta(h).pos);
+                              }),
+                    siguiente.end());
+    hojas.swap(siguiente);
+  }
+}
 
-        // Si ya no hay más que crear
-        if (i < profundidad && creado)
-          n = partida.hijomasizquierda(n);
+/* _________________________________________________________________________ */
 
-      }
-      --i;  // Subimos un nivel
+void JugadorAuto::generarArbolSoluciones(int profundidad)
+{
+  Estadisticas::Cronometro c(estadisticas, Estadisticas::ARBOL);
 
-      // Nivel profundidad - 1: mirar si hay hermano derecha
-      if (n != hoja && partida.hermanoderecha(n))
-      {
-        n = partida.hermanoderecha(n);
-      }
-      else
-      {
-        // Subir hasta que haya hermano derecha o lleguemos a la hoja original
-        while (n != hoja && !partida.hermanoderecha(partida.padre(n)))
-        {
-          --i;  // Disminuye el nivel
-          n = partida.padre(n);
-        }
+  // Nivel de la frontera bajo la raíz (todas sus hojas están al mismo)
+  int nivel_frontera = 0;
+  if (!frontera.empty())
+  {
+    for (ArbolGeneral<Solucion>::Nodo a = frontera[0]; a != partida.raiz();
+         a = partida.padre(a))
+      nivel_frontera++;
+  }
+
+  vector<long> expandidos(profundidad, 0), creados(profundidad, 0);
+  int nivel = 0;
+
+  // Desde la raíz, o con un solo hilo, se amplía la frontera entera aquí
+  while (nivel < profundidad && !frontera.empty()
+         && (!grupo || nivel_frontera + nivel == 0))
+  {
+    vector<long> exp(1, 0), cre(1, 0);
+    ampliarHojas(frontera, 1, 0, exp, cre);
+    expandidos[nivel] += exp[0];
+    creados[nivel] += cre[0];
+    nivel++;
+  }
 
-        // Si no he llegado al tope
-        if (n != hoja)
+  if (nivel < profundidad && !frontera.empty())
+  {
+    // Con varios hilos, cada tarea amplía las hojas que cuelgan de un nodo
+    // a cierta profundidad: las jugadas de la raíz o, si no hay bastantes
+    // para los hilos, las siguientes. La frontera está ordenada por niveles,
+    // así que las hojas de cada nodo están seguidas
+    int nivel_hojas = nivel_frontera + nivel;
+    const size_t MIN_TAREAS = 2 * grupo->size();
+    vector<ArbolGeneral<Solucion>::Nodo> ancestros;
+    vector<size_t> inicio;
+
+    for (int nivel_tarea = 1; nivel_tarea <= nivel_hojas; nivel_tarea++)
+    {
+      ancestros.clear();
+      inicio.clear();
+      for (size_t k = 0; k < frontera.size(); k++)
+      {
+        ArbolGeneral<Solucion>::Nodo a = frontera[k];
+        for (int l = nivel_hojas; l > nivel_tarea; l--)
+          a = partida.padre(a);
+        if (ancestros.empty() || ancestros.back() != a)
         {
-          // Nos posicionamos en el hermano a la derecha del padre
-          n = partida.hermanoderecha(partida.padre(n));
-          --i;  // Disminuye el nivel (porque subimos al padre)
+          ancestros.push_back(a);
+          inicio.push_back(k);
         }
       }
-    } while (n != hoja);  // Mientras que no llegue a la hoja original
-
-    // Mirar hermanos a la derecha de la hoja original
-    if (partida.hermanoderecha(n))
+      if (ancestros.size() >= MIN_TAREAS)
+        break;
+    }
+    inicio.push_back(frontera.size());
+
+    // Cada tarea crea sus nodos en su hilo y suma los puntos hasta su nodo;
+    // lo que recibe ese nodo se anota para sumarlo después a los de encima
+    int num_tareas = ancestros.size();
+    int niveles = profundidad - nivel;
+    vector<vector<ArbolGeneral<Solucion>::Nodo> > hojas(num_tareas);
+    vector<vector<long> > exp(num_tareas, vector<long>(niveles, 0));
+    vector<vector<long> > cre(num_tareas, vector<long>(niveles, 0));
+    vector<int64_t> suma(num_tareas), pendiente(num_tareas);
+
+    grupo->ejecutar(num_tareas, [&](int t) {
+      hojas[t].assign(frontera.begin() + inicio[t], frontera.begin() + inicio[t + 1]);
+      const Solucion& sol = partida.etiqueta(ancestros[t]);
+      int64_t suma_antes = sol.suma, pendiente_antes = sol.pendiente;
+      ampliarHojas(hojas[t], niveles, ancestros[t], exp[t], cre[t]);
+      suma[t] = sol.suma - suma_antes;
+      pendiente[t] = sol.pendiente - pendiente_antes;
+    });
+
+    // Se junta todo en el orden de las tareas, así que el resultado no
+    // depende de qué hilo hizo cada una
+    frontera.clear();
+    for (int t = 0; t < num_tareas; t++)
     {
-      n = partida.hermanoderecha(n);
-      // Bajar hasta el hijo más a la izquierda de todos
-      while (partida.hijomasizquierda(n))
-        n = partida.hijomasizquierda(n);
+      sumarAntecesores(ancestros[t], suma[t], pendiente[t]);
+      frontera.insert(frontera.end(), hojas[t].begin(), hojas[t].end());
+      for (int l = 0; l < niveles; l++)
+      {
+        expandidos[nivel + l] += exp[t][l];
+        creados[nivel + l] += cre[t][l];
+      }
     }
+  }
 
-    // No hay hermanos a la derecha de la hoja
-    else
-    {
-      // Subir mientras que no llegue a la raíz y no haya hermanos a la derecha
-      while (n != raiz && !partida.hermanoderecha(partida.padre(n)))
-        n = partida.padre(n);
+  for (int l = 0; l < profundidad; l++)
+  {
+    nodos += creados[l];
+    if (expandidos[l] > 0)
+      estadisticas.nivelArbol(nivel_frontera + l + 1, expandidos[l], creados[l]);
+  }
+}
 
-      // Si no he llegado al tope
-      if (n != raiz)
+/* _________________________________________________________________________ */
+
+void JugadorAuto::podarFrontera(ArbolGeneral<Solucion>::Nodo n)
+{
+  ArbolGeneral<Solucion>::Nodo raiz = partida.raiz();
+  size_t quedan = 0;
+
+  for (size_t k = 0; k < frontera.size(); k++)
+  {
+    // Subir hasta el antecesor que es hijo de la raíz
+    ArbolGeneral<Solucion>::Nodo a = frontera[k];
+    while (a != raiz && partida.padre(a) != raiz)
+      a = partida.padre(a);
+
+    if (a == n)
+      frontera[quedan++] = frontera[k];
+  }
+
+  frontera.resize(quedan);
+}
+
+/* _________________________________________________________________________ */
+
+bool JugadorAuto::comprobarFrontera() const
+{
+  if (!arbol_construido)
+    return frontera.empty();
+
+  // Hojas del árbol que no terminan la partida, con su nivel
+  vector<ArbolGeneral<Solucion>::Nodo> hojas;
+  vector<pair<ArbolGeneral<Solucion>::Nodo, int> > pila(1, make_pair(partida.raiz(), 0));
+  int nivel_hojas = -1;
+  bool mismo_nivel = true;
+
+  while (!pila.empty())
+  {
+    ArbolGeneral<Solucion>::Nodo n = pila.back().first;
+    int nivel = pila.back().second;
+    pila.pop_back();
+
+    ArbolGeneral<Solucion>::Nodo h = partida.hijomasizquierda(n);
+    if (h == 0)
+    {
+      const Posicion& pos = partida.etiqueta(n).pos;
+      bool sigue = pos.quienGanaUltimo() == 0;
+      bool hueco = false;
+      for (int col = 0; col < pos.GetColumnas() && !hueco; col++)
+        hueco = pos.hayHueco(col) > -1;
+      if (sigue && hueco)
       {
-        // Me posiciono en el hermano a la derecha del padre
-        n = partida.hermanoderecha(partida.padre(n));
-        // Bajo hasta el hijo más a la izquierda de todos
-        while (partida.hijomasizquierda(n))
-          n = partida.hijomasizquierda(n);
+        hojas.push_back(n);
+        mismo_nivel = mismo_nivel && (nivel_hojas == -1 || nivel == nivel_hojas);
+        nivel_hojas = nivel;
       }
     }
-  } while (n != raiz);  // Mientras que no llegue a la raíz
+    for (; h != 0; h = partida.hermanoderecha(h))
+      pila.push_back(make_pair(h, nivel + 1));
+  }
+
+  vector<ArbolGeneral<Solucion>::Nodo> ordenada(frontera);
+  sort(hojas.begin(), hojas.end());
+  sort(ordenada.begin(), ordenada.end());
+  return mismo_nivel && hojas == ordenada;
+}
+
+/* _________________________________________________________________________ */
+
+bool JugadorAuto::comprobarPuntuaciones()
+{
+  if (!arbol_construido)
+    return true;
+
+  // Nodos por niveles, con su nivel y la posición de su padre
+  vector<ArbolGeneral<Solucion>::Nodo> nodos(1, partida.raiz());
+  vector<int> niveles(1, 0), padres(1, -1);
+  for (size_t i = 0; i < nodos.size(); i++)
+    for (ArbolGeneral<Solucion>::Nodo h = partida.hijomasizquierda(nodos[i]);
+         h; h = partida.hermanoderecha(h))
+    {
+      nodos.push_back(h);
+      niveles.push_back(niveles[i] + 1);
+      padres.push_back(i);
+    }
+
+  vector<Solucion> guardadas;
+  for (size_t i = 0; i < nodos.size(); i++)
+    guardadas.push_back(partida.etiqueta(nodos[i]));
+
+  // Al puntuar cada nodo queda sólo su propia puntuación
+  (this->*puntuar)(nodos, 0, nodos.size());
+  vector<int64_t> total;
+  for (size_t i = 0; i < nodos.size(); i++)
+    total.push_back(calcularPuntuacion(nodos[i], niveles[i]));
+
+  // Los hijos están después que su padre, así que se suman antes de mirarlo.
+  // La raíz no se puntúa al construir el árbol, y para elegir sólo se miran
+  // sus hijos
+  bool iguales = true;
+  for (size_t i = nodos.size(); i-- > 0; )
+  {
+    const Solucion& antes = guardadas[i];
+    iguales = iguales && (i == 0
+                          || total[i] == antes.suma + antes.pendiente * (N - niveles[i]));
+    if (padres[i] >= 0)
+      total[padres[i]] += total[i];
+    partida.etiqueta(nodos[i]) = antes;
+  }
+  return iguales;
+}
+
+/* _________________________________________________________________________ */
+
+void JugadorAuto::construirArbol()
+{
+  // El árbol se explora hasta una cierta profundidad según la métrica
+  partida.AsignaRaiz(Solucion(Posicion(actual)));
+  frontera.assign(1, partida.raiz());
+  arbol_construido = true;
+  jugador = actual.GetTurno();
+
+  // (un jugador con motor al que se le pide una métrica del árbol, hasta N)
+  int profundidad = usaArbol() ? estrategia.profundidad : N;
+  generarArbolSoluciones(profundidad);
 }
 
 /* _________________________________________________________________________ */
 
 void JugadorAuto::actualizarSoluciones(const Tablero& tablero)
 {
-  // Si comienza jugando el jugador automático, no hacemos nada
-  if (tablero.estaVacio())
+  actual = tablero;
+
+  // Si comienza jugando el jugador automático, o aún no hay árbol (porque
+  // se está jugando con el libro), no hacemos nada
+  if (tablero.estaVacio() || !arbol_construido)
     return;
 
-  if (metrica != 4)
+  // Localizar tablero actual entre las posibilidades (siempre está)
+  ArbolGeneral<Solucion>::Nodo n = partida.hijomasizquierda(partida.raiz());
+  while (partida.etiqueta(n).pos.GetUltCol() != tablero.GetUltCol())
+  {
+    n = partida.hermanoderecha(n);
+  }
+
+  // El nodo n, y el subárbol que cuelga de él, se convierte en el nuevo árbol.
+  // Antes se olvidan las hojas de los subárboles que se van a destruir
+  podarFrontera(n);
+  partida.asignar_subarbol(n);
+
+  // Explorar siguiente nivel del árbol de soluciones, sólo desde la frontera
+  generarArbolSoluciones(1);
+}
+
+/* _________________________________________________________________________ */
+
+template <class Puntos>
+void JugadorAuto::puntuarNodos(const vector<ArbolGeneral<Solucion>::Nodo>& nodos,
+                               size_t desde, size_t hasta)
+{
+  for (size_t k = desde; k < hasta; k++)
   {
-    // Localizar tablero actual entre las posibilidades (siempre está)
-    ArbolGeneral<Tablero>::Nodo n = partida.hijomasizquierda(partida.raiz());
-    while (partida.etiqueta(n).GetUltCol() != tablero.GetUltCol())
+    Solucion& sol = partida.etiqueta(nodos[k]);
+    int ganador = sol.pos.quienGanaUltimo();
+
+    // Alineaciones de la última ficha, a una y a dos fichas de ganar
+    if (Puntos::ALINEADAS)
     {
-      n = partida.hermanoderecha(n);
+      int alineadas3, alineadas2;
+      evaluador.contarAlineadas(sol.pos, alineadas3, alineadas2);
+      sol.alineadas3 = alineadas3;
+      sol.alineadas2 = alineadas2;
     }
 
-    // El nodo n, y el subárbol que cuelga de él, se convierte en el nuevo árbol
-    partida.asignar_subarbol(n);
+    // Puntuación del nodo a nivel lvl: suma + pendiente * (N - lvl)
+    if (ganador != 0 && ganador != jugador)
+    {
+      sol.suma = -2 * UNIDAD;
+      sol.pendiente = -UNIDAD;
+    }
+    else if (ganador == jugador)
+    {
+      sol.suma = 2 * UNIDAD;
+      sol.pendiente = UNIDAD;
+    }
+    else
+    {
+      sol.suma = UNIDAD;
+      sol.pendiente = UNIDAD;
+    }
 
-    // Explorar siguiente nivel del árbol de soluciones
-    generarArbolSoluciones(1);
+    Puntos::sumar(sol);
   }
 }
 
 /* _________________________________________________________________________ */
 
-int JugadorAuto::calcularPuntuacion(ArbolGeneral<Tablero>::Nodo n, int lvl)
+void JugadorAuto::propagarPuntuacion(ArbolGeneral<Solucion>::Nodo n,
+                                     ArbolGeneral<Solucion>::Nodo tope)
 {
-  float puntos;
-  Tablero aux = partida.etiqueta(n);
-  int ganador = aux.quienGana();
-
-  // Calcular puntuación del nodo
-  if (ganador == 1)
-    puntos = -2 - (N - lvl);
-  else if (ganador == 2)
-    puntos = 2 + (N - lvl) ;
-  else
-    puntos = 1 + (N - lvl);
+  // Puntos de los hijos, vistos desde n (un nivel más arriba)
+  int64_t suma = 0, pendiente = 0;
+  for (ArbolGeneral<Solucion>::Nodo h = partida.hijomasizquierda(n);
+       h; h = partida.hermanoderecha(h))
+  {
+    const Solucion& sol = partida.etiqueta(h);
+    suma += sol.suma - sol.pendiente;
+    pendiente += sol.pendiente;
+  }
 
-  // Sistema puntuación métrica 1
-  if (metrica == 1)
+  // Cada nivel que se sube, los nodos nuevos están un nivel más abajo
+  for (ArbolGeneral<Solucion>::Nodo a = n; a; a = (a == tope) ? 0 : partida.padre(a))
   {
-    puntos += 0.25 * cantidadAlineada(aux, 3) +
-              0.0625 * cantidadAlineada(aux, 2) + (N - lvl);
+    Solucion& sol = partida.etiqueta(a);
+    sol.suma += suma;
+    sol.pendiente += pendiente;
+    suma -= pendiente;
   }
+}
+
+/* _________________________________________________________________________ */
 
-  // Caso base
-  if (!partida.hijomasizquierda(n))
-    return puntos;
+void JugadorAuto::sumarAntecesores(ArbolGeneral<Solucion>::Nodo n, int64_t suma,
+                                   int64_t pendiente)
+{
+  for (ArbolGeneral<Solucion>::Nodo a = partida.padre(n); a; a = partida.padre(a))
+  {
+    suma -= pendiente;
+    Solucion& sol = partida.etiqueta(a);
+    sol.suma += suma;
+    sol.pendiente += pendiente;
+  }
+}
 
-  // Caso general
-  for (n = partida.hijomasizquierda(n); n; n = partida.hermanoderecha(n))
-    puntos += calcularPuntuacion(n, lvl + 1);
+/* _________________________________________________________________________ */
 
-  return puntos;
+int64_t JugadorAuto::calcularPuntuacion(ArbolGeneral<Solucion>::Nodo n, int lvl) const
+{
+  const Solucion& sol = partida.etiqueta(n);
+  return sol.suma + sol.pendiente * (N - lvl);
 }
 
 /* _________________________________________________________________________ */
 
 int JugadorAuto::gana_inmediato()
 {
-  for (ArbolGeneral<Tablero>::Nodo n = partida.hijomasizquierda(partida.raiz());
+  Estadisticas::Cronometro c(estadisticas, Estadisticas::GANA_INMEDIATO);
+
+  for (ArbolGeneral<Solucion>::Nodo n = partida.hijomasizquierda(partida.raiz());
        n; n = partida.hermanoderecha(n))
   {
-    if (partida.etiqueta(n).quienGana() == 2)
-      return partida.etiqueta(n).GetUltCol();
+    if (partida.etiqueta(n).pos.quienGanaUltimo() == jugador)
+      return partida.etiqueta(n).pos.GetUltCol();
   }
   return -1;
 }
 
 /* _________________________________________________________________________ */
 
-vector<ArbolGeneral<Tablero>::Nodo> JugadorAuto::evita_perder()
+vector<ArbolGeneral<JugadorAuto::Solucion>::Nodo> JugadorAuto::evita_perder()
 {
-  vector<ArbolGeneral<Tablero>::Nodo> posibilidades;
+  Estadisticas::Cronometro c(estadisticas, Estadisticas::EVITA_PERDER);
+
+  vector<ArbolGeneral<Solucion>::Nodo> posibilidades;
 
-  for (ArbolGeneral<Tablero>::Nodo n1 = partida.hijomasizquierda(partida.raiz());
+  for (ArbolGeneral<Solucion>::Nodo n1 = partida.hijomasizquierda(partida.raiz());
        n1; n1 = partida.hermanoderecha(n1))
   {
     bool no_gana = true;
-    for (ArbolGeneral<Tablero>::Nodo n2 = partida.hijomasizquierda(n1);
+    for (ArbolGeneral<Solucion>::Nodo n2 = partida.hijomasizquierda(n1);
          n2; n2 = partida.hermanoderecha(n2))
     {
-      if (partida.etiqueta(n2).quienGana() == 1)
+      int ganador = partida.etiqueta(n2).pos.quienGanaUltimo();
+      if (ganador != 0 && ganador != jugador)
         no_gana = false;
     }
 
@@ -451,15 +811,15 @@ vector<ArbolGeneral<Tablero>::Nodo> JugadorAuto::evita_perder()
 
 /* _________________________________________________________________________ */
 
-int JugadorAuto::mayorPuntuacion(vector<ArbolGeneral<Tablero>::Nodo> v)
+int JugadorAuto::mayorPuntuacion(vector<ArbolGeneral<Solucion>::Nodo> v)
 {
-  // Almacenar el número de partidas ganadas (por el jugador auto) de cada nodo
-  // en el que podemos meter ficha sin miedo a perder
-  vector<int> puntuacion;
-  for (int i = 0; i < v.size(); i++)
-  {
+  Estadisticas::Cronometro c(estadisticas, Estadisticas::MAYOR_PUNTUACION);
+
+  // Puntuación (ya calculada) de cada nodo en el que podemos meter ficha
+  // sin miedo a perder
+  vector<int64_t> puntuacion;
+  for (size_t i = 0; i < v.size(); i++)
     puntuacion.push_back(calcularPuntuacion(v[i], 0));
-  }
 
   // Calcular el nodo con mayor número de partidas ganadas
   int max_pos = 0;
@@ -469,25 +829,56 @@ int JugadorAuto::mayorPuntuacion(vector<ArbolGeneral<Tablero>::Nodo> v)
       max_pos = i;
   }
 
-  return partida.etiqueta(v[max_pos]).GetUltCol();
+  return partida.etiqueta(v[max_pos]).pos.GetUltCol();
 }
 
 /* _________________________________________________________________________ */
 
-JugadorAuto::JugadorAuto(const Tablero& inicial, int num_metrica)
-  : partida(inicial), metrica(num_metrica)
+JugadorAuto::JugadorAuto()
+  : casillas_final(0), arbol_construido(false), jugador(2), nodos(0),
+    anticipar(false), respuesta_esperada(-1)
 {
-  // Métricas que exploran hasta una cierta profundidad (excepto aleatoria)
-  if (metrica != 4)
+  buscarEstrategia(1, estrategia);
+  puntuar = estrategia.puntuar;
+}
+
+/* _________________________________________________________________________ */
+
+JugadorAuto::JugadorAuto(const Tablero& inicial, int num_metrica,
+                         const ParametrosBusqueda& params, bool lazy_smp)
+  : actual(inicial), puntuar(0),
+    evaluador(inicial.GetFilas(), inicial.GetColumnas(), inicial.GetFichasGanar()),
+    casillas_final(0), arbol_construido(false), jugador(2), nodos(0),
+    estadisticas(params.estadisticas), anticipar(false), respuesta_esperada(-1),
+    aleatorio(params.semilla)
+{
+  if (!buscarEstrategia(num_metrica, estrategia))
+    buscarEstrategia(1, estrategia);
+  puntuar = estrategia.puntuar;
+
+  // Las estrategias sin árbol crean su motor (la búsqueda alfa-beta reserva
+  // aquí la tabla de transposición)
+  if (!usaArbol())
   {
-    int profundidad = (metrica == 3) ? 2 : N;
-    generarArbolSoluciones(profundidad);
+    motor = estrategia.crear(inicial, params, lazy_smp);
+    anticipar = params.anticipar;
   }
 
-  // Métrica aleatoria
-  else
+  // Hilos para ampliar el árbol
+  if (usaArbol() && params.hilos != 1)
+    grupo = make_shared<GrupoHilos>(params.hilos);
+
+  // Libro de aperturas y resolvedor de finales, si la métrica los usa
+  if (estrategia.atajos)
   {
-    srand(time(0));
+    // Los libros se generan para las fichas para ganar por defecto
+    if (!params.libro.empty() && inicial.GetFichasGanar() == Tablero::N_FICHAS_GANAR)
+      libro.abrir(params.libro, inicial.GetFilas(), inicial.GetColumnas());
+    if (params.casillas_final > 0)
+    {
+      resolvedor = Resolvedor(params.memoria_resolvedor);
+      casillas_final = params.casillas_final;
+    }
   }
 }
 
@@ -495,21 +886,76 @@ JugadorAuto::JugadorAuto(const Tablero& inicial, int num_metrica)
 
 int JugadorAuto::elegirMovimiento(int num_metrica)
 {
-  int columna;
+  int columna = -1;
+  string origen = "libro";
+  respuesta_esperada = -1;
+
+  // Usar dato miembro 'estrategia'
+  const Estrategia *e = &estrategia;
+  Estrategia otra;
+  if (num_metrica != 0 && num_metrica != estrategia.numero
+      && buscarEstrategia(num_metrica, otra))
+    e = &otra;
+
+  // Las primeras jugadas se toman del libro, si la posición está en él
+  if (e->atajos)
+  {
+    Estadisticas::Cronometro c(estadisticas, Estadisticas::LIBRO);
+    columna = libro.buscar(actual);
+  }
+
+  // Cerca del final se resuelve la partida, salvo que esté perdida
+  if (columna == -1 && e->atajos
+      && Resolvedor::casillasLibres(actual) < casillas_final)
+  {
+    Estadisticas::Cronometro c(estadisticas, Estadisticas::RESOLVEDOR);
+    long nodos_antes = resolvedor.GetNodos();
+    origen = "resolvedor";
+    // Sólo se juega la columna del resolvedor si se gana o se empata y cabe
+    // la ficha
+    if (resolvedor.resolver(actual, columna) == Resolvedor::PIERDE
+        || actual.hayHueco(columna) < 0)
+      columna = -1;
+    estadisticas.jugada().nodos_resolvedor += resolvedor.GetNodos() - nodos_antes;
+  }
+
+  if (columna == -1)
+  {
+    origen = "metrica";
 
-  // Usar dato miembro 'metrica'
-  if (num_metrica == 0)
-    num_metrica = metrica;
+    if (e->profundidad > 0)
+    {
+      // Las métricas que exploran el árbol lo crean la primera vez
+      if (!puntuar)
+        puntuar = e->puntuar;
+      if (!arbol_construido)
+        construirArbol();
+      columna = (this->*e->elegir)();
+    }
+    else if (e->numero == estrategia.numero)
+    {
+      columna = elegirConMotor(*motor);
+    }
+    else
+    {
+      // Otra métrica con motor: se crea uno sólo para esta jugada
+      unique_ptr<Motor> m = e->crear(actual, ParametrosBusqueda(), false);
+      columna = elegirConMotor(*m);
+    }
+  }
 
-  switch (num_metrica) {
-    case 2: columna = metrica2();
-            break;
-    case 3: columna = metrica3();
-            break;
-    case 4: columna = metrica4();
-            break;
-    default:
-    case 1: columna = metrica1();
+  if (Estadisticas::ACTIVAS)
+  {
+    Estadisticas::Jugada& j = estadisticas.jugada();
+    j.numero = actual.GetFilas() * actual.GetColumnas() - Resolvedor::casillasLibres(actual);
+    j.jugador = actual.GetTurno();
+    j.metrica = e->numero;
+    j.columna = columna;
+    j.origen = origen;
+    if (arbol_construido)
+      j.memoria_arbol = partida.size() * ArbolGeneral<Solucion>::bytes_nodo()
+                        + frontera.capacity() * sizeof(ArbolGeneral<Solucion>::Nodo);
+    estadisticas.terminarJugada();
   }
 
   return columna;
@@ -535,6 +981,26 @@ void JugadorAuto::turnoAutomatico(Tablero& actual)
 
   // Actualizamos de nuevo espacio de soluciones
   actualizarSoluciones(actual);
+
+  // Aprovechar el turno del rival
+  if (anticipar)
+    anticiparRespuesta();
+}
+
+/* _________________________________________________________________________ */
+
+void JugadorAuto::anticiparRespuesta()
+{
+  // Sólo si la búsqueda de esta jugada espera una respuesta y la partida sigue
+  if (respuesta_esperada == -1 || actual.quienGanaUltimo() || actual.estaLleno()
+      || actual.hayHueco(respuesta_esperada) < 0)
+    return;
+
+  Tablero esperado(actual);
+  esperado.colocarFicha(respuesta_esperada);
+  esperado.cambiarTurno();
+  if (!esperado.quienGanaUltimo() && !esperado.estaLleno())
+    motor->pensar(esperado);
 }
 
 /* Fin fichero: jugador_auto.cpp */
@@ -0,0 +1,136 @@
+/**
+ * @file libro_aperturas.cpp
+ * @brief Implementación de funciones del TDA LibroAperturas
+ *
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "libro_aperturas.h"
+
+using namespace std;
+
+const char LibroAperturas::FIRMA[8] = {'C', '4', 'L', 'I', 'B', 'R', 'O', '1'};
+
+// Funciones auxiliares
+namespace
+{
+  /**
+   * @brief Compara entradas por su clave.
+   */
+  bool menorClave(const LibroAperturas::Entrada& a,
+                  const LibroAperturas::Entrada& b)
+  {
+    return a.clave < b.clave;
+  }
+}
+
+/* _________________________________________________________________________ */
+
+LibroAperturas::LibroAperturas()
+  : memoria(0), bytes(0), cabecera(0), entradas(0)
+{
+}
+
+/* _________________________________________________________________________ */
+
+LibroAperturas::~LibroAperturas()
+{
+  cerrar();
+}
+
+/* _________________________________________________________________________ */
+
+bool LibroAperturas::abrir(const string& fichero, int filas, int columnas)
+{
+  cerrar();
+
+  int fd = open(fichero.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat info;
+  if (fstat(fd, &info) < 0 || (size_t) info.st_size < sizeof(Cabecera))
+  {
+    close(fd);
+    return false;
+  }
+
+  // La proyección sigue siendo válida después de cerrar el descriptor
+  bytes = info.st_size;
+  memoria = mmap(0, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (memoria == MAP_FAILED)
+  {
+    memoria = 0;
+    return false;
+  }
+
+  cabecera = static_cast<const Cabecera *>(memoria);
+  entradas = reinterpret_cast<const Entrada *>(cabecera + 1);
+
+  // Comprobar que es un libro de este tamaño de tablero y que está completo
+  if (memcmp(cabecera->firma, FIRMA, sizeof(FIRMA)) != 0
+      || cabecera->filas != filas || cabecera->columnas != columnas
+      || (bytes - sizeof(Cabecera)) / sizeof(Entrada) < cabecera->num_entradas)
+  {
+    cerrar();
+    return false;
+  }
+
+  return true;
+}
+
+/* _________________________________________________________________________ */
+
+void LibroAperturas::cerrar()
+{
+  if (memoria)
+    munmap(memoria, bytes);
+
+  memoria = 0;
+  bytes = 0;
+  cabecera = 0;
+  entradas = 0;
+}
+
+/* _________________________________________________________________________ */
+
+int LibroAperturas::buscar(const Tablero& t) const
+{
+  if (!abierto())
+    return -1;
+
+  Entrada clave;
+  clave.clave = t.GetClave();
+  const Entrada *fin = entradas + cabecera->num_entradas;
+  const Entrada *e = lower_bound(entradas, fin, clave, menorClave);
+
+  if (e == fin || e->clave != clave.clave || t.hayHueco(e->columna) < 0)
+    return -1;
+  return e->columna;
+}
+
+/* _________________________________________________________________________ */
+
+bool LibroAperturas::escribir(const string& fichero, Cabecera c,
+                              vector<Entrada>& e)
+{
+  memcpy(c.firma, FIRMA, sizeof(FIRMA));
+  c.num_entradas = e.size();
+  sort(e.begin(), e.end(), menorClave);
+
+  ofstream salida(fichero.c_str(), ios::binary);
+  salida.write(reinterpret_cast<const char *>(&c), sizeof(c));
+  if (!e.empty())
+    salida.write(reinterpret_cast<const char *>(&e[0]), e.size() * sizeof(Entrada));
+
+  return salida.good();
+}
+
+/* Fin fichero: libro_aperturas.cpp */
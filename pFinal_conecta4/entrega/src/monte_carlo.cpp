@@ -0,0 +1,566 @@
+/**
+ * @file monte_carlo.cpp
+ * @brief Implementación de funciones del TDA MonteCarlo
+ *
+ */
+
+#include <climits>
+#include <cmath>
+#include "monte_carlo.h"
+
+using namespace std;
+
+const double MonteCarlo::EXPLORACION = 1.0;
+
+// Funciones auxiliares
+namespace
+{
+  /**
+   * @brief Desplaza un bitboard s bits hacia las casillas de menor índice
+   * (hacia las de mayor si s es negativo). Los desplazamientos de 128 bits
+   * o más lo dejan vacío.
+   */
+  inline MonteCarlo::Bits desplazar(MonteCarlo::Bits b, int s)
+  {
+    if (s >= 0)
+      return s < 128 ? b >> s : 0;
+    return -s < 128 ? b << -s : 0;
+  }
+
+  /**
+   * @brief Cuenta los bits a 1 de un bitboard.
+   */
+  inline int contarBits(MonteCarlo::Bits b)
+  {
+    return __builtin_popcountll((uint64_t) b) + __builtin_popcountll((uint64_t) (b >> 64));
+  }
+}
+
+/* _________________________________________________________________________ */
+
+MonteCarlo::MonteCarlo(const Tablero& inicial, const ParametrosBusqueda& params)
+  : params(params), filas(inicial.GetFilas()), columnas(inicial.GetColumnas()),
+    fichas_ganar(inicial.GetFichasGanar()), alto(filas + 1), abajo(0),
+    casillas(0), usados(0), hay_arbol(false), pedidas(0), con_limite(false),
+    parar(false), segundos_total(0), respuesta_esperada(-1), ultima_columna(-1),
+    valor(0)
+{
+  for (int j = 0; j < columnas; j++)
+  {
+    abajo |= ((Bits) 1) << (j * alto);
+    casillas |= columna(j);
+  }
+
+  // El árbol ocupa la memoria de la tabla de transposición de la Busqueda
+  size_t num_nodos = ((size_t) max(params.memoria_tt, 1) << 20) / sizeof(Nodo);
+  nodos.resize(min(num_nodos, (size_t) INT_MAX));
+
+  if (params.hilos != 1)
+    grupo = make_shared<GrupoHilos>(params.hilos);
+  hilos.resize(grupo ? grupo->size() : 1);
+
+  // Un flujo de la misma semilla por hilo
+  uint64_t semilla = params.semilla ? params.semilla : Aleatorio::semillaAleatoria();
+  for (size_t i = 0; i < hilos.size(); i++)
+    hilos[i].aleatorio = Aleatorio(semilla, i);
+}
+
+/* _________________________________________________________________________ */
+
+MonteCarlo::~MonteCarlo()
+{
+  dejarDePensar();
+}
+
+/* _________________________________________________________________________ */
+
+MonteCarlo::PosicionBits MonteCarlo::aPosicion(const Tablero& t) const
+{
+  PosicionBits p = {0, 0, 0};
+
+  for (int j = 0; j < columnas; j++)
+  {
+    for (int i = 0; i < filas; i++)
+    {
+      int ficha = t.GetElemento(filas - 1 - i, j);
+      if (ficha != 0)
+      {
+        Bits casilla = ((Bits) 1) << (j * alto + i);
+        p.ocupadas |= casilla;
+        if (ficha == t.GetTurno())
+          p.propias |= casilla;
+        p.fichas++;
+      }
+    }
+  }
+  return p;
+}
+
+/* _________________________________________________________________________ */
+
+MonteCarlo::PosicionBits MonteCarlo::jugar(const PosicionBits& p, int col) const
+{
+  PosicionBits q;
+
+  // Le toca al rival, cuyas fichas son las ocupadas que no son propias
+  q.propias = p.ocupadas ^ p.propias;
+  q.ocupadas = p.ocupadas | (jugables(p) & columna(col));
+  q.fichas = p.fichas + 1;
+  return q;
+}
+
+/* _________________________________________________________________________ */
+
+MonteCarlo::Bits MonteCarlo::ganadoras(Bits b) const
+{
+  const int d_casilla[4] = {1, alto, alto - 1, alto + 1};
+  Bits resultado = 0;
+
+  // Una casilla completa una línea si, para alguna dirección y algún hueco
+  // k de la ventana, las demás casillas de la ventana son del jugador. La
+  // fila de más de cada columna (siempre vacía) corta las líneas que
+  // pasarían de una columna a otra
+  for (int d = 0; d < 4; d++)
+  {
+    for (int hueco = 0; hueco < fichas_ganar; hueco++)
+    {
+      Bits m = ~((Bits) 0);
+      for (int k = 0; k < fichas_ganar && m; k++)
+        if (k != hueco)
+          m &= desplazar(b, (k - hueco) * d_casilla[d]);
+      resultado |= m;
+    }
+  }
+
+  // Las diagonales también pueden acabar en la fila de más, que no es del
+  // tablero
+  return resultado & casillas;
+}
+
+/* _________________________________________________________________________ */
+
+int MonteCarlo::simular(Hilo& h, PosicionBits p) const
+{
+  // Mueve el rival del jugador que movió hasta p
+  bool rival = true;
+
+  while (true)
+  {
+    Bits libres = jugables(p);
+    if (!libres)
+      return 1;
+
+    // Si el que mueve puede ganar, gana
+    if (ganadoras(p.propias) & libres)
+      return rival ? 0 : 2;
+
+    Bits amenazas = ganadoras(p.ocupadas ^ p.propias);
+    Bits urgentes = amenazas & libres;
+    Bits casilla;
+
+    if (urgentes)
+    {
+      // Con dos victorias inmediatas del otro jugador, no hay defensa
+      if (urgentes & (urgentes - 1))
+        return rival ? 2 : 0;
+      casilla = urgentes;
+    }
+    else
+    {
+      // Al azar, sin poner ficha justo debajo de una casilla que gana el otro
+      Bits seguras = libres & ~(amenazas >> 1);
+      if (!seguras)
+        seguras = libres;
+      int k = h.aleatorio.entero(contarBits(seguras));
+      while (k--)
+        seguras &= seguras - 1;
+      casilla = seguras & (~seguras + 1);
+    }
+
+    // Pasa a mover el otro jugador
+    p.propias ^= p.ocupadas;
+    p.ocupadas |= casilla;
+    p.fichas++;
+    rival = !rival;
+  }
+}
+
+/* _________________________________________________________________________ */
+
+bool MonteCarlo::expandir(int32_t n, const PosicionBits& p)
+{
+  Bits libres = jugables(p);
+  int num_hijos = contarBits(libres);
+
+  // Se reserva sitio para todos los hijos a la vez, si lo hay
+  if (__atomic_load_n(&usados, __ATOMIC_RELAXED) + num_hijos > (int64_t) nodos.size())
+    return false;
+  int32_t primero = __atomic_fetch_add(&usados, num_hijos, __ATOMIC_RELAXED);
+  if (primero + (int64_t) num_hijos > (int64_t) nodos.size())
+    return false;
+
+  Bits ganan = ganadoras(p.propias);
+  bool lleno = p.fichas + 1 == filas * columnas;
+  int32_t h = primero;
+  for (int col = 0; col < columnas; col++)
+  {
+    Bits casilla = libres & columna(col);
+    if (!casilla)
+      continue;
+
+    Nodo& hijo = nodos[h++];
+    hijo.visitas = 0;
+    hijo.puntos = 0;
+    hijo.primer_hijo = -1;
+    hijo.num_hijos = 0;
+    hijo.columna = col;
+    hijo.estado = HOJA;
+    hijo.fin = (casilla & ganan) ? GANA : (lleno ? EMPATE : SIGUE);
+  }
+
+  nodos[n].primer_hijo = primero;
+  nodos[n].num_hijos = num_hijos;
+  return true;
+}
+
+/* _________________________________________________________________________ */
+
+int32_t MonteCarlo::elegirHijo(int32_t n) const
+{
+  const Nodo& nodo = nodos[n];
+  double log_padre = log((double) max(__atomic_load_n(&nodo.visitas, __ATOMIC_RELAXED), 1));
+  int32_t mejor = nodo.primer_hijo, sin_visitar = -1;
+  double mejor_cota = -1;
+
+  for (int32_t h = nodo.primer_hijo; h < nodo.primer_hijo + nodo.num_hijos; h++)
+  {
+    // Una jugada que gana se elige siempre, y una sin visitar antes que
+    // cualquier otra que no gane
+    if (nodos[h].fin == GANA)
+      return h;
+    int32_t visitas = __atomic_load_n(&nodos[h].visitas, __ATOMIC_RELAXED);
+    if (visitas == 0)
+    {
+      if (sin_visitar == -1)
+        sin_visitar = h;
+      continue;
+    }
+
+    int32_t puntos = __atomic_load_n(&nodos[h].puntos, __ATOMIC_RELAXED);
+    double cota = puntos / (2.0 * visitas) + EXPLORACION * sqrt(log_padre / visitas);
+    if (cota > mejor_cota)
+    {
+      mejor_cota = cota;
+      mejor = h;
+    }
+  }
+  return sin_visitar != -1 ? sin_visitar : mejor;
+}
+
+/* _________________________________________________________________________ */
+
+void MonteCarlo::simulacion(Hilo& h)
+{
+  int32_t n = 0;
+  PosicionBits p = raiz;
+  int resultado;
+
+  h.camino.clear();
+  h.camino.push_back(0);
+  __atomic_add_fetch(&nodos[0].visitas, 1, __ATOMIC_RELAXED);
+
+  while (true)
+  {
+    Nodo& nodo = nodos[n];
+    if (nodo.fin != SIGUE)
+    {
+      resultado = (nodo.fin == GANA) ? 2 : 1;
+      break;
+    }
+
+    uint8_t estado = __atomic_load_n(&nodo.estado, __ATOMIC_ACQUIRE);
+
+    // Una hoja se expande la segunda vez que se llega a ella
+    if (estado == HOJA && __atomic_load_n(&nodo.visitas, __ATOMIC_RELAXED) > 1)
+    {
+      uint8_t hoja = HOJA;
+      if (__atomic_compare_exchange_n(&nodo.estado, &hoja, (uint8_t) EXPANDIENDO, false,
+                                      __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      {
+        estado = expandir(n, p) ? EXPANDIDO : HOJA;
+        __atomic_store_n(&nodo.estado, estado, __ATOMIC_RELEASE);
+      }
+    }
+
+    if (estado != EXPANDIDO)
+    {
+      resultado = simular(h, p);
+      break;
+    }
+
+    // Se baja contando ya la visita (pérdida virtual hasta que se propague)
+    n = elegirHijo(n);
+    p = jugar(p, nodos[n].columna);
+    __atomic_add_fetch(&nodos[n].visitas, 1, __ATOMIC_RELAXED);
+    h.camino.push_back(n);
+  }
+
+  // Cada nivel hacia arriba, los puntos son los del otro jugador
+  for (size_t k = h.camino.size(); k-- > 0; )
+  {
+    __atomic_add_fetch(&nodos[h.camino[k]].puntos, resultado, __ATOMIC_RELAXED);
+    resultado = 2 - resultado;
+  }
+
+  h.profundidad = max(h.profundidad, (int) h.camino.size() - 1);
+  h.simulaciones++;
+}
+
+/* _________________________________________________________________________ */
+
+void MonteCarlo::bucle(Hilo& h)
+{
+  const int COMPROBAR = 32;   // Simulaciones entre consultas del reloj
+
+  while (!__atomic_load_n(&parar, __ATOMIC_RELAXED))
+  {
+    if (!con_limite && __atomic_fetch_sub(&pedidas, 1, __ATOMIC_RELAXED) <= 0)
+      break;
+    if (con_limite && h.simulaciones % COMPROBAR == 0
+        && chrono::steady_clock::now() >= limite)
+      break;
+    simulacion(h);
+  }
+}
+
+/* _________________________________________________________________________ */
+
+void MonteCarlo::buscar(chrono::steady_clock::time_point inicio)
+{
+  for (size_t i = 0; i < hilos.size(); i++)
+  {
+    hilos[i].simulaciones = 0;
+    hilos[i].profundidad = 0;
+  }
+
+  // La raíz se expande antes de repartir el trabajo. Si sólo hay una
+  // jugada, o una que gana, no hace falta simular
+  if (nodos[0].estado == HOJA)
+    nodos[0].estado = expandir(0, raiz) ? EXPANDIDO : HOJA;
+  bool simular_raiz = nodos[0].estado == EXPANDIDO && nodos[0].num_hijos > 1;
+  for (int32_t h = nodos[0].primer_hijo; simular_raiz && h < nodos[0].primer_hijo + nodos[0].num_hijos; h++)
+    if (nodos[h].fin == GANA)
+      simular_raiz = false;
+
+  if (simular_raiz)
+  {
+    if (!grupo)
+      bucle(hilos[0]);
+    else
+      grupo->ejecutar(hilos.size(), [&](int i) { bucle(hilos[i]); });
+  }
+
+  for (size_t i = 0; i < hilos.size(); i++)
+    hilos[i].simulaciones_total += hilos[i].simulaciones;
+  segundos_total += chrono::duration<double>(chrono::steady_clock::now()
+                                             - inicio).count();
+}
+
+/* _________________________________________________________________________ */
+
+void MonteCarlo::compactar(int32_t n)
+{
+  // Recorrido en anchura: los hijos de cada nodo siguen quedando seguidos
+  vector<Nodo> copia(1, nodos[n]);
+  for (size_t k = 0; k < copia.size(); k++)
+  {
+    if (copia[k].estado != EXPANDIDO)
+      continue;
+    int32_t origen = copia[k].primer_hijo;
+    copia[k].primer_hijo = copia.size();
+    for (int h = 0; h < copia[k].num_hijos; h++)
+      copia.push_back(nodos[origen + h]);
+  }
+
+  std::copy(copia.begin(), copia.end(), nodos.begin());
+  usados = copia.size();
+}
+
+/* _________________________________________________________________________ */
+
+void MonteCarlo::cambiarRaiz(const PosicionBits& p)
+{
+  int32_t nueva = -1;
+
+  // Se busca la posición en la raíz y en sus dos primeros niveles
+  if (hay_arbol && iguales(raiz, p))
+    nueva = 0;
+  for (int32_t h = nodos[0].primer_hijo;
+       hay_arbol && nueva == -1 && nodos[0].estado == EXPANDIDO
+       && h < nodos[0].primer_hijo + nodos[0].num_hijos; h++)
+  {
+    PosicionBits q = jugar(raiz, nodos[h].columna);
+    if (iguales(q, p))
+      nueva = h;
+    for (int32_t n = nodos[h].primer_hijo; nueva == -1 && nodos[h].estado == EXPANDIDO
+         && n < nodos[h].primer_hijo + nodos[h].num_hijos; n++)
+      if (iguales(jugar(q, nodos[n].columna), p))
+        nueva = n;
+  }
+
+  if (nueva == -1)
+  {
+    Nodo& r = nodos[0];
+    r.visitas = r.puntos = 0;
+    r.primer_hijo = -1;
+    r.num_hijos = 0;
+    r.columna = 0;
+    r.estado = HOJA;
+    r.fin = SIGUE;
+    usados = 1;
+  }
+  else if (nueva != 0)
+    compactar(nueva);
+
+  raiz = p;
+  hay_arbol = true;
+}
+
+/* _________________________________________________________________________ */
+
+int32_t MonteCarlo::masVisitado(int32_t n) const
+{
+  if (nodos[n].estado != EXPANDIDO)
+    return -1;
+
+  int32_t mejor = -1;
+  for (int32_t h = nodos[n].primer_hijo; h < nodos[n].primer_hijo + nodos[n].num_hijos; h++)
+  {
+    if (nodos[h].fin == GANA)
+      return h;
+    if (mejor == -1 || nodos[h].visitas > nodos[mejor].visitas)
+      mejor = h;
+  }
+  return mejor;
+}
+
+/* _________________________________________________________________________ */
+
+int MonteCarlo::mejorMovimiento(const Tablero& t)
+{
+  dejarDePensar();
+
+  chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+  cambiarRaiz(aPosicion(t));
+
+  con_limite = params.tiempo_ms > 0;
+  limite = inicio + chrono::milliseconds(params.tiempo_ms);
+  parar = false;
+  pedidas = con_limite ? LONG_MAX : params.simulaciones;
+  buscar(inicio);
+
+  int mejor_col = -1;
+  respuesta_esperada = -1;
+  valor = 0;
+  int32_t mejor = masVisitado(0);
+  if (mejor != -1)
+  {
+    mejor_col = nodos[mejor].columna;
+    if (nodos[mejor].fin == GANA)
+      valor = 1;
+    else if (nodos[mejor].visitas > 0)
+      valor = (double) nodos[mejor].puntos / nodos[mejor].visitas - 1;
+    int32_t respuesta = masVisitado(mejor);
+    if (respuesta != -1)
+      respuesta_esperada = nodos[respuesta].columna;
+  }
+
+  // Por si no había sitio para expandir la raíz
+  for (int col = 0; col < t.GetColumnas() && mejor_col == -1; col++)
+    if (t.hayHueco(col) > -1)
+      mejor_col = col;
+
+  ultima_columna = mejor_col;
+  return mejor_col;
+}
+
+/* _________________________________________________________________________ */
+
+void MonteCarlo::pensar(const Tablero& t)
+{
+  dejarDePensar();
+
+  // Si el tablero es el de la última jugada seguida de una respuesta, se
+  // piensa desde la última jugada: así sirve para cualquier respuesta
+  PosicionBits p = aPosicion(t);
+  if (hay_arbol && ultima_columna != -1 && t.GetUltCol() != -1
+      && (jugables(raiz) & columna(ultima_columna)))
+  {
+    PosicionBits q = jugar(raiz, ultima_columna);
+    if ((jugables(q) & columna(t.GetUltCol()))
+        && iguales(jugar(q, t.GetUltCol()), p))
+      p = q;
+  }
+  cambiarRaiz(p);
+
+  con_limite = false;
+  parar = false;
+  pedidas = LONG_MAX;
+  pensador.reset(new thread([this]() {
+    buscar(chrono::steady_clock::now());
+  }));
+}
+
+/* _________________________________________________________________________ */
+
+void MonteCarlo::dejarDePensar()
+{
+  if (!pensador)
+    return;
+
+  __atomic_store_n(&parar, true, __ATOMIC_RELAXED);
+  pensador->join();
+  pensador.reset();
+}
+
+/* _________________________________________________________________________ */
+
+long MonteCarlo::GetNodos() const
+{
+  long total = 0;
+  for (size_t i = 0; i < hilos.size(); i++)
+    total += hilos[i].simulaciones;
+  return total;
+}
+
+/* _________________________________________________________________________ */
+
+int MonteCarlo::GetProfundidad() const
+{
+  int profundidad = 0;
+  for (size_t i = 0; i < hilos.size(); i++)
+    profundidad = max(profundidad, hilos[i].profundidad);
+  return profundidad;
+}
+
+/* _________________________________________________________________________ */
+
+void MonteCarlo::mostrarRendimiento(ostream& os) const
+{
+  long total = 0;
+
+  for (size_t i = 0; i < hilos.size(); i++)
+  {
+    total += hilos[i].simulaciones_total;
+    os << "Hilo " << i << ": " << hilos[i].simulaciones_total << " simulaciones, "
+       << (long) (segundos_total > 0 ? hilos[i].simulaciones_total / segundos_total : 0)
+       << " simulaciones/s" << endl;
+  }
+  os << "Total: " << total << " simulaciones, "
+     << (long) (segundos_total > 0 ? total / segundos_total : 0)
+     << " simulaciones/s" << endl;
+  os << "Árbol: " << min((size_t) usados, nodos.size()) << " de " << nodos.size()
+     << " nodos" << endl;
+}
+
+/* Fin fichero: monte_carlo.cpp */
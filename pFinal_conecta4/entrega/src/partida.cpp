@@ -0,0 +1,117 @@
+/**
+ * @file partida.cpp
+ * @brief Implementación de funciones del TDA Partida
+ *
+ */
+
+#include <sstream>
+#include <string>
+#include "partida.h"
+
+using namespace std;
+
+/* _________________________________________________________________________ */
+
+Partida::Partida()
+  : filas(4), columnas(4), fichas_ganar(Tablero::N_FICHAS_GANAR), primero(1)
+{
+}
+
+/* _________________________________________________________________________ */
+
+Partida::Partida(const Tablero& inicial)
+  : filas(inicial.GetFilas()), columnas(inicial.GetColumnas()),
+    fichas_ganar(inicial.GetFichasGanar()), primero(inicial.GetTurno())
+{
+}
+
+/* _________________________________________________________________________ */
+
+Tablero Partida::tablero(size_t n) const
+{
+  Tablero t(filas, columnas, fichas_ganar);
+  if (primero == 2)
+    t.cambiarTurno();
+
+  for (size_t i = 0; i < n; i++)
+  {
+    t.colocarFicha(jugadas[i]);
+    t.cambiarTurno();
+  }
+  return t;
+}
+
+/* _________________________________________________________________________ */
+
+int Partida::GetGanador() const
+{
+  return tablero(jugadas.size()).quienGanaUltimo();
+}
+
+/* _________________________________________________________________________ */
+
+ostream& operator<<(ostream& os, const Partida& p)
+{
+  os << p.filas << " " << p.columnas << " " << p.fichas_ganar << " "
+     << p.primero << " :";
+  for (size_t i = 0; i < p.jugadas.size(); i++)
+    os << " " << p.jugadas[i];
+  os << "\n";
+
+  return os;
+}
+
+/* _________________________________________________________________________ */
+
+istream& operator>>(istream& is, Partida& p)
+{
+  string linea;
+
+  // Siguiente línea que no esté vacía ni sea un comentario
+  do
+  {
+    if (!getline(is, linea))
+      return is;
+  } while (linea.find_first_not_of(" \t\r") == string::npos || linea[0] == '#');
+
+  istringstream entrada(linea);
+  Partida leida;
+  string separador;
+  int col;
+
+  bool correcta = (entrada >> leida.filas >> leida.columnas
+                           >> leida.fichas_ganar >> leida.primero >> separador)
+                  && separador == ":"
+                  && leida.filas >= 1 && leida.filas <= Partida::MAX_LADO
+                  && leida.columnas >= 1 && leida.columnas <= Partida::MAX_LADO
+                  && leida.fichas_ganar >= 2
+                  && leida.fichas_ganar <= Tablero::MAX_FICHAS_GANAR
+                  && (leida.primero == 1 || leida.primero == 2);
+
+  // Las jugadas deben caber y no seguir a una partida ya acabada
+  if (correcta)
+  {
+    Tablero t = leida.tablero(0);
+    while (correcta && entrada >> col)
+    {
+      correcta = col >= 0 && col < leida.columnas && t.hayHueco(col) >= 0
+                 && !t.quienGanaUltimo();
+      if (correcta)
+      {
+        t.colocarFicha(col);
+        t.cambiarTurno();
+        leida.jugadas.push_back(col);
+      }
+    }
+    correcta = correcta && entrada.eof();
+  }
+
+  if (correcta)
+    p = leida;
+  else
+    is.setstate(ios::failbit);
+
+  return is;
+}
+
+/* Fin fichero: partida.cpp */
@@ -0,0 +1,101 @@
+/**
+ * @file posicion.cpp
+ * @brief Implementación de funciones del TDA Posicion
+ *
+ */
+
+#include <type_traits>
+#include "posicion.h"
+
+using namespace std;
+
+static_assert(is_trivially_copyable<Posicion>::value,
+              "Posicion debe poder copiarse con memcpy");
+
+/* _________________________________________________________________________ */
+
+Posicion::Posicion()
+  : filas(0), columnas(0), fichas_ganar(Tablero::N_FICHAS_GANAR), ult_col(-1), ult_fila(-1), turno(1), ganador(0)
+{
+  for (int p = 0; p < PALABRAS; p++)
+    fichas[0][p] = fichas[1][p] = 0;
+}
+
+/* _________________________________________________________________________ */
+
+Posicion::Posicion(const Tablero& t)
+  : filas(t.GetFilas()), columnas(t.GetColumnas()),
+    fichas_ganar(t.GetFichasGanar()), ult_col(t.GetUltCol()),
+    ult_fila(t.GetUltFila()), turno(t.GetTurno()), ganador(t.quienGanaUltimo())
+{
+  for (int p = 0; p < PALABRAS; p++)
+    fichas[0][p] = fichas[1][p] = 0;
+
+  for (int j = 0; j < columnas; j++)
+    for (int i = filas - 1; i >= 0; i--)
+    {
+      int ficha = t.GetElemento(i, j);
+      if (ficha == 0)
+        break;    // Por encima del primer hueco no hay más fichas
+
+      int k = indice(i, j);
+      fichas[ficha - 1][k >> 6] |= (uint64_t) 1 << (k & 63);
+    }
+}
+
+/* _________________________________________________________________________ */
+
+bool Posicion::mismoEstado(const Posicion& p) const
+{
+  if (filas != p.filas || columnas != p.columnas || fichas_ganar != p.fichas_ganar
+      || turno != p.turno)
+    return false;
+
+  for (int k = 0; k < PALABRAS; k++)
+    if (fichas[0][k] != p.fichas[0][k] || fichas[1][k] != p.fichas[1][k])
+      return false;
+  return true;
+}
+
+/* _________________________________________________________________________ */
+
+Tablero Posicion::aTablero() const
+{
+  Tablero t(filas, columnas, fichas_ganar);
+
+  // Colocar las fichas columna a columna, de abajo arriba. La última ficha
+  // se coloca la última, para que el tablero sepa cuál fue
+  for (int n = 0; n <= columnas; n++)
+  {
+    int j = (n < columnas) ? n : ult_col;
+    if (j == -1 || (n < columnas && j == ult_col))
+      continue;
+
+    for (int i = filas - 1; i >= 0 && GetElemento(i, j) != 0; i--)
+    {
+      if (t.GetTurno() != GetElemento(i, j))
+        t.cambiarTurno();
+      t.colocarFicha(j);
+    }
+  }
+
+  if (t.GetTurno() != turno)
+    t.cambiarTurno();
+
+  return t;
+}
+
+/* _________________________________________________________________________ */
+
+int Posicion::hayHueco(int pos) const
+{
+  if (pos < 0 || pos >= columnas)
+    return -1;
+
+  int i = filas - 1;
+  while (i >= 0 && GetElemento(i, pos) != 0)
+    i--;
+  return i;
+}
+
+/* Fin fichero: posicion.cpp */
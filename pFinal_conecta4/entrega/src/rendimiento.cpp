@@ -0,0 +1,380 @@
+/**
+ * @file rendimiento.cpp
+ * @brief Mide el rendimiento del jugador automático y del tablero
+ *
+ * Este programa lee un fichero de posiciones (ver datos/posiciones.txt) y
+ * mide por separado, en cada una, el tiempo de colocarFicha, quienGana,
+ * Evaluador::contarAlineadas, la construcción del árbol de soluciones
+ * (generarArbolSoluciones) y elegirMovimiento con las métricas pedidas.
+ * Cada medida se repite varias veces, después de unas repeticiones de
+ * calentamiento que no se cuentan.
+ *
+ * El resultado se escribe en formato CSV, con una fila por operación y
+ * tamaño de tablero: la mediana y el percentil 95 de los tiempos, los nodos
+ * medios que se han creado o visitado y, para los motores que podan, las
+ * podas medias y el porcentaje que provocó la primera jugada probada. Así se
+ * pueden comparar las representaciones del tablero (make BITBOARD=0), los
+ * motores de búsqueda entre versiones o, con -o, la búsqueda alfa-beta con
+ * el orden dinámico de jugadas (asesinas e historia) y sin él.
+ *
+ * Para ver la lista de argumentos que admite, ejecutar el programa
+ * con el modificador -h para ver la ayuda.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "evaluador.h"
+#include "jugador_auto.h"
+
+using namespace std;
+
+/**
+ * @brief Tiempos y nodos de una operación en un tamaño de tablero.
+ */
+struct Medida
+{
+  vector<double> ns;    ///< Nanosegundos de cada repetición
+  long nodos;           ///< Nodos de todas las repeticiones
+  long cortes;          ///< Podas de todas las repeticiones
+  long cortes_primera;  ///< Podas provocadas por la primera jugada probada
+
+  Medida() : nodos(0), cortes(0), cortes_primera(0) { }
+};
+
+/**
+ * @brief Operación del jugador que se mide.
+ */
+struct Operacion
+{
+  string nombre;        ///< Nombre en el CSV
+  int metrica;          ///< Métrica del jugador
+  bool orden_dinamico;  ///< Orden dinámico de la búsqueda alfa-beta
+};
+
+/// Veces que se repiten las operaciones del tablero dentro de cada medida
+const int LOTE = 1000;
+
+/// Resultado de quienGana, para que el compilador no quite las llamadas
+volatile int sumidero;
+
+/**
+ * @brief Lee un fichero de posiciones.
+ * @param fichero Ruta del fichero. Cada línea tiene las filas, las columnas y
+ * las columnas (desde 0) de las fichas colocadas; se ignoran las líneas
+ * vacías y las que empiezan por #.
+ * @param posiciones Vector donde se añaden los tableros leídos
+ * @return true si se ha leído el fichero entero sin errores.
+ */
+bool LeerPosiciones(const string& fichero, vector<Tablero>& posiciones)
+{
+  ifstream entrada(fichero.c_str());
+  string linea;
+  int num_linea = 0;
+
+  if (!entrada)
+  {
+    cout << "Error: no se ha podido abrir " << fichero << endl;
+    return false;
+  }
+
+  while (getline(entrada, linea))
+  {
+    num_linea++;
+    istringstream is(linea);
+    int filas, cols, col;
+    if (linea.empty() || linea[0] == '#' || !(is >> filas))
+      continue;
+
+    if (!(is >> cols) || filas < 1 || cols < 1)
+    {
+      cout << "Error: tamaño de tablero incorrecto en la línea " << num_linea << endl;
+      return false;
+    }
+
+    Tablero t(filas, cols);
+    while (is >> col)
+    {
+      if (col < 0 || col >= cols || t.hayHueco(col) < 0 || t.quienGanaUltimo())
+      {
+        cout << "Error: jugada incorrecta en la línea " << num_linea << endl;
+        return false;
+      }
+      t.colocarFicha(col);
+      t.cambiarTurno();
+    }
+
+    if (t.estaLleno() || t.quienGanaUltimo())
+    {
+      cout << "Error: la partida de la línea " << num_linea << " ha terminado" << endl;
+      return false;
+    }
+    posiciones.push_back(t);
+  }
+
+  return true;
+}
+
+/**
+ * @brief Devuelve un percentil de unos tiempos.
+ * @param v Tiempos. Se ordenan.
+ * @param p Percentil, entre 0 y 1
+ */
+double Percentil(vector<double>& v, double p)
+{
+  sort(v.begin(), v.end());
+  int i = (int) ceil(p * v.size()) - 1;
+  return v[max(i, 0)];
+}
+
+/**
+ * @brief Mide una operación varias veces.
+ * @param m Medida donde se añaden los tiempos
+ * @param calentamiento Repeticiones que no se cuentan
+ * @param repeticiones Repeticiones que se cuentan
+ * @param operacion Función que hace la operación y devuelve cuántas veces
+ * la ha hecho (el tiempo se divide entre ese número)
+ */
+template <class Funcion>
+void Medir(Medida& m, int calentamiento, int repeticiones, Funcion operacion)
+{
+  for (int r = 0; r < calentamiento + repeticiones; r++)
+  {
+    chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+    long veces = operacion();
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - inicio).count();
+    if (r >= calentamiento)
+      m.ns.push_back(ns / veces);
+  }
+}
+
+/**
+ * @brief Devuelve la medida de una operación en un tamaño de tablero,
+ * creándola si es la primera vez.
+ * @param medidas Medidas por operación y tamaño
+ * @param orden Claves de las medidas, en el orden en que se crearon
+ * @param operacion Nombre de la operación
+ * @param tam Tamaño del tablero (filas x columnas)
+ */
+Medida& Buscar(map<pair<string, string>, Medida>& medidas,
+               vector<pair<string, string> >& orden,
+               const string& operacion, const string& tam)
+{
+  pair<string, string> clave(operacion, tam);
+  if (medidas.find(clave) == medidas.end())
+    orden.push_back(clave);
+  return medidas[clave];
+}
+
+int main(int argc, char **argv)
+{
+  int calentamiento = 2, repeticiones = 10;
+  string fichero;
+  vector<int> metricas;
+  ParametrosBusqueda params;
+  bool opc_ayuda = false, comparar_orden = false;
+
+  // Con semilla fija, las métricas al azar repiten el trabajo en cada medida
+  params.semilla = 1;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (string(argv[i]) == "-i" && i + 1 < argc)
+      fichero = argv[++i];
+    else if (string(argv[i]) == "-m" && i + 1 < argc)
+    {
+      JugadorAuto::Estrategia estrategia;
+      if (!JugadorAuto::buscarEstrategia(argv[++i], estrategia))
+      {
+        cout << "Error: no hay ninguna métrica " << argv[i] << "." << endl;
+        return 1;
+      }
+      metricas.push_back(estrategia.numero);
+    }
+    else if (string(argv[i]) == "-w" && i + 1 < argc)
+      calentamiento = stoi(argv[++i]);
+    else if (string(argv[i]) == "-n" && i + 1 < argc)
+      repeticiones = stoi(argv[++i]);
+    else if (string(argv[i]) == "-p" && i + 1 < argc)
+      params.profundidad = stoi(argv[++i]);
+    else if (string(argv[i]) == "-r" && i + 1 < argc)
+      params.memoria_tt = stoi(argv[++i]);
+    else if (string(argv[i]) == "-b" && i + 1 < argc)
+      params.libro = argv[++i];
+    else if (string(argv[i]) == "-e" && i + 1 < argc)
+      params.casillas_final = stoi(argv[++i]);
+    else if (string(argv[i]) == "-j" && i + 1 < argc)
+      params.hilos = stoi(argv[++i]);
+    else if (string(argv[i]) == "-o")
+      comparar_orden = true;
+    else
+      opc_ayuda = true;
+  }
+
+  if (opc_ayuda || fichero.empty() || calentamiento < 0 || repeticiones < 1)
+  {
+    cout << "uso: rendimiento -i fichero [-m métrica]... [-w número] [-n número] [-p número]" << endl;
+    cout << "                 [-r número] [-b fichero] [-e número] [-j número] [-o]" << endl;
+    cout << "i : fichero de posiciones (ver datos/posiciones.txt)" << endl;
+    cout << "m : métrica de elegirMovimiento, por número o por nombre; se puede repetir" << endl;
+    cout << "    (por defecto 1 y 5):" << endl;
+    JugadorAuto::mostrarEstrategias(cout, "    ");
+    cout << "w : repeticiones de calentamiento (por defecto 2)" << endl;
+    cout << "n : repeticiones que se miden (por defecto 10)" << endl;
+    cout << "p : profundidad de la búsqueda alfa-beta (métrica 5, por defecto 10)" << endl;
+    cout << "r : memoria (MB) de la tabla de transposición (métrica 5)" << endl;
+    cout << "b : libro de aperturas para las métricas 1, 2, 5 y 6 (por defecto ninguno)" << endl;
+    cout << "e : casillas libres a partir de las que se resuelve el final (por defecto 0)" << endl;
+    cout << "j : hilos del jugador (árbol de soluciones y métrica 6; por defecto 1, 0 para" << endl;
+    cout << "    usar todos los núcleos)" << endl;
+    cout << "o : mide también la métrica 5 sin orden dinámico (sin jugadas asesinas ni" << endl;
+    cout << "    historia), para comparar sus nodos y podas" << endl;
+    return 1;
+  }
+
+  if (metricas.empty())
+  {
+    metricas.push_back(1);
+    metricas.push_back(5);
+  }
+
+  vector<Tablero> posiciones;
+  if (!LeerPosiciones(fichero, posiciones))
+    return 1;
+
+  // Medidas por operación y tamaño de tablero, en el orden en que aparecen
+  map<pair<string, string>, Medida> medidas;
+  vector<pair<string, string> > orden;
+  map<string, bool> bitboard;
+
+  for (size_t p = 0; p < posiciones.size(); p++)
+  {
+    const Tablero& inicial = posiciones[p];
+    ostringstream os;
+    os << inicial.GetFilas() << 'x' << inicial.GetColumnas();
+    string tam = os.str();
+    bitboard[tam] = inicial.UsaBitboard();
+
+    bool cabe = Posicion::cabe(inicial.GetFilas(), inicial.GetColumnas());
+
+    // colocarFicha (y su quitarFicha) en cada columna libre
+    Medir(Buscar(medidas, orden, "colocarFicha", tam), calentamiento, repeticiones, [&]() {
+      Tablero t(inicial);
+      int col_anterior = t.GetUltCol();
+      long veces = 0;
+      for (int l = 0; l < LOTE; l++)
+      {
+        for (int col = 0; col < t.GetColumnas(); col++)
+        {
+          if (t.hayHueco(col) > -1)
+          {
+            t.colocarFicha(col);
+            t.quitarFicha(col, col_anterior);
+            veces++;
+          }
+        }
+      }
+      return veces;
+    });
+
+    // quienGana sobre el tablero completo
+    Medir(Buscar(medidas, orden, "quienGana", tam), calentamiento, repeticiones, [&]() {
+      Tablero t(inicial);
+      for (int l = 0; l < LOTE; l++)
+        sumidero = t.quienGana();
+      return (long) LOTE;
+    });
+
+    // Alineaciones de la última ficha, como al puntuar los nodos de la
+    // métrica 1
+    if (cabe && !inicial.estaVacio())
+    {
+      Evaluador evaluador(inicial.GetFilas(), inicial.GetColumnas(), inicial.GetFichasGanar());
+      Posicion pos(inicial);
+      Medir(Buscar(medidas, orden, "contarAlineadas", tam), calentamiento, repeticiones, [&]() {
+        int alineadas1, alineadas2;
+        for (int l = 0; l < LOTE; l++)
+        {
+          evaluador.contarAlineadas(pos, alineadas1, alineadas2);
+          sumidero = alineadas1 + alineadas2;
+        }
+        return (long) LOTE;
+      });
+    }
+
+    // Operaciones del jugador: la construcción del árbol (con la métrica 1)
+    // y elegirMovimiento con cada métrica. Cada métrica sólo se mide si
+    // admite el tamaño del tablero (las que usan el árbol, si cabe en una
+    // Posicion)
+    vector<Operacion> operaciones;
+    if (cabe)
+      operaciones.push_back({"generarArbolSoluciones", 1, true});
+    for (size_t k = 0; k < metricas.size(); k++)
+    {
+      JugadorAuto::Estrategia estrategia;
+      JugadorAuto::buscarEstrategia(metricas[k], estrategia);
+      if (estrategia.cabe && !estrategia.cabe(inicial.GetFilas(), inicial.GetColumnas()))
+        continue;
+      string nombre = "elegirMovimiento(m" + to_string(metricas[k]);
+      operaciones.push_back({nombre + ")", metricas[k], true});
+      if (comparar_orden && metricas[k] == 5)
+        operaciones.push_back({nombre + " sin orden dinámico)", metricas[k], false});
+    }
+
+    for (size_t k = 0; k < operaciones.size(); k++)
+    {
+      Medida& m = Buscar(medidas, orden, operaciones[k].nombre, tam);
+      bool arbol = operaciones[k].nombre == "generarArbolSoluciones";
+      ParametrosBusqueda params_op(params);
+      params_op.orden_dinamico = operaciones[k].orden_dinamico;
+
+      // Cada repetición usa un jugador nuevo, sin nada calculado; crearlo
+      // (y reservar su tabla) no se mide
+      for (int r = 0; r < calentamiento + repeticiones; r++)
+      {
+        JugadorAuto jugador(inicial, operaciones[k].metrica, params_op);
+        Medida una;
+        if (arbol)
+          Medir(una, 0, 1, [&]() { jugador.construirArbol(); return 1L; });
+        else
+          Medir(una, 0, 1, [&]() { sumidero = jugador.elegirMovimiento(); return 1L; });
+
+        if (r >= calentamiento)
+        {
+          m.ns.push_back(una.ns[0]);
+          m.nodos += jugador.GetNodos();
+          if (jugador.GetMotor())
+          {
+            long primera = 0;
+            m.cortes += jugador.GetMotor()->GetCortes(&primera);
+            m.cortes_primera += primera;
+          }
+        }
+      }
+    }
+  }
+
+  cout << fixed << setprecision(1);
+  cout << "operacion,tablero,bitboard,muestras,mediana_ns,p95_ns,nodos_medios,"
+       << "podas_medias,podas_primera_pct" << endl;
+  for (size_t k = 0; k < orden.size(); k++)
+  {
+    Medida& m = medidas[orden[k]];
+    cout << orden[k].first << ',' << orden[k].second << ',' << bitboard[orden[k].second]
+         << ',' << m.ns.size() << ',' << Percentil(m.ns, 0.5) << ','
+         << Percentil(m.ns, 0.95) << ',' << (long) (m.nodos / m.ns.size()) << ','
+         << (long) (m.cortes / m.ns.size()) << ','
+         << (m.cortes > 0 ? 100.0 * m.cortes_primera / m.cortes : 0.0) << endl;
+  }
+
+  return 0;
+}
+
+/* Fin fichero: rendimiento.cpp */
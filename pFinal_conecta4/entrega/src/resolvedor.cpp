@@ -0,0 +1,237 @@
+/**
+ * @file resolvedor.cpp
+ * @brief Implementación de funciones del TDA Resolvedor
+ *
+ */
+
+#include <mutex>
+#include <vector>
+#include "posicion.h"
+#include "resolvedor.h"
+
+using namespace std;
+
+// Funciones auxiliares
+namespace
+{
+  /**
+   * @brief Posición ya resuelta desde la raíz. Se guarda la posición entera
+   * para comprobar que la entrada es de la posición buscada y no de otra con
+   * la misma clave.
+   */
+  struct Resuelta
+  {
+    Posicion pos;
+    bool ocupada;
+    int8_t resultado;
+    int8_t columna;
+
+    Resuelta() : ocupada(false), resultado(0), columna(-1) { }
+  };
+
+  /// Entradas de la caché de todo el programa. El tamaño es fijo, así que la
+  /// caché no crece en las series largas de partidas: una posición nueva
+  /// sustituye a la que ocupaba su entrada.
+  const size_t ENTRADAS_CACHE = 1 << 16;
+
+  mutex cerrojo;                                ///< Protege la caché
+
+  /**
+   * @brief Caché de todo el programa (se reserva la primera vez que se usa).
+   */
+  vector<Resuelta>& resueltas()
+  {
+    static vector<Resuelta> cache(ENTRADAS_CACHE);
+    return cache;
+  }
+
+  /**
+   * @brief Entrada de un tablero en la caché. La clave Zobrist no depende
+   * del tamaño del tablero ni de las fichas para ganar, así que se mezcla
+   * con ellos.
+   */
+  size_t entradaCache(const Tablero& t)
+  {
+    uint64_t clave = t.GetClave() ^ ((uint64_t) t.GetFilas() << 56)
+                                  ^ ((uint64_t) t.GetColumnas() << 48)
+                                  ^ ((uint64_t) t.GetFichasGanar() << 40);
+    return clave % ENTRADAS_CACHE;
+  }
+
+  /**
+   * @brief Columna que ocupa la posición i en el orden de exploración:
+   * primero la central y después alternando a izquierda y derecha.
+   */
+  inline int columnaOrden(int i, int num_cols)
+  {
+    int mitad = num_cols / 2;
+    return (i % 2 == 0) ? mitad + i / 2 : mitad - (i + 1) / 2;
+  }
+}
+
+/* _________________________________________________________________________ */
+
+Resolvedor::Resolvedor(int megas)
+  : tabla(megas), nodos(0)
+{
+}
+
+/* _________________________________________________________________________ */
+
+int Resolvedor::casillasLibres(const Tablero& t)
+{
+  int libres = 0;
+  for (int col = 0; col < t.GetColumnas(); col++)
+    libres += t.hayHueco(col) + 1;
+  return libres;
+}
+
+/* _________________________________________________________________________ */
+
+int Resolvedor::negamax(Tablero& t, int alfa, int beta)
+{
+  int num_cols = t.GetColumnas();
+  int col_anterior = t.GetUltCol();
+
+  nodos++;
+
+  // Si alguna ficha gana ya, no hace falta buscar más
+  for (int col = 0; col < num_cols; col++)
+  {
+    if (t.hayHueco(col) > -1)
+    {
+      t.colocarFicha(col);
+      bool gana = t.quienGanaUltimo() != 0;
+      t.quitarFicha(col, col_anterior);
+      if (gana)
+        return GANA;
+    }
+  }
+
+  if (t.estaLleno())
+    return EMPATA;
+
+  // Los resultados no dependen de la profundidad: cualquier entrada sirve
+  TablaTransposicion::Entrada e;
+  if (tabla.buscar(t.GetClave(), e))
+  {
+    if (e.cota == TablaTransposicion::EXACTA
+        || (e.cota == TablaTransposicion::INFERIOR && e.valor >= beta)
+        || (e.cota == TablaTransposicion::SUPERIOR && e.valor <= alfa))
+      return e.valor;
+  }
+
+  int alfa_inicial = alfa;
+  int mejor = PIERDE;
+  int mejor_col = -1;
+
+  for (int i = 0; i < num_cols && alfa < beta; i++)
+  {
+    int col = columnaOrden(i, num_cols);
+    if (t.hayHueco(col) < 0)
+      continue;
+
+    t.colocarFicha(col);
+    t.cambiarTurno();
+    int valor = -negamax(t, -beta, -alfa);
+    t.cambiarTurno();
+    t.quitarFicha(col, col_anterior);
+
+    if (valor > mejor)
+    {
+      mejor = valor;
+      mejor_col = col;
+    }
+    if (mejor > alfa)
+      alfa = mejor;
+  }
+
+  e.valor = mejor;
+  e.profundidad = 0;
+  e.mejor_col = mejor_col;
+  if (mejor <= alfa_inicial)
+    e.cota = TablaTransposicion::SUPERIOR;
+  else if (mejor >= beta)
+    e.cota = TablaTransposicion::INFERIOR;
+  else
+    e.cota = TablaTransposicion::EXACTA;
+  tabla.guardar(t.GetClave(), e);
+
+  return mejor;
+}
+
+/* _________________________________________________________________________ */
+
+Resolvedor::Resultado Resolvedor::resolver(const Tablero& t, int& columna)
+{
+  // Los tableros que no caben en una Posicion no se guardan en la caché
+  bool en_cache = Posicion::cabe(t.GetFilas(), t.GetColumnas());
+  Posicion pos;
+  size_t entrada = 0;
+
+  if (en_cache)
+  {
+    pos = Posicion(t);
+    entrada = entradaCache(t);
+
+    lock_guard<mutex> lock(cerrojo);
+    const Resuelta& r = resueltas()[entrada];
+    if (r.ocupada && r.pos.mismoEstado(pos) && t.hayHueco(r.columna) > -1)
+    {
+      columna = r.columna;
+      return (Resultado) r.resultado;
+    }
+  }
+
+  Tablero tablero(t);
+  int num_cols = tablero.GetColumnas();
+  int col_anterior = tablero.GetUltCol();
+  int mejor = PIERDE;
+  columna = -1;
+
+  for (int i = 0; i < num_cols && mejor < GANA; i++)
+  {
+    int col = columnaOrden(i, num_cols);
+    if (tablero.hayHueco(col) < 0)
+      continue;
+    if (columna == -1)
+      columna = col;
+
+    tablero.colocarFicha(col);
+    if (tablero.quienGanaUltimo())
+    {
+      mejor = GANA;
+      columna = col;
+    }
+    else
+    {
+      // Ventana nula: ¿esta jugada mejora el mejor resultado conocido? Si
+      // lo mejora, se vuelve a preguntar con el nuevo, hasta que no mejore
+      tablero.cambiarTurno();
+      while (mejor < GANA)
+      {
+        int valor = -negamax(tablero, -mejor - 1, -mejor);
+        if (valor <= mejor)
+          break;
+        mejor = valor;
+        columna = col;
+      }
+      tablero.cambiarTurno();
+    }
+    tablero.quitarFicha(col, col_anterior);
+  }
+
+  if (en_cache)
+  {
+    lock_guard<mutex> lock(cerrojo);
+    Resuelta& r = resueltas()[entrada];
+    r.pos = pos;
+    r.ocupada = true;
+    r.resultado = mejor;
+    r.columna = columna;
+  }
+
+  return (Resultado) mejor;
+}
+
+/* Fin fichero: resolvedor.cpp */
@@ -0,0 +1,115 @@
+/**
+ * @file tabla_transposicion.cpp
+ * @brief Implementación de funciones del TDA TablaTransposicion
+ *
+ */
+
+#include "tabla_transposicion.h"
+
+using namespace std;
+
+/* _________________________________________________________________________ */
+
+TablaTransposicion::TablaTransposicion(int megas)
+  : mascara(0)
+{
+  // Mayor potencia de dos de celdas que cabe en la memoria indicada
+  uint64_t max_celdas = ((uint64_t) megas << 20) / sizeof(Celda);
+  uint64_t num_celdas = 1;
+
+  if (max_celdas == 0)
+    return;
+
+  while (num_celdas * 2 <= max_celdas)
+    num_celdas *= 2;
+
+  celdas.resize(num_celdas);
+  mascara = num_celdas - 1;
+  limpiar();
+}
+
+/* _________________________________________________________________________ */
+
+uint64_t TablaTransposicion::empaquetar(const Entrada& e)
+{
+  // | valor (32) | profundidad (16) | cota + 1 (8) | mejor_col + 1 (8) |
+  // La cota se guarda sumando 1 para que una celda ocupada nunca valga 0
+  return ((uint64_t)(uint32_t) e.valor << 32)
+         | ((uint64_t)(e.profundidad & 0xFFFF) << 16)
+         | ((uint64_t)((e.cota + 1) & 0xFF) << 8)
+         | (uint64_t)((e.mejor_col + 1) & 0xFF);
+}
+
+/* _________________________________________________________________________ */
+
+TablaTransposicion::Entrada TablaTransposicion::desempaquetar(uint64_t datos)
+{
+  Entrada e;
+  e.valor = (int32_t)(uint32_t)(datos >> 32);
+  e.profundidad = (int)((datos >> 16) & 0xFFFF);
+  e.cota = (TipoCota)(((datos >> 8) & 0xFF) - 1);
+  e.mejor_col = (int)(datos & 0xFF) - 1;
+  return e;
+}
+
+/* _________________________________________________________________________ */
+
+uint64_t TablaTransposicion::leer(uint64_t clave) const
+{
+  const Celda& c = celdas[clave & mascara];
+
+  // Lecturas atómicas sueltas: otro hilo puede estar escribiendo la celda
+  uint64_t datos = __atomic_load_n(&c.datos, __ATOMIC_RELAXED);
+  uint64_t mezcla = __atomic_load_n(&c.clave, __ATOMIC_RELAXED);
+
+  if (datos == 0 || (mezcla ^ datos) != clave)
+    return 0;
+  return datos;
+}
+
+/* _________________________________________________________________________ */
+
+bool TablaTransposicion::buscar(uint64_t clave, Entrada& e) const
+{
+  if (celdas.empty())
+    return false;
+
+  uint64_t datos = leer(clave);
+  if (datos == 0)
+    return false;
+
+  e = desempaquetar(datos);
+  return true;
+}
+
+/* _________________________________________________________________________ */
+
+void TablaTransposicion::guardar(uint64_t clave, const Entrada& e)
+{
+  if (celdas.empty())
+    return;
+
+  Celda& c = celdas[clave & mascara];
+
+  // Con la misma posición sólo reemplazamos por búsquedas más profundas
+  uint64_t anterior = leer(clave);
+  if (anterior != 0 && desempaquetar(anterior).profundidad > e.profundidad)
+    return;
+
+  uint64_t datos = empaquetar(e);
+  __atomic_store_n(&c.clave, clave ^ datos, __ATOMIC_RELAXED);
+  __atomic_store_n(&c.datos, datos, __ATOMIC_RELAXED);
+}
+
+/* _________________________________________________________________________ */
+
+void TablaTransposicion::limpiar()
+{
+  for (size_t i = 0; i < celdas.size(); i++)
+  {
+    celdas[i].clave = 0;
+    celdas[i].datos = 0;
+  }
+}
+
+/* Fin fichero: tabla_transposicion.cpp */
@@ -5,6 +5,7 @@
  */
 
 #include <iostream>
+#include <utility>
 #include "tablero.h"
 
 using namespace std;
@@ -12,8 +13,166 @@ using namespace std;
 const string Tablero::COLOR_J1 = "\033[0;31m";  // Rojo
 const string Tablero::COLOR_J2 = "\033[0;33m";  // Amarillo
 
-void Tablero::reserve()
+// Funciones auxiliares
+namespace
 {
+  /**
+   * @brief Indica si un tablero de tamaño filas x columnas se representa con
+   * bitboards. Depende de la macro TABLERO_BITBOARD.
+   */
+  bool cabeEnBitboard(int filas, int columnas)
+  {
+#ifdef TABLERO_BITBOARD
+    return filas > 0 && filas < Tablero::MAX_CASILLAS_BB
+           && columnas > 0 && columnas <= Tablero::MAX_COLUMNAS_BB
+           && filas * columnas <= Tablero::MAX_CASILLAS_BB;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * @brief Función de mezcla de splitmix64. Convierte enteros consecutivos en
+   * valores de 64 bits bien distribuidos.
+   */
+  inline uint64_t mezclar(uint64_t x)
+  {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+  }
+
+  /**
+   * @brief Clave Zobrist de una ficha del jugador (1 o 2) en una casilla.
+   * Las casillas se numeran como los bits del bitboard.
+   */
+  inline uint64_t claveFicha(int casilla, int jugador)
+  {
+    return mezclar(2 * (uint64_t) casilla + jugador);
+  }
+
+  /// Clave Zobrist que se añade cuando le toca al jugador 2
+  const uint64_t CLAVE_TURNO = mezclar(0);
+
+  /**
+   * @brief Desplaza una máscara n bits hacia las casillas de menor índice.
+   * Los desplazamientos de 64 bits o más dejan la máscara vacía.
+   */
+  inline uint64_t desplazar(uint64_t b, int n)
+  {
+    return n < 64 ? b >> n : 0;
+  }
+
+  /**
+   * @brief Comprueba si hay n fichas consecutivas en una dirección.
+   * @param b Máscara con las fichas de un jugador
+   * @param desp Desplazamiento (en bits) entre dos casillas vecinas en esa dirección
+   * @param validos Casillas cuya vecina en esa dirección está dentro del tablero
+   * @param n Número de fichas a alinear
+   */
+  bool hayLineaDireccion(uint64_t b, int desp, uint64_t validos, int n)
+  {
+    // Tras k pasos, 'linea' marca las casillas desde las que empiezan k+1
+    // fichas consecutivas en la dirección dada.
+    uint64_t linea = b;
+    for (int k = 1; k < n && linea; ++k)
+      linea = b & desplazar(linea, desp) & validos;
+    return linea != 0;
+  }
+
+  /**
+   * @brief Versión de hayLineaDireccion con el desplazamiento y el número de
+   * fichas fijos. No corta el bucle al vaciarse la línea, para que el
+   * compilador pueda desenrollarlo por completo.
+   */
+  template <int DESP, int N>
+  inline uint64_t lineaFija(uint64_t b, uint64_t validos)
+  {
+    uint64_t linea = b;
+    for (int k = 1; k < N; ++k)
+      linea = b & (linea >> DESP) & validos;
+    return linea;
+  }
+
+  /**
+   * @brief Detector de líneas de un tablero de FILAS x COLUMNAS en el que se
+   * gana con N fichas en línea. Hace lo mismo que Tablero::hayLineaGenerica,
+   * pero todas las máscaras son constantes.
+   * @param b Máscara con las fichas de un jugador
+   */
+  template <int FILAS, int COLUMNAS, int N>
+  bool hayLineaFija(const Tablero&, uint64_t b)
+  {
+    static_assert(FILAS > 1 && FILAS * COLUMNAS <= Tablero::MAX_CASILLAS_BB,
+                  "El tablero debe caber en un bitboard");
+
+    constexpr uint64_t LLENO = Tablero::mascaraLleno(FILAS, COLUMNAS);
+    constexpr uint64_t FILA_INF = Tablero::mascaraFilaInf(FILAS, COLUMNAS);
+    constexpr uint64_t SIN_FILA_SUP = LLENO & ~(FILA_INF << (FILAS - 1));
+    constexpr uint64_t SIN_FILA_INF = LLENO & ~FILA_INF;
+    constexpr uint64_t SIN_ULT_COL = LLENO >> FILAS;
+
+    return (lineaFija<1, N>(b, SIN_FILA_SUP)                            // columnas
+            | lineaFija<FILAS, N>(b, SIN_ULT_COL)                       // filas
+            | lineaFija<FILAS - 1, N>(b, SIN_FILA_INF & SIN_ULT_COL)    // diagonal 1
+            | lineaFija<FILAS + 1, N>(b, SIN_FILA_SUP & SIN_ULT_COL))   // diagonal 2
+           != 0;
+  }
+
+  /**
+   * @brief Instancia de hayLineaFija para un tamaño de tablero.
+   */
+  struct Especializacion
+  {
+    int filas;
+    int columnas;
+    int fichas_ganar;
+    bool (*detector)(const Tablero&, uint64_t);
+  };
+
+  /// Tamaños de tablero con detector de líneas especializado
+  const Especializacion ESPECIALIZACIONES[] =
+  {
+    {6, 7, 4, hayLineaFija<6, 7, 4> },    // Tablero oficial
+    {4, 4, 4, hayLineaFija<4, 4, 4> },    // Tablero por defecto de conecta4
+    {5, 6, 4, hayLineaFija<5, 6, 4> },
+    {6, 6, 4, hayLineaFija<6, 6, 4> },
+    {7, 7, 4, hayLineaFija<7, 7, 4> },
+    {6, 9, 4, hayLineaFija<6, 9, 4> },
+    {7, 9, 4, hayLineaFija<7, 9, 4> },
+    {6, 7, 5, hayLineaFija<6, 7, 5> },
+    {8, 8, 5, hayLineaFija<8, 8, 5> },
+    {3, 3, 3, hayLineaFija<3, 3, 3> }
+  };
+}
+
+/* _________________________________________________________________________ */
+
+void Tablero::reserve(bool usar_bitboard)
+{
+  bitboard = usar_bitboard && cabeEnBitboard(filas, columnas);
+  fichas[0] = fichas[1] = 0;
+  lleno = fila_inf = 0;
+  for (int j = 0; j < MAX_COLUMNAS_BB; j++)
+    alturas[j] = 0;
+  detector = &Tablero::hayLineaGenerica;
+
+  if (bitboard)
+  {
+    uint64_t columna = ((uint64_t)1 << filas) - 1;
+    for (int j = 0; j < columnas; j++)
+    {
+      lleno |= columna << (j * filas);
+      fila_inf |= (uint64_t)1 << (j * filas);
+    }
+
+    for (const Especializacion& e : ESPECIALIZACIONES)
+      if (e.filas == filas && e.columnas == columnas && e.fichas_ganar == fichas_ganar)
+        detector = e.detector;
+    return;
+  }
+
   this->tablero.resize(filas);
   for(int i = 0; i < filas ; i ++)
   {
@@ -25,33 +184,80 @@ void Tablero::reserve()
 
 /* _________________________________________________________________________ */
 
+void Tablero::cargarBitboard(const vector<vector<int> >& m)
+{
+  fichas[0] = fichas[1] = 0;
+  for (int j = 0; j < columnas; j++)
+  {
+    // La altura es el número de filas por debajo del primer hueco (como hayHueco)
+    int i = 0;
+    while (i < filas && m[i][j] == 0)
+      i++;
+    alturas[j] = filas - i;
+
+    for (i = 0; i < filas; i++)
+    {
+      if (m[i][j] == 1 || m[i][j] == 2)
+        fichas[m[i][j] - 1] |= (uint64_t)1 << (j * filas + filas - 1 - i);
+    }
+  }
+}
+
+/* _________________________________________________________________________ */
+
 Tablero::Tablero()
-  : filas(0), columnas(0), turno(1), ult_col(-1)
+  : filas(0), columnas(0), fichas_ganar(N_FICHAS_GANAR), turno(1), ult_col(-1),
+    ult_fila(-1), clave(0), bitboard(false), detector(&Tablero::hayLineaGenerica)
 {
 }
 
 /* _________________________________________________________________________ */
 
-Tablero::Tablero(const int filas, const int columnas)
-  : filas(filas), columnas(columnas),
-    turno(1), ult_col(-1)
+Tablero::Tablero(const int filas, const int columnas, const int fichas_ganar,
+                 const bool usar_bitboard)
+  : filas(filas), columnas(columnas), fichas_ganar(fichas_ganar),
+    turno(1), ult_col(-1), ult_fila(-1), clave(0)
 {
-  reserve();
+  reserve(usar_bitboard);
 }
 
 /* _________________________________________________________________________ */
 
 Tablero::Tablero(const Tablero& t)
   : tablero(t.tablero), filas(t.filas),
-    columnas(t.columnas), turno(t.turno),
-    ult_col(t.ult_col)
+    columnas(t.columnas), fichas_ganar(t.fichas_ganar), turno(t.turno),
+    ult_col(t.ult_col), ult_fila(t.ult_fila), clave(t.clave),
+    bitboard(t.bitboard),
+    lleno(t.lleno), fila_inf(t.fila_inf), detector(t.detector)
 {
+  fichas[0] = t.fichas[0];
+  fichas[1] = t.fichas[1];
+  for (int j = 0; j < MAX_COLUMNAS_BB; j++)
+    alturas[j] = t.alturas[j];
+}
+
+/* _________________________________________________________________________ */
+
+Tablero::Tablero(Tablero&& t)
+  : tablero(move(t.tablero)), filas(t.filas),
+    columnas(t.columnas), fichas_ganar(t.fichas_ganar), turno(t.turno),
+    ult_col(t.ult_col), ult_fila(t.ult_fila), clave(t.clave),
+    bitboard(t.bitboard),
+    lleno(t.lleno), fila_inf(t.fila_inf), detector(t.detector)
+{
+  fichas[0] = t.fichas[0];
+  fichas[1] = t.fichas[1];
+  for (int j = 0; j < MAX_COLUMNAS_BB; j++)
+    alturas[j] = t.alturas[j];
 }
 
 /* _________________________________________________________________________ */
 
 bool Tablero::estaLleno()
 {
+  if (bitboard)
+    return (fichas[0] | fichas[1]) == lleno;
+
   bool sinHuecos = true;
   for (int i = 0; i < filas && sinHuecos; i++)
     for (int j = 0; j < columnas && sinHuecos; j++)
@@ -61,7 +267,7 @@ bool Tablero::estaLleno()
 
 /* _________________________________________________________________________ */
 
-int Tablero::hayHueco(int pos)
+int Tablero::hayHueco(int pos) const
 {
   int i = 0;               // Recorremos la matriz de arriba hacia abajo.
   bool encontrado = false;
@@ -70,6 +276,9 @@ int Tablero::hayHueco(int pos)
   if (pos < 0 || pos >= columnas)
     return -1;
 
+  if (bitboard)
+    return filas - 1 - alturas[pos];
+
   while (i < filas && !encontrado)
   {
     if (this->tablero[i][pos] != 0)
@@ -97,8 +306,13 @@ bool Tablero::colocarFicha(int pos)
   fila = hayHueco(pos);
   if (fila != -1)
   {
-    this->tablero[fila][pos] = turno;
+    if (bitboard)
+      fichas[turno - 1] |= (uint64_t)1 << (pos * filas + alturas[pos]++);
+    else
+      this->tablero[fila][pos] = turno;
+    clave ^= claveFicha(pos * filas + filas - 1 - fila, turno);
     ult_col = pos;
+    ult_fila = fila;
     return true;
   }
   return false;
@@ -106,20 +320,73 @@ bool Tablero::colocarFicha(int pos)
 
 /* _________________________________________________________________________ */
 
+bool Tablero::quitarFicha(int pos, int col_anterior)
+{
+  if (pos < 0 || pos >= columnas)
+    return false;
+
+  // La ficha más alta está justo debajo del hueco (fila 0 si está llena)
+  int fila = hayHueco(pos) + 1;
+  if (fila >= filas)
+    return false;
+
+  clave ^= claveFicha(pos * filas + filas - 1 - fila, GetElemento(fila, pos));
+  if (bitboard)
+  {
+    uint64_t bit = ~((uint64_t)1 << (pos * filas + --alturas[pos]));
+    fichas[0] &= bit;
+    fichas[1] &= bit;
+  }
+  else
+    this->tablero[fila][pos] = 0;
+
+  ult_col = col_anterior;
+  ult_fila = (col_anterior == -1) ? -1 : hayHueco(col_anterior) + 1;
+  return true;
+}
+
+/* _________________________________________________________________________ */
+
 int Tablero::cambiarTurno()
 {
   if (turno == 1)
     turno = 2;
   else
     turno = 1;
+  clave ^= CLAVE_TURNO;
   return turno;
 }
 
 /* _________________________________________________________________________ */
 
+void Tablero::calcularClave()
+{
+  clave = (turno == 2) ? CLAVE_TURNO : 0;
+  for (int i = 0; i < filas; i++)
+    for (int j = 0; j < columnas; j++)
+    {
+      int ficha = GetElemento(i, j);
+      if (ficha == 1 || ficha == 2)
+        clave ^= claveFicha(j * filas + filas - 1 - i, ficha);
+    }
+}
+
+/* _________________________________________________________________________ */
+
 void Tablero::SetTablero(vector<vector<int> > tablero, int ult_col, int turno)
 {
-  int filas1, filas2, columnas1, columnas2;
+  int filas1, filas2, columnas1, columnas2, ult_fila = -1;
+
+  // La última ficha es la más alta de la columna ult_col
+  if (ult_col >= 0)
+  {
+    int fila = 0;
+    while (fila < (int) tablero.size() && tablero[fila][ult_col] == 0)
+      fila++;
+    if (fila < (int) tablero.size())
+      ult_fila = fila;
+  }
+
   filas1 = GetFilas();
   filas2 = tablero.size();
   columnas1 = GetColumnas();
@@ -129,7 +396,9 @@ void Tablero::SetTablero(vector<vector<int> > tablero, int ult_col, int turno)
   {
     this->tablero = tablero;
     this->ult_col = ult_col;
+    this->ult_fila = ult_fila;
     this->turno = turno;
+    calcularClave();
   }
 
   else
@@ -137,9 +406,14 @@ void Tablero::SetTablero(vector<vector<int> > tablero, int ult_col, int turno)
     // Si tiene la misma dimensión.
     if (filas1 == filas2 && columnas1 == columnas2)
     {
-      this->tablero = tablero;
+      if (bitboard)
+        cargarBitboard(tablero);
+      else
+        this->tablero = tablero;
       this->ult_col = ult_col;
+      this->ult_fila = ult_fila;
       this->turno = turno;
+      calcularClave();
     }
     else
     {
@@ -155,13 +429,51 @@ Tablero& Tablero::operator=(const Tablero& derecha)
   // Comprobamos que no se está copiando el mismo objeto.
   if (this == &derecha)
     return *this;
+
+  // Las fichas para ganar (y con ellas el detector de líneas) se copian con
+  // el estado, sólo si SetTablero acepta el tablero de la derecha.
+  bool mismo_tam = filas == derecha.filas && columnas == derecha.columnas;
+  if (mismo_tam || filas == 0 || columnas == 0)
+  {
+    fichas_ganar = derecha.fichas_ganar;
+    detector = derecha.detector;
+  }
+
+  // Entre bitboards del mismo tamaño basta con copiar las máscaras.
+  if (bitboard && derecha.bitboard && mismo_tam)
+  {
+    fichas[0] = derecha.fichas[0];
+    fichas[1] = derecha.fichas[1];
+    for (int j = 0; j < columnas; j++)
+      alturas[j] = derecha.alturas[j];
+    ult_col = derecha.ult_col;
+    ult_fila = derecha.ult_fila;
+    clave = derecha.clave;
+    turno = derecha.turno;
+    return *this;
+  }
+
   // Asignamos el tablero de la derecha en la igualdad.
-  SetTablero(derecha.tablero, derecha.ult_col, derecha.turno);
+  SetTablero(derecha.GetTablero(), derecha.ult_col, derecha.turno);
   return *this;
 }
 
 /* _________________________________________________________________________ */
 
+vector<vector<int> > Tablero::GetTablero() const
+{
+  if (!bitboard)
+    return tablero;
+
+  vector<vector<int> > m(filas, vector<int>(columnas, 0));
+  for (int i = 0; i < filas; i++)
+    for (int j = 0; j < columnas; j++)
+      m[i][j] = GetElemento(i, j);
+  return m;
+}
+
+/* _________________________________________________________________________ */
+
 ostream& operator<<(ostream& os, const Tablero& t)
 {
   os << t.GetTablero();
@@ -170,8 +482,32 @@ ostream& operator<<(ostream& os, const Tablero& t)
 
 /* _________________________________________________________________________ */
 
+bool Tablero::hayLineaGenerica(const Tablero& t, uint64_t b)
+{
+  const int filas = t.filas, n = t.fichas_ganar;
+  uint64_t sin_fila_sup = t.lleno & ~(t.fila_inf << (filas - 1));
+  uint64_t sin_fila_inf = t.lleno & ~t.fila_inf;
+  uint64_t sin_ult_col = t.lleno >> filas;
+
+  return hayLineaDireccion(b, 1, sin_fila_sup, n)                             // columnas
+      || hayLineaDireccion(b, filas, sin_ult_col, n)                          // filas
+      || hayLineaDireccion(b, filas - 1, sin_fila_inf & sin_ult_col, n)       // diagonal 1
+      || hayLineaDireccion(b, filas + 1, sin_fila_sup & sin_ult_col, n);      // diagonal 2
+}
+
+/* _________________________________________________________________________ */
+
 int Tablero::quienGana()
 {
+  if (bitboard)
+  {
+    if (hayLineaBB(fichas[0]))
+      return 1;
+    if (hayLineaBB(fichas[1]))
+      return 2;
+    return 0;
+  }
+
   int ganador = 0;
   int count = 0;
   int i, j;
@@ -182,7 +518,7 @@ int Tablero::quienGana()
     {
       // comprobar columnas
       count = 0;
-      for (int k = 0; k < N_FICHAS_GANAR
+      for (int k = 0; k < fichas_ganar
            && i + k < filas; k++)
       {
         if (tablero[i + k][j] != 0)
@@ -205,7 +541,7 @@ int Tablero::quienGana()
             }
           }
 
-          if (count == N_FICHAS_GANAR)
+          if (count == fichas_ganar)
             return ganador;
         }
         else
@@ -216,7 +552,7 @@ int Tablero::quienGana()
 
       // comprobar filas
       count = 0;
-      for (int k = 0; k < N_FICHAS_GANAR
+      for (int k = 0; k < fichas_ganar
            && j + k < columnas; k++)
       {
         if (tablero[i][j + k] != 0)
@@ -239,7 +575,7 @@ int Tablero::quienGana()
             }
           }
 
-          if (count == N_FICHAS_GANAR)
+          if (count == fichas_ganar)
             return ganador;
         }
         else
@@ -250,7 +586,7 @@ int Tablero::quienGana()
 
       // comprobar diagonal 1
       count = 0;
-      for (int k = 0; k < N_FICHAS_GANAR
+      for (int k = 0; k < fichas_ganar
            && i + k < filas
            && j + k < columnas; k++)
       {
@@ -274,7 +610,7 @@ int Tablero::quienGana()
             }
           }
 
-          if (count == N_FICHAS_GANAR)
+          if (count == fichas_ganar)
             return ganador;
         }
         else
@@ -285,7 +621,7 @@ int Tablero::quienGana()
 
       // comprobar diagonal 2
       count = 0;
-      for (int k = 0; k < N_FICHAS_GANAR
+      for (int k = 0; k < fichas_ganar
            && i - k >= 0
            && j + k < columnas; k++)
       {
@@ -309,7 +645,7 @@ int Tablero::quienGana()
             }
           }
 
-          if (count == N_FICHAS_GANAR)
+          if (count == fichas_ganar)
             return ganador;
         }
         else
@@ -324,6 +660,129 @@ int Tablero::quienGana()
 
 /* _________________________________________________________________________ */
 
+int Tablero::quienGanaUltimo() const
+{
+  // Direcciones de las líneas que pasan por la última ficha: columna, fila y
+  // las dos diagonales. Cada una se recorre en los dos sentidos.
+  const int direccion[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+
+  if (ult_col == -1 || ult_fila == -1)
+    return 0;
+
+  int ficha = GetElemento(ult_fila, ult_col);
+
+  // Con bitboards basta con mirar las fichas del último jugador
+  if (bitboard)
+    return hayLineaBB(fichas[ficha - 1]) ? ficha : 0;
+
+  for (int d = 0; d < 4; d++)
+  {
+    int alineadas = 1;
+    for (int sentido = -1; sentido <= 1; sentido += 2)
+    {
+      int di = sentido * direccion[d][0];
+      int dj = sentido * direccion[d][1];
+      int i = ult_fila + di;
+      int j = ult_col + dj;
+      for (int k = 1; k < fichas_ganar && i >= 0 && i < filas && j >= 0
+           && j < columnas && GetElemento(i, j) == ficha; k++)
+      {
+        alineadas++;
+        i += di;
+        j += dj;
+      }
+    }
+    if (alineadas >= fichas_ganar)
+      return ficha;
+  }
+  return 0;
+}
+
+/* _________________________________________________________________________ */
+
+void Tablero::contarVentanas(int ventanas[2][MAX_FICHAS_GANAR + 1]) const
+{
+  for (int j = 0; j < 2; j++)
+    for (int k = 0; k <= MAX_FICHAS_GANAR; k++)
+      ventanas[j][k] = 0;
+
+  if (!bitboard)
+  {
+    const int direccion[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+    const int n = fichas_ganar - 1;
+
+    for (int i = 0; i < filas; i++)
+      for (int j = 0; j < columnas; j++)
+        for (int d = 0; d < 4; d++)
+        {
+          int di = direccion[d][0], dj = direccion[d][1];
+          if (i + n * di >= filas || j + n * dj < 0 || j + n * dj >= columnas)
+            continue;
+
+          int cuenta[3] = {0, 0, 0};
+          for (int k = 0; k < fichas_ganar; k++)
+            cuenta[tablero[i + k * di][j + k * dj]]++;
+
+          if (cuenta[2] == 0)
+            ventanas[0][cuenta[1]]++;
+          if (cuenta[1] == 0)
+            ventanas[1][cuenta[2]]++;
+        }
+    return;
+  }
+
+  // Número de bits necesarios para contar hasta fichas_ganar
+  int planos = 0;
+  while ((1 << planos) <= fichas_ganar)
+    planos++;
+
+  uint64_t sin_fila_sup = lleno & ~(fila_inf << (filas - 1));
+  uint64_t sin_fila_inf = lleno & ~fila_inf;
+  uint64_t sin_ult_col = lleno >> filas;
+  const int desp[4] = {1, filas, filas - 1, filas + 1};
+  const uint64_t validos[4] = {sin_fila_sup, sin_ult_col,
+                               sin_fila_inf & sin_ult_col,
+                               sin_fila_sup & sin_ult_col};
+
+  for (int d = 0; d < 4; d++)
+  {
+    // Casillas en las que empieza una ventana completa en esta dirección
+    uint64_t inicio = lleno;
+    for (int k = 0; k < fichas_ganar - 1; k++)
+      inicio &= desplazar(validos[d], k * desp[d]);
+
+    for (int jug = 0; jug < 2; jug++)
+    {
+      // Sumamos en paralelo las fichas propias de todas las ventanas: el
+      // bit p del plano b es el bit b de la cuenta de la ventana que empieza en p
+      uint64_t plano[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+      uint64_t rival = 0;
+      for (int k = 0; k < fichas_ganar; k++)
+      {
+        uint64_t acarreo = desplazar(fichas[jug], k * desp[d]);
+        for (int b = 0; b < planos && acarreo; b++)
+        {
+          uint64_t t = plano[b] & acarreo;
+          plano[b] ^= acarreo;
+          acarreo = t;
+        }
+        rival |= desplazar(fichas[1 - jug], k * desp[d]);
+      }
+
+      uint64_t abiertas = inicio & ~rival;
+      for (int c = 0; c <= fichas_ganar && abiertas; c++)
+      {
+        uint64_t iguales = abiertas;
+        for (int b = 0; b < planos; b++)
+          iguales &= ((c >> b) & 1) ? plano[b] : ~plano[b];
+        ventanas[jug][c] += __builtin_popcountll(iguales);
+      }
+    }
+  }
+}
+
+/* _________________________________________________________________________ */
+
 template <class T>
 ostream& operator<<(ostream& s, const vector<vector<T> >& c)
 {
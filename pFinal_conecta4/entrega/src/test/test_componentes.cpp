@@ -0,0 +1,1517 @@
+/**
+ * @file test_componentes.cpp
+ * @brief Pruebas automáticas de los componentes del jugador automático
+ *
+ * A diferencia de test_arbol_tablero y test_conecta4, este programa no
+ * necesita a nadie delante: comprueba cada componente contra una versión
+ * sencilla de lo mismo (o contra valores conocidos), escribe los fallos que
+ * encuentre y termina con 1 si ha habido alguno. Se ejecuta con make test.
+ *
+ * Las posiciones al azar salen de un Aleatorio con semilla fija, así que
+ * cada ejecución prueba las mismas.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "aleatorio.h"
+#include "arbol_general.h"
+#include "busqueda.h"
+#include "evaluador.h"
+#include "jugador_auto.h"
+#include "libro_aperturas.h"
+#include "monte_carlo.h"
+#include "partida.h"
+#include "posicion.h"
+#include "resolvedor.h"
+#include "tabla_transposicion.h"
+#include "tablero.h"
+
+using namespace std;
+
+/// Comprobaciones que han fallado
+int fallos = 0;
+
+/**
+ * @brief Anota el resultado de una comprobación.
+ * @param correcto Si se cumple lo que se comprueba
+ * @param que Descripción de la comprobación, que se escribe si falla
+ */
+void Comprobar(bool correcto, const string& que)
+{
+  if (!correcto)
+  {
+    cout << "  FALLO: " << que << endl;
+    fallos++;
+  }
+}
+
+/**
+ * @brief Juega al azar desde un tablero vacío hasta dejar un número de
+ * casillas libres, sin que nadie gane por el camino.
+ * @param t Tablero vacío. Se deja en la posición alcanzada.
+ * @param libres Casillas libres que deben quedar
+ * @param aleatorio Generador de las jugadas
+ * @return false si la partida ha acabado antes (y hay que probar otra).
+ */
+bool JugarAlAzar(Tablero& t, int libres, Aleatorio& aleatorio)
+{
+  while (Resolvedor::casillasLibres(t) > libres)
+  {
+    int col;
+    do
+    {
+      col = aleatorio.entero(t.GetColumnas());
+    } while (t.hayHueco(col) < 0);
+
+    t.colocarFicha(col);
+    t.cambiarTurno();
+    if (t.quienGanaUltimo())
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Indica si dos tableros tienen el mismo estado: casillas, huecos,
+ * turno, última ficha, clave y ganador.
+ */
+bool MismoTablero(Tablero& a, Tablero& b)
+{
+  bool iguales = a.GetFilas() == b.GetFilas() && a.GetColumnas() == b.GetColumnas()
+                 && a.GetFichasGanar() == b.GetFichasGanar()
+                 && a.GetTurno() == b.GetTurno() && a.GetUltCol() == b.GetUltCol()
+                 && a.GetUltFila() == b.GetUltFila() && a.GetClave() == b.GetClave()
+                 && a.estaLleno() == b.estaLleno() && a.quienGana() == b.quienGana()
+                 && a.quienGanaUltimo() == b.quienGanaUltimo();
+  for (int j = -1; iguales && j <= a.GetColumnas(); j++)
+    iguales = a.hayHueco(j) == b.hayHueco(j);
+  for (int i = 0; iguales && i < a.GetFilas(); i++)
+    for (int j = 0; iguales && j < a.GetColumnas(); j++)
+      iguales = a.GetElemento(i, j) == b.GetElemento(i, j);
+  return iguales;
+}
+
+/**
+ * @brief Juega partidas al azar a la vez sobre un Tablero con bitboards (si
+ * el tamaño cabe) y otro con la matriz de enteros, y comprueba que tras cada
+ * jugada tienen el mismo estado, también al copiarlos con operator= de una
+ * representación a la otra. Los tamaños incluyen los que tienen detector
+ * especializado (hayLineaFija), otros que usan el genérico y algunos de más
+ * de 64 casillas, que usan la matriz con ambos.
+ */
+void ProbarTablero()
+{
+  cout << "Tablero con bitboards y con matriz" << endl;
+
+  // filas, columnas, fichas para ganar y si tiene detector especializado
+  const int TAMANOS[][4] = {{6, 7, 4, 1}, {4, 4, 4, 1}, {5, 6, 4, 1}, {6, 6, 4, 1},
+                            {7, 7, 4, 1}, {6, 9, 4, 1}, {7, 9, 4, 1}, {6, 7, 5, 1},
+                            {8, 8, 5, 1}, {3, 3, 3, 1}, {5, 5, 3, 0}, {4, 9, 4, 0},
+                            {6, 7, 3, 0}, {2, 2, 2, 0}, {8, 9, 4, 0}, {10, 10, 5, 0}};
+  const int PARTIDAS = 40;
+  Aleatorio aleatorio(5);
+
+  for (const int *tam : TAMANOS)
+  {
+    string nombre = to_string(tam[0]) + "x" + to_string(tam[1]) + " con "
+                    + to_string(tam[2]) + " fichas";
+    bool cabe = tam[0] * tam[1] <= Tablero::MAX_CASILLAS_BB;
+
+#ifdef TABLERO_BITBOARD
+    Tablero prueba(tam[0], tam[1], tam[2]);
+    Comprobar(prueba.UsaBitboard() == cabe, "representación de " + nombre);
+    Comprobar(prueba.EstaEspecializado() == (tam[3] == 1), "detector de " + nombre);
+#endif
+
+    for (int p = 0; p < PARTIDAS; p++)
+    {
+      Tablero bb(tam[0], tam[1], tam[2]), matriz(tam[0], tam[1], tam[2], false);
+      Comprobar(!matriz.UsaBitboard(), "se fuerza la matriz en " + nombre);
+
+      bool iguales = MismoTablero(bb, matriz);
+      while (iguales && !bb.estaLleno() && bb.quienGana() == 0)
+      {
+        int col;
+        do
+        {
+          col = aleatorio.entero(tam[1]);
+        } while (bb.hayHueco(col) < 0);
+
+        bool puesta_bb = bb.colocarFicha(col), puesta_matriz = matriz.colocarFicha(col);
+        iguales = puesta_bb == puesta_matriz && MismoTablero(bb, matriz);
+        bb.cambiarTurno();
+        matriz.cambiarTurno();
+        iguales = iguales && MismoTablero(bb, matriz);
+
+        // Copias de una representación a la otra, sobre tableros del mismo
+        // tamaño con otro estado
+        Tablero copia_bb(tam[0], tam[1], tam[2]), copia_matriz(tam[0], tam[1], tam[2], false);
+        copia_bb.colocarFicha(0);
+        copia_matriz.colocarFicha(0);
+        copia_bb = matriz;
+        copia_matriz = bb;
+        iguales = iguales && copia_bb.UsaBitboard() == (cabe && bb.UsaBitboard())
+                  && MismoTablero(copia_bb, bb) && MismoTablero(copia_matriz, matriz);
+      }
+      Comprobar(iguales, "partida al azar en " + nombre);
+    }
+  }
+}
+
+/**
+ * @brief Juega una lista de columnas sobre un tablero, cambiando de turno
+ * tras cada una.
+ */
+void Jugar(Tablero& t, const vector<int>& columnas)
+{
+  for (int col : columnas)
+  {
+    t.colocarFicha(col);
+    t.cambiarTurno();
+  }
+}
+
+/**
+ * @brief Resultado de un tablero para el jugador al que le toca mover,
+ * recorriendo todas las partidas posibles (sin podas ni tablas).
+ * @param t Tablero sin ganador y no lleno. Se devuelve en el mismo estado.
+ * @return 1 si gana, 0 si empata y -1 si pierde.
+ */
+int FuerzaBruta(Tablero& t)
+{
+  int mejor = -1;
+  int col_anterior = t.GetUltCol();
+
+  for (int col = 0; col < t.GetColumnas() && mejor < 1; col++)
+  {
+    if (t.hayHueco(col) < 0)
+      continue;
+
+    t.colocarFicha(col);
+    t.cambiarTurno();
+    int valor;
+    if (t.quienGanaUltimo())
+      valor = 1;
+    else if (t.estaLleno())
+      valor = 0;
+    else
+      valor = -FuerzaBruta(t);
+    t.cambiarTurno();
+    t.quitarFicha(col, col_anterior);
+
+    if (valor > mejor)
+      mejor = valor;
+  }
+
+  return mejor;
+}
+
+/**
+ * @brief Compara el Resolvedor con FuerzaBruta en posiciones al azar de
+ * tableros pequeños, y comprueba que la columna que elige consigue su
+ * resultado.
+ */
+void ProbarResolvedor()
+{
+  cout << "Resolvedor" << endl;
+
+  // filas, columnas, fichas para ganar y casillas libres
+  const int TAMANOS[][4] = {{4, 4, 3, 10}, {4, 5, 4, 10}, {5, 4, 3, 10},
+                            {6, 7, 4, 9}, {3, 7, 3, 9}};
+  const int POSICIONES = 25;
+  Aleatorio aleatorio(1);
+  Resolvedor con_tabla(1), sin_tabla(0);
+
+  for (const int *tam : TAMANOS)
+  {
+    int probadas = 0;
+    while (probadas < POSICIONES)
+    {
+      Tablero t(tam[0], tam[1], tam[2]);
+      if (!JugarAlAzar(t, tam[3], aleatorio))
+        continue;
+      probadas++;
+
+      int esperado = FuerzaBruta(t);
+      Resolvedor *resolvedores[2] = {&con_tabla, &sin_tabla};
+      for (Resolvedor *r : resolvedores)
+      {
+        int col = -1;
+        int resultado = r->resolver(t, col);
+        Comprobar(resultado == esperado,
+                  "resultado de " + to_string(tam[0]) + "x" + to_string(tam[1])
+                  + " (" + to_string(resultado) + " en vez de " + to_string(esperado) + ")");
+
+        // La columna elegida debe conseguir ese resultado
+        bool valida = col >= 0 && col < t.GetColumnas() && t.hayHueco(col) >= 0;
+        Comprobar(valida, "columna del resolvedor no válida");
+        if (valida)
+        {
+          Tablero u(t);
+          u.colocarFicha(col);
+          u.cambiarTurno();
+          int valor = u.quienGanaUltimo() ? 1 : u.estaLleno() ? 0 : -FuerzaBruta(u);
+          Comprobar(valor == esperado, "la columna del resolvedor no consigue su resultado");
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Resultado de una jugada para el jugador que la hace, recorriendo
+ * todas las partidas posibles tras ella.
+ * @param t Tablero sin ganador y no lleno
+ * @param col Columna con hueco
+ * @return 1 si gana, 0 si empata y -1 si pierde.
+ */
+int ValorJugada(const Tablero& t, int col)
+{
+  Tablero u(t);
+  u.colocarFicha(col);
+  u.cambiarTurno();
+  return u.quienGanaUltimo() ? 1 : u.estaLleno() ? 0 : -FuerzaBruta(u);
+}
+
+/**
+ * @brief Compara la Busqueda alfa-beta, con profundidad suficiente para
+ * llegar al final de la partida, con FuerzaBruta en posiciones al azar de
+ * tableros pequeños: su valor debe ser el resultado y su columna debe
+ * conseguirlo, con un hilo y con varios (Lazy SMP). Con varios hilos la
+ * columna puede ser otra que consiga lo mismo, pero el valor debe ser el de
+ * un hilo.
+ */
+void ProbarBusqueda()
+{
+  cout << "Busqueda" << endl;
+
+  // filas, columnas, fichas para ganar y casillas libres
+  const int TAMANOS[][4] = {{4, 4, 3, 10}, {4, 5, 4, 10}, {6, 7, 4, 9}, {3, 7, 3, 9}};
+  const int POSICIONES = 15;
+  Aleatorio aleatorio(9);
+
+  for (const int *tam : TAMANOS)
+  {
+    ParametrosBusqueda params;
+    params.memoria_tt = 1;
+    params.profundidad = tam[3];
+    Busqueda busqueda(params);
+    params.hilos = 4;
+    Busqueda lazy_smp(params);
+
+    string nombre = to_string(tam[0]) + "x" + to_string(tam[1]);
+    int probadas = 0;
+    while (probadas < POSICIONES)
+    {
+      Tablero t(tam[0], tam[1], tam[2]);
+      if (!JugarAlAzar(t, tam[3], aleatorio))
+        continue;
+      probadas++;
+
+      int esperado = FuerzaBruta(t);
+      int col = busqueda.mejorMovimiento(t);
+      Comprobar(busqueda.GetValor() == esperado,
+                "valor de la búsqueda en " + nombre + " (" + to_string(busqueda.GetValor())
+                + " en vez de " + to_string(esperado) + ")");
+      bool valida = col >= 0 && col < t.GetColumnas() && t.hayHueco(col) >= 0;
+      Comprobar(valida && ValorJugada(t, col) == esperado,
+                "la columna de la búsqueda consigue su resultado en " + nombre);
+
+      int col_smp = lazy_smp.mejorMovimiento(t);
+      Comprobar(lazy_smp.GetValor() == busqueda.GetValor(),
+                "Lazy SMP da el mismo valor que un hilo en " + nombre);
+      valida = col_smp >= 0 && col_smp < t.GetColumnas() && t.hayHueco(col_smp) >= 0;
+      Comprobar(valida && ValorJugada(t, col_smp) == esperado,
+                "la columna de Lazy SMP consigue su resultado en " + nombre);
+    }
+  }
+}
+
+/**
+ * @brief Indica si una columna es una jugada legal en un tablero.
+ */
+bool Legal(const Tablero& t, int col)
+{
+  return col >= 0 && col < t.GetColumnas() && t.hayHueco(col) >= 0;
+}
+
+/**
+ * @brief Comprueba que la Busqueda devuelve una jugada legal después de
+ * pensar en el turno del rival, tanto si responde lo esperado como si no,
+ * y que acaba llegando a la profundidad pedida (salvo si resuelve antes la
+ * partida).
+ */
+void ProbarPensar()
+{
+  cout << "Busqueda pensando en el turno del rival" << endl;
+
+  ParametrosBusqueda params;
+  params.memoria_tt = 1;
+  params.profundidad = 9;
+  Aleatorio aleatorio(11);
+
+  for (int k = 0; k < 6; k++)
+  {
+    Busqueda busqueda(params);
+    Tablero t(6, 7);
+    if (!JugarAlAzar(t, 34, aleatorio))
+      continue;
+
+    int col = busqueda.mejorMovimiento(t);
+    Comprobar(Legal(t, col), "jugada legal antes de pensar");
+    Jugar(t, {col});
+    int esperada = busqueda.GetRespuestaEsperada();
+    if (t.quienGanaUltimo() || !Legal(t, esperada))
+      continue;
+
+    // Se piensa sobre la respuesta esperada y se para a medias (o no)
+    Tablero previsto(t);
+    Jugar(previsto, {esperada});
+    if (previsto.quienGanaUltimo())
+      continue;
+    busqueda.pensar(previsto);
+    this_thread::sleep_for(chrono::milliseconds(k * 10));
+    if (k % 2 == 0)
+      busqueda.dejarDePensar();
+
+    // Con la respuesta esperada o con otra
+    Tablero real(t);
+    int respuesta = esperada;
+    if (k % 3 == 0)
+      do
+      {
+        respuesta = aleatorio.entero(t.GetColumnas());
+      } while (respuesta == esperada || !Legal(t, respuesta));
+    Jugar(real, {respuesta});
+    if (real.quienGanaUltimo())
+      continue;
+
+    col = busqueda.mejorMovimiento(real);
+    Comprobar(Legal(real, col), "jugada legal tras pensar ("
+                                + string(respuesta == esperada ? "" : "no ")
+                                + "se respondió lo esperado)");
+    Comprobar(busqueda.GetProfundidad() == params.profundidad || fabs(busqueda.GetValor()) == 1,
+              "la búsqueda tras pensar llega a la profundidad pedida (o al final)");
+  }
+}
+
+/**
+ * @brief Acceso a las celdas de una TablaTransposicion para simular lo que
+ * deja un hilo que se queda a medio escribir mientras otro escribe.
+ */
+struct PruebaTablaTransposicion
+{
+  /**
+   * @brief Deja en la celda de una clave lo que quedaría si un hilo hubiera
+   * escrito la clave mezclada con una entrada y otro, después, los datos de
+   * otra entrada.
+   */
+  static void mezclar(TablaTransposicion& tabla, uint64_t clave,
+                      const TablaTransposicion::Entrada& propia,
+                      const TablaTransposicion::Entrada& otra)
+  {
+    TablaTransposicion::Celda& c = tabla.celdas[clave & tabla.mascara];
+    c.clave = clave ^ TablaTransposicion::empaquetar(propia);
+    c.datos = TablaTransposicion::empaquetar(otra);
+  }
+};
+
+/**
+ * @brief Entrada que se guarda para una clave en ProbarTablaCompartida: sus
+ * campos salen de la propia clave, para reconocer si se lee la de otra.
+ */
+TablaTransposicion::Entrada EntradaDeClave(uint64_t clave)
+{
+  TablaTransposicion::Entrada e = {(int32_t)(clave >> 32), (int)((clave >> 16) & 0x7FFF),
+                                   TablaTransposicion::EXACTA, (int)((clave >> 8) & 0x7F)};
+  return e;
+}
+
+/**
+ * @brief Varios hilos guardan y buscan a la vez posiciones que caen en las
+ * mismas dos celdas. Una celda puede quedar a medio escribir (la clave de un
+ * hilo con los datos de otro); la comprobación de la clave XOR los datos
+ * debe rechazarla, así que todo lo que se encuentra debe ser lo guardado
+ * para esa clave.
+ */
+void ProbarTablaCompartida()
+{
+  const int HILOS = 4, OPERACIONES = 200000, CLAVES = 64;
+  TablaTransposicion tabla(1);
+  vector<uint64_t> claves;
+  Aleatorio aleatorio(10);
+
+  for (int i = 0; i < CLAVES; i++)
+    claves.push_back((aleatorio.siguiente() & ~(tabla.size() - 1)) | (i & 1));
+
+  atomic<long> encontradas(0), erroneas(0);
+  vector<thread> hilos;
+  for (int h = 0; h < HILOS; h++)
+    hilos.emplace_back([&, h]() {
+      Aleatorio propio(10, h + 1);
+      for (int k = 0; k < OPERACIONES; k++)
+      {
+        uint64_t clave = claves[propio.entero(CLAVES)];
+        if (k % 2 == 0)
+        {
+          tabla.guardar(clave, EntradaDeClave(clave));
+          continue;
+        }
+
+        TablaTransposicion::Entrada leida, esperada = EntradaDeClave(clave);
+        if (!tabla.buscar(clave, leida))
+          continue;
+        encontradas++;
+        if (leida.valor != esperada.valor || leida.profundidad != esperada.profundidad
+            || leida.cota != esperada.cota || leida.mejor_col != esperada.mejor_col)
+          erroneas++;
+      }
+    });
+  for (thread& h : hilos)
+    h.join();
+
+  Comprobar(encontradas > 0, "los hilos encuentran lo que guardan");
+  Comprobar(erroneas == 0, "no se lee una celda a medio escribir ("
+                           + to_string(erroneas) + " de " + to_string(encontradas) + ")");
+}
+
+/**
+ * @brief Comprueba que la TablaTransposicion devuelve lo guardado, que no
+ * confunde posiciones que caen en la misma celda y que sólo reemplaza una
+ * posición por una búsqueda igual o más profunda.
+ */
+void ProbarTablaTransposicion()
+{
+  cout << "TablaTransposicion" << endl;
+
+  TablaTransposicion vacia(0);
+  TablaTransposicion::Entrada e = {5, 3, TablaTransposicion::EXACTA, 2};
+  vacia.guardar(1234, e);
+  Comprobar(!vacia.buscar(1234, e), "una tabla de 0 MB no guarda nada");
+
+  TablaTransposicion tabla(1);
+  Comprobar(tabla.size() > 0 && (tabla.size() & (tabla.size() - 1)) == 0,
+            "el número de celdas es una potencia de 2");
+
+  // Valores de todo el rango que se empaqueta: negativos, columna -1...
+  const TablaTransposicion::Entrada ENTRADAS[] = {
+    {0, 0, TablaTransposicion::EXACTA, 0},
+    {-1000000, 1, TablaTransposicion::INFERIOR, -1},
+    {1000000, 60, TablaTransposicion::SUPERIOR, 6},
+    {-7, 12, TablaTransposicion::EXACTA, 254}};
+  Aleatorio aleatorio(2);
+  vector<uint64_t> claves;
+
+  for (const TablaTransposicion::Entrada& guardada : ENTRADAS)
+  {
+    uint64_t clave = aleatorio.siguiente();
+    claves.push_back(clave);
+    tabla.guardar(clave, guardada);
+
+    TablaTransposicion::Entrada leida;
+    bool esta = tabla.buscar(clave, leida);
+    Comprobar(esta, "se encuentra lo guardado");
+    Comprobar(esta && leida.valor == guardada.valor
+              && leida.profundidad == guardada.profundidad
+              && leida.cota == guardada.cota && leida.mejor_col == guardada.mejor_col,
+              "se lee lo mismo que se guardó (valor " + to_string(guardada.valor) + ")");
+
+    // Otra clave de la misma celda no debe encontrar esta entrada
+    Comprobar(!tabla.buscar(clave + tabla.size(), leida),
+              "otra posición de la misma celda no se confunde");
+  }
+
+  // Una búsqueda menos profunda no reemplaza a la guardada; una más, sí
+  uint64_t clave = claves[2];
+  TablaTransposicion::Entrada leida, somera = {1, 59, TablaTransposicion::EXACTA, 0};
+  tabla.guardar(clave, somera);
+  Comprobar(tabla.buscar(clave, leida) && leida.profundidad == 60,
+            "una búsqueda menos profunda no reemplaza la entrada");
+
+  TablaTransposicion::Entrada profunda = {2, 61, TablaTransposicion::EXACTA, 3};
+  tabla.guardar(clave, profunda);
+  Comprobar(tabla.buscar(clave, leida) && leida.profundidad == 61 && leida.valor == 2,
+            "una búsqueda más profunda reemplaza la entrada");
+
+  // Una celda con la clave de una escritura y los datos de otra no es de
+  // ninguna de las dos posiciones
+  TablaTransposicion::Entrada otra = {-9, 62, TablaTransposicion::INFERIOR, 1};
+  PruebaTablaTransposicion::mezclar(tabla, clave, profunda, otra);
+  Comprobar(!tabla.buscar(clave, leida) && !tabla.buscar(clave + tabla.size(), leida),
+            "se rechaza una celda a medio escribir");
+  tabla.guardar(clave, profunda);
+  Comprobar(tabla.buscar(clave, leida) && leida.valor == 2,
+            "se puede volver a guardar en una celda a medio escribir");
+
+  tabla.limpiar();
+  bool alguna = false;
+  for (size_t i = 0; i < claves.size(); i++)
+    alguna = alguna || tabla.buscar(claves[i], leida);
+  Comprobar(!alguna, "limpiar vacía la tabla");
+
+  ProbarTablaCompartida();
+}
+
+/**
+ * @brief Escribe un libro de aperturas, lo abre y busca sus posiciones, y
+ * comprueba que no se abren libros de otro tamaño ni ficheros incorrectos.
+ */
+void ProbarLibroAperturas()
+{
+  cout << "LibroAperturas" << endl;
+
+  const string FICHERO = "test_componentes_libro.bin";
+  const string MALO = "test_componentes_malo.bin";
+
+  // Las posiciones tras cada jugada de una partida, con una columna cada una
+  const int JUGADAS[] = {3, 3, 2, 4, 2, 2, 5, 1, 0, 6};
+  vector<Tablero> posiciones;
+  vector<LibroAperturas::Entrada> entradas;
+  Tablero t(6, 7);
+  for (int col : JUGADAS)
+  {
+    LibroAperturas::Entrada e = {t.GetClave(), col, 0};
+    posiciones.push_back(t);
+    entradas.push_back(e);
+    t.colocarFicha(col);
+    t.cambiarTurno();
+  }
+
+  LibroAperturas::Cabecera cabecera = {{0}, 6, 7, 11, 8, 0};
+  Comprobar(LibroAperturas::escribir(FICHERO, cabecera, entradas),
+            "se escribe el libro");
+
+  LibroAperturas libro;
+  Comprobar(!libro.abrir(FICHERO, 7, 6), "no se abre un libro de otro tamaño");
+  Comprobar(!libro.abierto() && libro.buscar(posiciones[0]) == -1,
+            "un libro cerrado no tiene entradas");
+  Comprobar(libro.abrir(FICHERO, 6, 7), "se abre el libro");
+  Comprobar(libro.size() == posiciones.size(), "el libro tiene todas las entradas");
+
+  for (size_t i = 0; i < posiciones.size(); i++)
+    Comprobar(libro.buscar(posiciones[i]) == JUGADAS[i],
+              "columna de la posición " + to_string(i) + " del libro");
+
+  // Una posición que no está, y una cuya columna del libro está llena
+  Tablero fuera(6, 7);
+  fuera.colocarFicha(0);
+  fuera.cambiarTurno();
+  Comprobar(libro.buscar(fuera) == -1, "una posición que no está devuelve -1");
+
+  Tablero llena(6, 7);
+  for (int i = 0; i < 6; i++)
+  {
+    llena.colocarFicha(6);
+    llena.cambiarTurno();
+  }
+  vector<LibroAperturas::Entrada> una(1);
+  una[0].clave = llena.GetClave();
+  una[0].columna = 6;
+  una[0].reservado = 0;
+  Comprobar(LibroAperturas::escribir(FICHERO, cabecera, una) && libro.abrir(FICHERO, 6, 7),
+            "se reescribe el libro");
+  Comprobar(libro.buscar(llena) == -1, "no se devuelve una columna llena");
+  libro.cerrar();
+
+  // Un fichero que no es un libro y un libro cortado
+  {
+    ofstream salida(MALO.c_str(), ios::binary);
+    salida << "esto no es un libro de aperturas, aunque sea largo";
+  }
+  Comprobar(!libro.abrir(MALO, 6, 7) && !libro.abierto(), "no se abre un fichero que no es un libro");
+
+  Comprobar(LibroAperturas::escribir(FICHERO, cabecera, entradas), "se escribe el libro");
+  {
+    ifstream entrada(FICHERO.c_str(), ios::binary);
+    string contenido((istreambuf_iterator<char>(entrada)), istreambuf_iterator<char>());
+    ofstream salida(MALO.c_str(), ios::binary);
+    salida.write(contenido.data(), contenido.size() - 1);
+  }
+  Comprobar(!libro.abrir(MALO, 6, 7), "no se abre un libro cortado");
+  Comprobar(!libro.abrir("no_existe.bin", 6, 7), "no se abre un fichero que no existe");
+
+  remove(FICHERO.c_str());
+  remove(MALO.c_str());
+}
+
+/**
+ * @brief Juega partidas al azar y comprueba tras cada ficha (antes y después
+ * de cambiar el turno) que una Posicion guarda lo mismo que el Tablero del
+ * que sale, que al volver a Tablero se recupera el mismo estado, y que
+ * mismoEstado distingue posiciones con otras fichas o con otro turno.
+ */
+void ProbarPosicion()
+{
+  cout << "Posicion" << endl;
+
+  // filas, columnas y fichas para ganar; hasta 128 casillas
+  const int TAMANOS[][3] = {{6, 7, 4}, {3, 3, 3}, {8, 8, 5}, {10, 12, 5}, {1, 128, 4}};
+  const int PARTIDAS = 20;
+  Aleatorio aleatorio(12);
+
+  for (const int *tam : TAMANOS)
+  {
+    string nombre = to_string(tam[0]) + "x" + to_string(tam[1]);
+    Comprobar(Posicion::cabe(tam[0], tam[1]), "cabe " + nombre);
+    bool iguales = true, distintas = true;
+
+    for (int p = 0; p < PARTIDAS && iguales && distintas; p++)
+    {
+      Tablero t(tam[0], tam[1], tam[2]);
+      Posicion anterior(t);
+      iguales = anterior.estaVacio() && anterior.GetUltCol() == -1;
+
+      while (iguales && distintas && !t.estaLleno() && t.quienGana() == 0)
+      {
+        int col;
+        do
+        {
+          col = aleatorio.entero(tam[1]);
+        } while (t.hayHueco(col) < 0);
+        t.colocarFicha(col);
+
+        for (int cambio = 0; cambio < 2; cambio++)
+        {
+          Posicion pos(t);
+          iguales = iguales && pos.GetFilas() == t.GetFilas()
+                    && pos.GetColumnas() == t.GetColumnas()
+                    && pos.GetFichasGanar() == t.GetFichasGanar()
+                    && pos.GetTurno() == t.GetTurno() && pos.GetUltCol() == t.GetUltCol()
+                    && pos.GetUltFila() == t.GetUltFila()
+                    && pos.quienGanaUltimo() == t.quienGanaUltimo() && !pos.estaVacio();
+          for (int j = -1; iguales && j <= tam[1]; j++)
+            iguales = pos.hayHueco(j) == t.hayHueco(j);
+          for (int i = 0; iguales && i < tam[0]; i++)
+            for (int j = 0; iguales && j < tam[1]; j++)
+              iguales = pos.GetElemento(i, j) == t.GetElemento(i, j);
+
+          Tablero vuelta = pos.aTablero();
+          iguales = iguales && MismoTablero(vuelta, t) && Posicion(vuelta).mismoEstado(pos);
+
+          // Otras fichas u otro turno
+          distintas = distintas && !pos.mismoEstado(anterior) && !anterior.mismoEstado(pos);
+          anterior = pos;
+
+          if (cambio == 0)
+            t.cambiarTurno();
+        }
+      }
+    }
+    Comprobar(iguales, "Posicion y Tablero coinciden en " + nombre);
+    Comprobar(distintas, "mismoEstado distingue fichas y turno en " + nombre);
+  }
+}
+
+/**
+ * @brief Cuenta en cuántas de las 8 direcciones siguen a la última ficha de
+ * una posición n - 1 fichas del mismo jugador, recorriendo las casillas. Es
+ * la referencia para Evaluador::contarAlineadas.
+ */
+int AlineadasRecorriendo(const Posicion& p, int n)
+{
+  const int DIRECCIONES[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1},
+                                 {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+  int fila = p.GetUltFila(), col = p.GetUltCol();
+  int encontradas = 0;
+  for (int d = 0; d < 8; d++)
+  {
+    int alineados = 1;
+    int i = fila + DIRECCIONES[d][0], j = col + DIRECCIONES[d][1];
+    while (alineados < n && i >= 0 && i < p.GetFilas() && j >= 0 && j < p.GetColumnas()
+           && p.GetElemento(i, j) == p.GetElemento(fila, col))
+    {
+      alineados++;
+      i += DIRECCIONES[d][0];
+      j += DIRECCIONES[d][1];
+    }
+    if (alineados == n)
+      encontradas++;
+  }
+  return encontradas;
+}
+
+/**
+ * @brief Compara las implementaciones del Evaluador (las que admita el
+ * procesador) con Tablero::contarVentanas en tableros llenados al azar de
+ * varios tamaños, incluido uno que no cabe en una máscara. Compara también
+ * Evaluador::contarAlineadas con el recorrido de las casillas, tanto en los
+ * tamaños con versión especializada como en los demás.
+ */
+void ProbarEvaluador()
+{
+  cout << "Evaluador" << endl;
+
+  // filas, columnas, fichas para ganar y si hay versión especializada de
+  // contarAlineadas
+  const int TAMANOS[][4] = {{6, 7, 4, 1}, {4, 4, 3, 0}, {8, 8, 5, 1}, {5, 9, 4, 0},
+                            {7, 9, 6, 0}, {1, 8, 3, 0}, {8, 1, 3, 0}, {2, 2, 2, 0},
+                            {10, 10, 4, 0}, {4, 4, 4, 1}, {5, 6, 4, 1}, {6, 6, 4, 1},
+                            {7, 7, 4, 1}, {6, 9, 4, 1}, {7, 9, 4, 1}, {6, 7, 5, 1},
+                            {3, 3, 3, 1}};
+  const int POSICIONES = 200;
+  const Evaluador::Implementacion IMPLEMENTACIONES[] =
+    {Evaluador::ESCALAR, Evaluador::SSE2, Evaluador::AVX2};
+
+  for (Evaluador::Implementacion impl : IMPLEMENTACIONES)
+  {
+    if (Evaluador(6, 7, 4, impl).GetImplementacion() != impl)
+    {
+      cout << "  " << Evaluador::NOMBRE_IMPLEMENTACION[impl]
+           << " no está disponible en este procesador" << endl;
+      continue;
+    }
+
+    Aleatorio aleatorio(3);
+    for (const int *tam : TAMANOS)
+    {
+      Evaluador evaluador(tam[0], tam[1], tam[2], impl);
+      string nombre = string(Evaluador::NOMBRE_IMPLEMENTACION[impl]) + " en "
+                      + to_string(tam[0]) + "x" + to_string(tam[1]) + " con "
+                      + to_string(tam[2]) + " fichas";
+      Comprobar(evaluador.EstaEspecializado() == (tam[3] != 0),
+                "versión especializada de contarAlineadas con " + nombre);
+
+      for (int p = 0; p < POSICIONES; p++)
+      {
+        // Cualquier número de fichas, aunque alguien haya ganado
+        Tablero t(tam[0], tam[1], tam[2]);
+        int fichas = aleatorio.entero(tam[0] * tam[1] + 1);
+        for (int i = 0; i < fichas; i++)
+        {
+          int col;
+          do
+          {
+            col = aleatorio.entero(tam[1]);
+          } while (t.hayHueco(col) < 0);
+          t.colocarFicha(col);
+          t.cambiarTurno();
+        }
+
+        int esperadas[2][Tablero::MAX_FICHAS_GANAR + 1];
+        int contadas[2][Tablero::MAX_FICHAS_GANAR + 1];
+        t.contarVentanas(esperadas);
+
+        evaluador.contar(t, contadas);
+        bool iguales = true;
+        for (int j = 0; j < 2; j++)
+          for (int k = 0; k <= tam[2]; k++)
+            iguales = iguales && contadas[j][k] == esperadas[j][k];
+        Comprobar(iguales, "ventanas del tablero con " + nombre);
+
+        if (Posicion::cabe(tam[0], tam[1]))
+        {
+          evaluador.contar(Posicion(t), contadas);
+          iguales = true;
+          for (int j = 0; j < 2; j++)
+            for (int k = 0; k <= tam[2]; k++)
+              iguales = iguales && contadas[j][k] == esperadas[j][k];
+          Comprobar(iguales, "ventanas de la posición con " + nombre);
+
+          Posicion pos(t);
+          int alineadas1, alineadas2;
+          evaluador.contarAlineadas(pos, alineadas1, alineadas2);
+          if (pos.estaVacio())
+            Comprobar(alineadas1 == -1 && alineadas2 == -1,
+                      "alineaciones de la posición vacía con " + nombre);
+          else
+            Comprobar(alineadas1 == AlineadasRecorriendo(pos, tam[2] - 1)
+                      && alineadas2 == AlineadasRecorriendo(pos, tam[2] - 2),
+                      "alineaciones de la última ficha con " + nombre);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Comprueba que la métrica 1 elige las mismas columnas que antes de
+ * que se contaran las ventanas con el Evaluador: sus puntos y sus atajos
+ * dependen de las alineaciones de la última ficha (ver
+ * Evaluador::contarAlineadas).
+ */
+void ProbarMetrica1()
+{
+  cout << "Métrica 1" << endl;
+
+  // Tableros (4 fichas para ganar, empieza el jugador 1) y la columna que
+  // elegía la métrica 1 en cada uno. En "2 3 6 5 2" tapa la columna 2, que
+  // es la única jugada tras la que el rival no alinea 3 fichas
+  struct Caso
+  {
+    int filas;
+    int columnas;
+    const char *jugadas;
+    int columna;
+  };
+  const Caso CASOS[] = {
+    {6, 7, "6 2", 6},
+    {5, 6, "3 4 3 5 4 3 3", 5},
+    {6, 7, "2 2 0 3", 1},
+    {6, 7, "6 3 2 5 2 6 0 3 3", 4},
+    {7, 8, "0 4 7 7 4 1", 6},
+    {6, 7, "3 5 1 4 2 4 2 3 3 2 6", 0},
+    {6, 7, "4 1 3", 2},
+    {5, 6, "3 5 5 1 0 1 0 5", 0},
+    {7, 8, "6 3 0 5 6 1 0 5 1 3 7 7 5", 3},
+    {6, 7, "2 3 6 5 2", 2},
+    {6, 7, "3 0 6 2 4 4 2 5 2 5", 2},
+    {5, 6, "1 0", 2},
+    {7, 8, "7 5 3 2 0 4 4", 6},
+    {6, 7, "0 2 6 5 3 1 4 3 3 5 2 1", 1},
+    {6, 7, "3 2 0 1", 4},
+    {5, 6, "4 5 1 0 4 4 0 5 1", 5},
+    {7, 8, "2 0 6 6 7 5 0 2 6 2 3 6 1 5", 4},
+    {6, 7, "0 1 3 4 0 4", 0},
+    {6, 7, "0 4 1 4 5 5 5 1 1 4 6", 4},
+    {5, 6, "4 1 1", 2},
+    {7, 8, "5 6 2 1 5 1 2 5", 2},
+    {6, 7, "1 0 6 5 5 4 6 1 3 6 5 0 1", 0}};
+
+  for (const Caso& caso : CASOS)
+  {
+    Tablero t(caso.filas, caso.columnas);
+    istringstream jugadas(caso.jugadas);
+    int col;
+    while (jugadas >> col)
+    {
+      t.colocarFicha(col);
+      t.cambiarTurno();
+    }
+
+    // Con varios hilos el árbol, y la columna, deben ser los mismos
+    for (int hilos : {1, 4})
+    {
+      ParametrosBusqueda params;
+      params.hilos = hilos;
+      JugadorAuto jugador(t, 1, params);
+      int elegida = jugador.elegirMovimiento();
+      Comprobar(elegida == caso.columna,
+                "métrica 1 con " + to_string(hilos) + " hilos tras " + string(caso.jugadas)
+                + ": " + to_string(elegida) + " en vez de " + to_string(caso.columna));
+    }
+  }
+}
+
+/**
+ * @brief Juega partidas del JugadorAuto con las métricas del árbol contra
+ * jugadas al azar y comprueba, tras construir el árbol y tras cada turno
+ * (que lo amplía al cambiar de raíz), que la frontera son las hojas del
+ * árbol que no terminan la partida. Con varios hilos el árbol se amplía
+ * repartiendo la frontera, así que también se prueba así. Comprueba a la
+ * vez que la puntuación guardada en cada nodo es la de sumar su subárbol
+ * entero: guardarla no cambia lo que elegía calcularPuntuacion, salvo el
+ * redondeo de cada suma.
+ */
+void ProbarFrontera()
+{
+  cout << "Frontera del JugadorAuto" << endl;
+
+  const int TAMANOS[][2] = {{6, 7}, {4, 5}};
+  Aleatorio aleatorio(13);
+
+  for (const int *tam : TAMANOS)
+    for (int metrica : {1, 2, 3})
+      for (int hilos : {1, 4})
+      {
+        string nombre = "métrica " + to_string(metrica) + " en " + to_string(tam[0]) + "x"
+                        + to_string(tam[1]) + " con " + to_string(hilos) + " hilos";
+        ParametrosBusqueda params;
+        params.hilos = hilos;
+        params.casillas_final = 0;
+        params.semilla = 13;
+
+        Tablero t(tam[0], tam[1]);
+        JugadorAuto jugador(t, metrica, params);
+        Comprobar(jugador.comprobarFrontera(), "sin árbol, frontera vacía con " + nombre);
+        jugador.construirArbol();
+        bool correcta = jugador.comprobarFrontera();
+        bool puntuaciones = jugador.comprobarPuntuaciones();
+
+        // El jugador automático mueve primero
+        while (correcta && !t.estaLleno() && t.quienGana() == 0)
+        {
+          if (t.GetTurno() == 1)
+          {
+            jugador.turnoAutomatico(t);
+            correcta = jugador.comprobarFrontera();
+            puntuaciones = puntuaciones && jugador.comprobarPuntuaciones();
+          }
+          else
+          {
+            int col;
+            do
+            {
+              col = aleatorio.entero(tam[1]);
+            } while (t.hayHueco(col) < 0);
+            Jugar(t, {col});
+          }
+        }
+        Comprobar(correcta, "la frontera son las hojas del árbol con " + nombre);
+        Comprobar(puntuaciones, "puntuaciones guardadas en el árbol con " + nombre);
+      }
+}
+
+/**
+ * @brief Comprueba que las métricas 1 y 2, si se pide el resolvedor de
+ * finales, le dejan elegir la columna cuando quedan menos de casillas_final
+ * casillas libres y la partida no está perdida. Para que la prueba distinga
+ * las dos fuentes, alguna de esas columnas debe ser distinta de la que
+ * elige la métrica con los parámetros por defecto, que no lo usan.
+ */
+void ProbarFinalesMetricas()
+{
+  cout << "Finales de las métricas 1 y 2" << endl;
+
+  const int POSICIONES = 20;
+  ParametrosBusqueda con_resolvedor, por_defecto;
+  con_resolvedor.casillas_final = 14;
+  const int LIBRES = con_resolvedor.casillas_final - 2;
+
+  for (int metrica = 1; metrica <= 2; metrica++)
+  {
+    Aleatorio aleatorio(metrica);
+    int probadas = 0, distintas = 0;
+    while (probadas < POSICIONES)
+    {
+      Tablero t(6, 7);
+      if (!JugarAlAzar(t, LIBRES, aleatorio))
+        continue;
+
+      Resolvedor resolvedor;
+      int esperada = -1;
+      if (resolvedor.resolver(t, esperada) == Resolvedor::PIERDE)
+        continue;
+      probadas++;
+
+      JugadorAuto jugador(t, metrica, con_resolvedor);
+      int elegida = jugador.elegirMovimiento();
+      Comprobar(elegida == esperada,
+                "la métrica " + to_string(metrica) + " no juega la columna del resolvedor ("
+                + to_string(elegida) + " en vez de " + to_string(esperada) + ")");
+
+      JugadorAuto sin_final(t, metrica, por_defecto);
+      if (sin_final.elegirMovimiento() != esperada)
+        distintas++;
+    }
+    Comprobar(distintas > 0, "la métrica " + to_string(metrica)
+                             + " elige siempre lo mismo que el resolvedor");
+  }
+}
+
+/**
+ * @brief Indica si dos partidas son iguales: mismo tablero, mismo jugador
+ * que empieza y mismas jugadas.
+ */
+bool MismaPartida(const Partida& a, const Partida& b)
+{
+  bool iguales = a.GetFilas() == b.GetFilas() && a.GetColumnas() == b.GetColumnas()
+                 && a.GetFichasGanar() == b.GetFichasGanar()
+                 && a.GetPrimero() == b.GetPrimero() && a.size() == b.size();
+  for (size_t i = 0; iguales && i < a.size(); i++)
+    iguales = a[i] == b[i];
+  return iguales;
+}
+
+/**
+ * @brief Comprueba que una Partida se escribe y se vuelve a leer igual, que
+ * se leen los ficheros de partidas (con comentarios, partidas cortadas y sin
+ * fin de línea al final) y que se rechazan las líneas incorrectas.
+ */
+void ProbarPartida()
+{
+  cout << "Partida" << endl;
+
+  // Una partida que empieza el jugador 2 y gana con 5 en línea
+  Tablero inicial(7, 8, 5);
+  inicial.cambiarTurno();
+  Partida partida(inicial);
+  const int JUGADAS[] = {0, 1, 0, 1, 0, 1, 0, 1, 0};
+  for (int col : JUGADAS)
+    partida.anotar(col);
+
+  ostringstream os;
+  os << partida;
+  Comprobar(os.str() == "7 8 5 2 : 0 1 0 1 0 1 0 1 0\n", "formato de la partida");
+
+  istringstream is(os.str());
+  Partida leida;
+  Comprobar(is >> leida && MismaPartida(leida, partida), "se lee la partida escrita");
+  Comprobar(leida.GetGanador() == 2, "ganador de la partida leída");
+  Comprobar(leida.tablero(0).GetTurno() == 2 && leida.tablero(0).estaVacio(),
+            "tablero inicial de la partida leída");
+
+  Tablero t(inicial);
+  for (size_t i = 0; i < partida.size(); i++)
+  {
+    t.colocarFicha(partida[i]);
+    t.cambiarTurno();
+  }
+  Comprobar(leida.tablero(leida.size()).GetClave() == t.GetClave(),
+            "tablero final de la partida leída");
+
+  // Un fichero con comentarios, líneas vacías, una partida cortada (como
+  // deja conecta4 -d si se interrumpe) y la última línea sin fin de línea
+  istringstream fichero("# partidas\n\n6 7 4 1 : 3 3 2\r\n  \n4 4 3 2 :\n6 7 4 1 : 3");
+  Partida p1, p2, p3, p4;
+  Comprobar(fichero >> p1 && p1.size() == 3 && p1[2] == 2 && p1.GetGanador() == 0,
+            "se salta los comentarios y las líneas vacías");
+  Comprobar(fichero >> p2 && p2.size() == 0 && p2.GetPrimero() == 2
+            && p2.GetFichasGanar() == 3, "se lee una partida sin jugadas");
+  Comprobar(fichero >> p3 && p3.size() == 1, "se lee la última línea sin fin de línea");
+  Comprobar(!(fichero >> p4) && fichero.eof(), "al final del fichero no hay más partidas");
+
+  // Líneas incorrectas: activan el failbit y no cambian la partida
+  const char *INCORRECTAS[] = {
+    "6 7 4 1 3 3",                    // sin separador
+    "6 7 4 1 ; 3",                    // otro separador
+    "6 7 4 3 : 3",                    // jugador que empieza
+    "0 7 4 1 : 3",                    // sin filas
+    "256 7 4 1 :",                    // más filas que Partida::MAX_LADO
+    "6 7 1 1 :",                      // menos de 2 fichas para ganar
+    "6 7 99 1 :",                     // más que Tablero::MAX_FICHAS_GANAR
+    "6 7 4 1 : 7",                    // columna fuera del tablero
+    "6 7 4 1 : -1",                   // columna negativa
+    "4 4 3 1 : 0 0 0 0 0",            // columna llena
+    "6 7 4 1 : 0 1 0 1 0 1 0 1",      // jugada después de ganar
+    "6 7 4 1 : 3 x",                  // algo que no es una columna
+    "6 7 4"                           // línea cortada
+  };
+  for (const char *linea : INCORRECTAS)
+  {
+    istringstream entrada(string(linea) + "\n6 7 4 1 : 5\n");
+    Partida p(partida);
+    Comprobar(!(entrada >> p) && MismaPartida(p, partida),
+              "se rechaza \"" + string(linea) + "\"");
+
+    // La línea incorrecta se ha consumido: se puede seguir leyendo
+    entrada.clear();
+    Comprobar(entrada >> p && p.size() == 1 && p[0] == 5,
+              "se sigue leyendo después de \"" + string(linea) + "\"");
+  }
+}
+
+/**
+ * @brief Etiqueta que cuenta cuántas hay construidas, para comprobar que la
+ * reserva de ArbolGeneral destruye cada una exactamente una vez.
+ */
+struct Contada
+{
+  static atomic<int> vivas;
+  int valor;
+
+  Contada(int v = 0) : valor(v) { vivas++; }
+  Contada(const Contada& c) : valor(c.valor) { vivas++; }
+  ~Contada() { vivas--; }
+};
+
+atomic<int> Contada::vivas(0);
+
+/**
+ * @brief Crea un árbol con una raíz y @e n hijos con etiquetas 1, ..., n.
+ */
+ArbolGeneral<Contada> ArbolContado(int n)
+{
+  ArbolGeneral<Contada> a(Contada(0));
+  for (int i = n; i >= 1; i--)
+    a.insertar_hijomasizquierda(a.raiz(), ArbolGeneral<Contada>(Contada(i)));
+  return a;
+}
+
+/**
+ * @brief Suma las etiquetas de los hijos de la raíz de un árbol.
+ */
+long SumaHijos(const ArbolGeneral<Contada>& a)
+{
+  long suma = 0;
+  for (ArbolGeneral<Contada>::Nodo n = a.hijomasizquierda(a.raiz());
+       n; n = a.hermanoderecha(n))
+    suma += a.etiqueta(n).valor;
+  return suma;
+}
+
+/**
+ * @brief Comprueba que un árbol puede crearse en un hilo y destruirse en
+ * otro: sus nodos siguen siendo válidos aunque termine el hilo que los creó
+ * y sus etiquetas se destruyen una sola vez.
+ */
+void ProbarReservaHilos()
+{
+  cout << "Reserva de ArbolGeneral entre hilos" << endl;
+
+  // Más nodos de los que caben en un bloque de la reserva
+  const int N = 3000;
+  const long SUMA = (long) N * (N + 1) / 2;
+
+  // Creado en un hilo que termina antes de usar el árbol
+  ArbolGeneral<Contada> a;
+  thread([&]() { a = ArbolContado(N); }).join();
+  Comprobar(a.size() == N + 1 && SumaHijos(a) == SUMA,
+            "el árbol sigue entero después de terminar el hilo que lo creó");
+
+  // Destruido en otro hilo: al terminar, devuelve los nodos a la reserva
+  // del primero, que ya no tiene ninguno ocupado
+  thread([&]() { a.clear(); }).join();
+  Comprobar(Contada::vivas == 0, "se destruyen las etiquetas de un hilo que ha terminado");
+
+  // Creado en este hilo y destruido en otro, varias veces: los nodos vuelven
+  // a la reserva de este hilo y se pueden usar de nuevo
+  for (int vuelta = 0; vuelta < 3; vuelta++)
+  {
+    ArbolGeneral<Contada> b = ArbolContado(N);
+    int antes = Contada::vivas;
+    thread([&]() { b.clear(); }).join();
+    Comprobar(b.size() == 0 && Contada::vivas == antes - (N + 1),
+              "se destruyen en otro hilo las etiquetas de este");
+
+    ArbolGeneral<Contada> c = ArbolContado(N);
+    Comprobar(SumaHijos(c) == SUMA, "se crean nodos después de que otro hilo los devuelva");
+  }
+}
+
+/**
+ * @brief Crea un árbol con una raíz (etiqueta 0), @e n hijos con etiquetas
+ * 10, 20, ..., 10n y, bajo el hijo 10i, @e m hijos con etiquetas 10i + 1,
+ * ..., 10i + m.
+ */
+ArbolGeneral<Contada> ArbolDosNiveles(int n, int m)
+{
+  ArbolGeneral<Contada> a(Contada(0));
+  for (int i = n; i >= 1; i--)
+  {
+    ArbolGeneral<Contada> rama(Contada(10 * i));
+    for (int k = m; k >= 1; k--)
+      rama.insertar_hijomasizquierda(rama.raiz(), ArbolGeneral<Contada>(Contada(10 * i + k)));
+    a.insertar_hijomasizquierda(a.raiz(), std::move(rama));
+  }
+  return a;
+}
+
+/**
+ * @brief Indica si los hijos de un nodo tienen las etiquetas dadas, en
+ * orden, y a ese nodo como padre.
+ */
+bool HijosSon(const ArbolGeneral<Contada>& a, ArbolGeneral<Contada>::Nodo n,
+              const vector<int>& etiquetas)
+{
+  size_t i = 0;
+  for (ArbolGeneral<Contada>::Nodo h = a.hijomasizquierda(n); h; h = a.hermanoderecha(h), i++)
+    if (i == etiquetas.size() || a.etiqueta(h).valor != etiquetas[i] || a.padre(h) != n)
+      return false;
+  return i == etiquetas.size();
+}
+
+/**
+ * @brief Comprueba el constructor y la asignación con movimiento y el
+ * trasplante de subárboles de ArbolGeneral: los árboles movidos quedan
+ * vacíos, no se copia ninguna etiqueta, el árbol del que sale una rama
+ * queda con el resto de nodos bien enlazados y cada etiqueta se destruye
+ * una sola vez.
+ */
+void ProbarMoverArbol()
+{
+  cout << "Mover y trasplantar en ArbolGeneral" << endl;
+
+  const int N = 5, M = 3, TOTAL = 1 + N * (1 + M);
+  int antes = Contada::vivas;
+
+  // En un hilo aparte: al terminar recoge sus nodos y destruye las
+  // etiquetas pendientes, así que se pueden contar
+  thread([&]() {
+    ArbolGeneral<Contada> a = ArbolDosNiveles(N, M);
+    int creadas = Contada::vivas;
+
+    ArbolGeneral<Contada> b(std::move(a));
+    Comprobar(a.empty() && a.size() == 0 && b.size() == TOTAL && Contada::vivas == creadas,
+              "el árbol construido con movimiento se lleva los nodos sin copiarlos");
+
+    ArbolGeneral<Contada> c = ArbolContado(2);
+    c = std::move(b);
+    Comprobar(b.empty() && c.size() == TOTAL && HijosSon(c, c.raiz(), {10, 20, 30, 40, 50}),
+              "la asignación con movimiento se lleva los nodos");
+    c = std::move(c);
+    Comprobar(c.size() == TOTAL, "moverse a sí mismo no cambia el árbol");
+    a.clear();
+    b.clear();
+
+    // Trasplante de un hijo del medio, del primero y del último
+    const int HIJOS[] = {30, 10, 50};
+    vector<int> quedan = {10, 20, 30, 40, 50};
+    int tam = TOTAL;
+    bool sin_copias = true;
+    for (int etiqueta : HIJOS)
+    {
+      ArbolGeneral<Contada>::Nodo n = c.hijomasizquierda(c.raiz());
+      while (c.etiqueta(n).valor != etiqueta)
+        n = c.hermanoderecha(n);
+
+      ArbolGeneral<Contada> rama = ArbolContado(1);
+      int vivas = Contada::vivas;
+      rama.asignar_subarbol(std::move(c), n);
+      sin_copias = sin_copias && Contada::vivas <= vivas;
+      quedan.erase(find(quedan.begin(), quedan.end(), etiqueta));
+      tam -= 1 + M;
+
+      Comprobar(rama.raiz() == n && rama.size() == 1 + M && !rama.padre(rama.raiz())
+                && !rama.hermanoderecha(rama.raiz())
+                && HijosSon(rama, rama.raiz(), {etiqueta + 1, etiqueta + 2, etiqueta + 3}),
+                "el subárbol " + to_string(etiqueta) + " pasa entero y suelto");
+      Comprobar(c.size() == tam && HijosSon(c, c.raiz(), quedan),
+                "el árbol del que sale el subárbol " + to_string(etiqueta) + " queda enlazado");
+    }
+    Comprobar(sin_copias, "trasplantar no copia etiquetas");
+
+    // Un hijo como nuevo árbol; el resto se elimina
+    ArbolGeneral<Contada>::Nodo n = c.hermanoderecha(c.hijomasizquierda(c.raiz()));
+    c.asignar_subarbol(n);
+    Comprobar(c.raiz() == n && c.size() == 1 + M && !c.padre(n) && !c.hermanoderecha(n)
+              && HijosSon(c, n, {41, 42, 43}), "un hijo pasa a ser el árbol");
+  }).join();
+
+  Comprobar(Contada::vivas == antes, "cada etiqueta se destruye una sola vez ("
+                                     + to_string(Contada::vivas - antes) + " de más)");
+}
+
+/**
+ * @brief Comprueba que Aleatorio repite la secuencia con la misma semilla y
+ * el mismo flujo y la cambia con otro flujo u otra semilla, que entero(n) y
+ * entre() no se salen del rango y que entero(n) reparte por igual, también
+ * con n que no son potencias de 2.
+ */
+void ProbarAleatorio()
+{
+  cout << "Aleatorio" << endl;
+
+  const int N = 1000;
+  Aleatorio a(42, 3), b(42, 3), otro_flujo(42, 4), otra_semilla(43, 3);
+  int iguales = 0, iguales_flujo = 0, iguales_semilla = 0;
+  for (int k = 0; k < N; k++)
+  {
+    uint64_t x = a.siguiente();
+    iguales += x == b.siguiente();
+    iguales_flujo += x == otro_flujo.siguiente();
+    iguales_semilla += x == otra_semilla.siguiente();
+  }
+  Comprobar(iguales == N, "la misma semilla y el mismo flujo dan la misma secuencia");
+  Comprobar(iguales_flujo == 0, "otro flujo de la semilla da otra secuencia");
+  Comprobar(iguales_semilla == 0, "otra semilla da otra secuencia");
+
+  // Rango y reparto de entero(n) con n = 7: chi cuadrado con 6 grados de
+  // libertad por debajo de 22,46 (probabilidad 0,001 si es uniforme)
+  const int VALORES = 7, TIRADAS = 70000;
+  vector<int> cuenta(VALORES, 0);
+  bool en_rango = true;
+  for (int k = 0; k < TIRADAS; k++)
+  {
+    uint64_t x = a.entero(VALORES);
+    en_rango = en_rango && x < (uint64_t) VALORES;
+    if (x < (uint64_t) VALORES)
+      cuenta[x]++;
+    int y = a.entre(-3, 5);
+    en_rango = en_rango && y >= -3 && y <= 5;
+  }
+  double chi2 = 0, esperado = (double) TIRADAS / VALORES;
+  for (int c : cuenta)
+    chi2 += (c - esperado) * (c - esperado) / esperado;
+  Comprobar(en_rango, "entero(n) y entre() no se salen del rango");
+  Comprobar(chi2 < 22.46, "entero(7) reparte por igual (chi cuadrado " + to_string(chi2) + ")");
+
+  // Con n = 3 * 2^62, un resto (siguiente() % n) daría el primer tercio la
+  // mitad de las veces
+  const uint64_t GRANDE = (uint64_t) 3 << 62;
+  int primer_tercio = 0;
+  en_rango = true;
+  for (int k = 0; k < TIRADAS; k++)
+  {
+    uint64_t x = a.entero(GRANDE);
+    en_rango = en_rango && x < GRANDE;
+    primer_tercio += x < GRANDE / 3;
+  }
+  Comprobar(en_rango, "entero(3 * 2^62) no se sale del rango");
+  Comprobar(fabs((double) primer_tercio / TIRADAS - 1.0 / 3) < 0.01,
+            "entero(3 * 2^62) reparte por igual (primer tercio "
+            + to_string((double) primer_tercio / TIRADAS) + ")");
+}
+
+/**
+ * @brief Juega una partida entre dos JugadorAuto desde un tablero vacío.
+ * @param filas Filas del tablero
+ * @param columnas Columnas del tablero
+ * @param metricas Métricas del jugador 1 y del 2
+ * @param semilla Semilla de los dos jugadores (la del 2 es la siguiente)
+ * @return Columnas jugadas, en orden.
+ */
+vector<int> PartidaAutomatica(int filas, int columnas, const int metricas[2], uint64_t semilla)
+{
+  Tablero t(filas, columnas);
+  ParametrosBusqueda params;
+  params.casillas_final = 0;
+  params.semilla = semilla;
+  JugadorAuto uno(t, metricas[0], params);
+  params.semilla = semilla + 1;
+  JugadorAuto dos(t, metricas[1], params);
+
+  vector<int> jugadas;
+  while (!t.estaLleno() && t.quienGana() == 0)
+  {
+    (t.GetTurno() == 1 ? uno : dos).turnoAutomatico(t);
+    jugadas.push_back(t.GetUltCol());
+  }
+  return jugadas;
+}
+
+/**
+ * @brief Comprueba que las métricas que juegan al azar (3 y 4) repiten sus
+ * partidas con la misma semilla (la de la opción -z de torneo) y juegan
+ * otras con otra semilla.
+ */
+void ProbarSemillaMetricas()
+{
+  cout << "Métricas al azar con semilla" << endl;
+
+  const int METRICAS[][2] = {{3, 4}, {4, 3}, {4, 4}, {3, 3}};
+  for (const int *metricas : METRICAS)
+  {
+    string nombre = to_string(metricas[0]) + " contra " + to_string(metricas[1]);
+    bool repetidas = true, distintas = false;
+    for (uint64_t semilla = 1; semilla <= 9; semilla += 2)
+    {
+      vector<int> partida = PartidaAutomatica(6, 7, metricas, semilla);
+      repetidas = repetidas && partida == PartidaAutomatica(6, 7, metricas, semilla);
+      distintas = distintas || partida != PartidaAutomatica(6, 7, metricas, semilla + 100);
+    }
+    Comprobar(repetidas, "con la misma semilla se repite la partida de " + nombre);
+    Comprobar(distintas, "con otra semilla cambia la partida de " + nombre);
+  }
+}
+
+/**
+ * @brief Comprueba que MonteCarlo gana y tapa las victorias inmediatas, que
+ * repite sus jugadas con una semilla fija, que conserva lo simulado al pasar
+ * a una posición de los dos primeros niveles del árbol (también tras pensar
+ * en el turno del rival) y los límites de cabe().
+ */
+void ProbarMonteCarlo()
+{
+  cout << "MonteCarlo" << endl;
+
+  Comprobar(MonteCarlo::cabe(6, 7) && MonteCarlo::cabe(10, 11) && MonteCarlo::cabe(1, 64),
+            "caben los tableros de hasta 128 casillas con la fila de más");
+  Comprobar(!MonteCarlo::cabe(11, 11) && !MonteCarlo::cabe(10, 12) && !MonteCarlo::cabe(1, 65)
+            && !MonteCarlo::cabe(0, 7) && !MonteCarlo::cabe(6, 0),
+            "no caben los tableros de más casillas ni los vacíos");
+
+  ParametrosBusqueda params;
+  params.memoria_tt = 4;
+  params.simulaciones = 2000;
+  params.semilla = 7;
+
+  // filas y columnas; el último es el tablero más grande que cabe, para
+  // probar los bits más altos
+  const int TAMANOS[][2] = {{6, 7}, {10, 11}};
+  for (const int *tam : TAMANOS)
+  {
+    string nombre = to_string(tam[0]) + "x" + to_string(tam[1]);
+    int ultima = tam[1] - 1, o = tam[1] - 4;
+
+    // Tres en la fila de abajo pegadas a la última columna y tapadas por el
+    // otro lado
+    Tablero gana(tam[0], tam[1]);
+    Jugar(gana, {o, o, o + 1, o + 1, o + 2, o - 1});
+    MonteCarlo mc_gana(gana, params);
+    Comprobar(mc_gana.mejorMovimiento(gana) == ultima, "gana de inmediato en " + nombre);
+    Comprobar(mc_gana.GetValor() == 1, "la victoria inmediata vale 1 en " + nombre);
+
+    // Tres del rival en la última columna
+    Tablero tapa(tam[0], tam[1]);
+    Jugar(tapa, {ultima, 0, ultima, 0, ultima});
+    MonteCarlo mc_tapa(tapa, params);
+    Comprobar(mc_tapa.mejorMovimiento(tapa) == ultima, "tapa la victoria del rival en " + nombre);
+  }
+
+  // Con una semilla fija, un hilo y sin límite de tiempo, dos motores
+  // juegan igual
+  Aleatorio aleatorio(8);
+  bool mismas = true;
+  for (int k = 0; k < 5; k++)
+  {
+    Tablero t(6, 7);
+    if (!JugarAlAzar(t, 30, aleatorio))
+      continue;
+    MonteCarlo a(t, params), b(t, params);
+    int col_a = a.mejorMovimiento(t), col_b = b.mejorMovimiento(t);
+    mismas = mismas && col_a == col_b && a.GetValor() == b.GetValor()
+             && a.GetNodos() == b.GetNodos();
+  }
+  Comprobar(mismas, "con una semilla fija se repite la jugada");
+
+  // Tras la jugada y la respuesta del rival, la raíz conserva las
+  // simulaciones que ya tenía esa posición
+  Tablero t(6, 7);
+  MonteCarlo mc(t, params);
+  int col = mc.mejorMovimiento(t);
+  Comprobar(mc.GetVisitasRaiz() == mc.GetNodos(), "la primera jugada empieza de cero");
+  Jugar(t, {col, mc.GetRespuestaEsperada()});
+  col = mc.mejorMovimiento(t);
+  Comprobar(mc.GetVisitasRaiz() > mc.GetNodos(),
+            "se conservan las simulaciones de la respuesta esperada");
+
+  // Pensando en el turno del rival, sirve cualquier respuesta
+  Jugar(t, {col});
+  mc.pensar(t);
+  this_thread::sleep_for(chrono::milliseconds(50));
+  mc.dejarDePensar();
+  long pensadas = mc.GetNodos();
+  int respuesta = (mc.GetRespuestaEsperada() + 1) % t.GetColumnas();
+  while (t.hayHueco(respuesta) < 0)
+    respuesta = (respuesta + 1) % t.GetColumnas();
+  Jugar(t, {respuesta});
+  mc.mejorMovimiento(t);
+  Comprobar(pensadas > 0 && mc.GetVisitasRaiz() > mc.GetNodos(),
+            "se conservan las simulaciones al pensar, responda lo que responda el rival");
+
+  // Una posición que no cuelga de la raíz empieza un árbol nuevo
+  Tablero otra(6, 7);
+  Jugar(otra, {0, 0, 0});
+  mc.mejorMovimiento(otra);
+  Comprobar(mc.GetVisitasRaiz() == mc.GetNodos(), "otra posición empieza de cero");
+}
+
+int main(int argc, char **argv)
+{
+  ProbarTablero();
+  ProbarResolvedor();
+  ProbarBusqueda();
+  ProbarPensar();
+  ProbarTablaTransposicion();
+  ProbarLibroAperturas();
+  ProbarPosicion();
+  ProbarEvaluador();
+  ProbarMetrica1();
+  ProbarFrontera();
+  ProbarFinalesMetricas();
+  ProbarPartida();
+  ProbarReservaHilos();
+  ProbarMoverArbol();
+  ProbarMonteCarlo();
+  ProbarAleatorio();
+  ProbarSemillaMetricas();
+
+  if (fallos)
+  {
+    cout << fallos << " comprobaciones han fallado." << endl;
+    return 1;
+  }
+  cout << "Todas las comprobaciones son correctas." << endl;
+  return 0;
+}
+
+/* Fin fichero: test_componentes.cpp */
@@ -119,6 +119,8 @@ int main(int argc, char **argv)
   int primerJugador = 1;
   // POSFIX 1: falta filtrado
   // POSFIX 2A: implementar si se quiere IA o sin IA ¿?
+  cout << "Representación del tablero: "
+       << (Tablero(5, 7).UsaBitboard() ? "bitboard" : "matriz") << endl;
   cout << "Bienvenido al Conecta4. Quién empieza primero:\n1.Tú.\n2.IA\n";
   cin >> primerJugador;
 
@@ -0,0 +1,322 @@
+/**
+ * @file torneo.cpp
+ * @brief Enfrenta dos jugadores automáticos en muchas partidas seguidas
+ *
+ * Este programa juega, sin mostrar los tableros, un número dado de partidas
+ * entre dos métricas del jugador automático (los motores A y B), repartidas
+ * entre los núcleos del equipo. Al acabar escribe en formato CSV las
+ * victorias, empates y derrotas del motor A, el tiempo medio por jugada y
+ * los nodos por segundo de cada motor, y la memoria máxima usada.
+ *
+ * Como la mayoría de las métricas son deterministas, cada partida empieza
+ * con unas cuantas jugadas al azar (las mismas para cada pareja de partidas
+ * consecutivas, en las que se cambia quién empieza).
+ *
+ * Las aperturas y los motores que juegan al azar sacan sus números de una
+ * única semilla (opción -z), así que con la misma semilla y sin límite de
+ * tiempo el torneo se repite exactamente, juegue cada partida el hilo que
+ * la juegue.
+ *
+ * Para ver la lista de argumentos que admite, ejecutar el programa
+ * con el modificador -h para ver la ayuda.
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "aleatorio.h"
+#include "grupo_hilos.h"
+#include "jugador_auto.h"
+#include "partida.h"
+
+using namespace std;
+
+/**
+ * @brief Resultado de una partida del torneo.
+ */
+struct ResultadoPartida
+{
+  int ganador;          ///< 1 si gana el motor A, 2 si gana el B, 0 si empatan
+  long jugadas[2];      ///< Jugadas de cada motor
+  double segundos[2];   ///< Tiempo que ha pensado cada motor
+  long nodos[2];        ///< Nodos de cada motor
+  Partida partida;      ///< Jugadas de la partida, con la apertura
+
+  ResultadoPartida() : ganador(0)
+  {
+    for (int m = 0; m < 2; m++)
+    {
+      jugadas[m] = 0;
+      segundos[m] = 0;
+      nodos[m] = 0;
+    }
+  }
+};
+
+/**
+ * @brief Coloca al azar las primeras fichas de una partida.
+ * @param t Tablero vacío de la partida
+ * @param fichas Número de fichas que se colocan
+ * @param generador Generador de las jugadas
+ * @param registro Partida donde se anotan las jugadas
+ */
+void JugarApertura(Tablero& t, int fichas, Aleatorio& generador,
+                   Partida& registro)
+{
+  for (int k = 0; k < fichas && !t.estaLleno() && !t.quienGanaUltimo(); k++)
+  {
+    int col;
+    do
+    {
+      col = generador.entre(0, t.GetColumnas() - 1);
+    } while (t.hayHueco(col) < 0);
+
+    t.colocarFicha(col);
+    t.cambiarTurno();
+    registro.anotar(col);
+  }
+}
+
+/**
+ * @brief Juega una partida entre los dos motores.
+ * @param t Tablero inicial de la partida. Al acabar queda el tablero final.
+ * @param metricas Métrica de cada motor
+ * @param params Parámetros del jugador automático de cada motor
+ * @param turno_a Número de jugador (1 o 2) del motor A
+ * @param registro Partida donde se anotan las jugadas
+ * @return Resultado de la partida, desde el punto de vista del motor A.
+ */
+ResultadoPartida JugarPartida(Tablero& t, const int metricas[2],
+                              const ParametrosBusqueda params[2], int turno_a,
+                              Partida& registro)
+{
+  JugadorAuto a(t, metricas[0], params[0]), b(t, metricas[1], params[1]);
+  JugadorAuto *motores[2] = {&a, &b};
+  ResultadoPartida r;
+  int ganador = t.quienGanaUltimo();
+
+  while (!t.estaLleno() && ganador == 0)
+  {
+    int m = (t.GetTurno() == turno_a) ? 0 : 1;
+
+    chrono::steady_clock::time_point inicio = chrono::steady_clock::now();
+    motores[m]->turnoAutomatico(t);
+    registro.anotar(t.GetUltCol());
+    r.segundos[m] += chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    r.jugadas[m]++;
+
+    ganador = t.quienGanaUltimo();
+  }
+
+  r.nodos[0] = a.GetNodos();
+  r.nodos[1] = b.GetNodos();
+  if (ganador != 0)
+    r.ganador = (ganador == turno_a) ? 1 : 2;
+
+  return r;
+}
+
+int main(int argc, char **argv)
+{
+  int filas = 6, cols = 7, fichas_ganar = Tablero::N_FICHAS_GANAR, partidas = 100, primero = 0, apertura = 2, hilos = 0;
+  int metricas[2] = {1, 5};
+  string nombres[2] = {"1", "5"};
+  string fichero, fichero_partidas;
+  ParametrosBusqueda params;
+  uint64_t semilla = 1;
+  bool opc_ayuda = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (string(argv[i]) == "-f" && i + 1 < argc)
+      filas = stoi(argv[++i]);
+    else if (string(argv[i]) == "-c" && i + 1 < argc)
+      cols = stoi(argv[++i]);
+    else if (string(argv[i]) == "-w" && i + 1 < argc)
+      fichas_ganar = stoi(argv[++i]);
+    else if (string(argv[i]) == "-A" && i + 1 < argc)
+      nombres[0] = argv[++i];
+    else if (string(argv[i]) == "-B" && i + 1 < argc)
+      nombres[1] = argv[++i];
+    else if (string(argv[i]) == "-n" && i + 1 < argc)
+      partidas = stoi(argv[++i]);
+    else if (string(argv[i]) == "-t" && i + 1 < argc)
+      primero = stoi(argv[++i]);
+    else if (string(argv[i]) == "-k" && i + 1 < argc)
+      apertura = stoi(argv[++i]);
+    else if (string(argv[i]) == "-p" && i + 1 < argc)
+      params.profundidad = stoi(argv[++i]);
+    else if (string(argv[i]) == "-u" && i + 1 < argc)
+      params.simulaciones = stoi(argv[++i]);
+    else if (string(argv[i]) == "-l" && i + 1 < argc)
+      params.tiempo_ms = stoi(argv[++i]);
+    else if (string(argv[i]) == "-r" && i + 1 < argc)
+      params.memoria_tt = stoi(argv[++i]);
+    else if (string(argv[i]) == "-b" && i + 1 < argc)
+      params.libro = argv[++i];
+    else if (string(argv[i]) == "-e" && i + 1 < argc)
+      params.casillas_final = stoi(argv[++i]);
+    else if (string(argv[i]) == "-g" && i + 1 < argc)
+      params.estadisticas = argv[++i];
+    else if (string(argv[i]) == "-z" && i + 1 < argc)
+      semilla = stoull(argv[++i]);
+    else if (string(argv[i]) == "-j" && i + 1 < argc)
+      hilos = stoi(argv[++i]);
+    else if (string(argv[i]) == "-o" && i + 1 < argc)
+      fichero = argv[++i];
+    else if (string(argv[i]) == "-d" && i + 1 < argc)
+      fichero_partidas = argv[++i];
+    else
+      opc_ayuda = true;
+  }
+
+  if (opc_ayuda || partidas < 1 || primero < 0 || primero > 2
+      || fichas_ganar < 2 || fichas_ganar > Tablero::MAX_FICHAS_GANAR)
+  {
+    cout << "uso: torneo [-A métrica] [-B métrica] [-f número] [-c número] [-w número]" << endl;
+    cout << "            [-n número] [-t número] [-k número] [-p número] [-l número]" << endl;
+    cout << "            [-r número] [-b fichero] [-e número] [-g fichero] [-j número]" << endl;
+    cout << "            [-u número] [-z número] [-o fichero] [-d fichero]" << endl;
+    cout << "A : métrica del motor A, por número o por nombre (por defecto 1):" << endl;
+    JugadorAuto::mostrarEstrategias(cout, "    ");
+    cout << "B : métrica del motor B (por defecto 5)" << endl;
+    cout << "f : especifica el número de filas (por defecto 6)" << endl;
+    cout << "c : especifica el número de columnas (por defecto 7)" << endl;
+    cout << "w : fichas en línea para ganar (por defecto 4)" << endl;
+    cout << "n : número de partidas (por defecto 100)" << endl;
+    cout << "t : motor que empieza (1 el A, 2 el B, 0 alternando; por defecto 0)" << endl;
+    cout << "k : fichas colocadas al azar al empezar cada partida (por defecto 2)" << endl;
+    cout << "p : profundidad de la búsqueda alfa-beta (métrica 5, por defecto 10)" << endl;
+    cout << "l : tiempo máximo por jugada en ms (métricas 5 y 6, 0 sin límite)" << endl;
+    cout << "u : simulaciones por jugada de la métrica 6 si no hay límite de tiempo" << endl;
+    cout << "    (por defecto 20000)" << endl;
+    cout << "r : memoria (MB) de la tabla de transposición (o del árbol de la métrica 6)" << endl;
+    cout << "    de cada motor" << endl;
+    cout << "b : libro de aperturas para las métricas 1, 2, 5 y 6" << endl;
+    cout << "e : casillas libres a partir de las que se resuelve el final (por defecto 0, nunca)" << endl;
+    cout << "g : añade las estadísticas de cada jugada en JSON a un fichero (sólo si se" << endl;
+    cout << "    ha compilado con make ESTADISTICAS=1)" << endl;
+    cout << "z : semilla de las aperturas y de las métricas 3, 4 y 6 (por defecto 1; 0" << endl;
+    cout << "    para una distinta en cada torneo)" << endl;
+    cout << "j : partidas a la vez (0 para usar todos los núcleos)" << endl;
+    cout << "o : añade el resultado a un fichero CSV (por defecto, en pantalla)" << endl;
+    cout << "d : añade las partidas jugadas, en orden, a un fichero de partidas (ver" << endl;
+    cout << "    analizar)" << endl;
+    return 1;
+  }
+
+  for (int m = 0; m < 2; m++)
+  {
+    JugadorAuto::Estrategia estrategia;
+    if (!JugadorAuto::buscarEstrategia(nombres[m], estrategia))
+    {
+      cout << "Error: no hay ninguna métrica " << nombres[m] << "." << endl;
+      return 1;
+    }
+    metricas[m] = estrategia.numero;
+
+    // Las métricas que usan el árbol guardan los tableros como Posicion, y
+    // la de Monte Carlo los simula en un bitboard
+    if (estrategia.cabe && !estrategia.cabe(filas, cols))
+    {
+      cout << "Error: la métrica " << metricas[m] << " no admite tableros de "
+           << filas << "x" << cols << "." << endl;
+      return 1;
+    }
+  }
+
+  // Cada partida se juega en un solo hilo: el paralelismo está en jugar
+  // varias a la vez
+  params.hilos = 1;
+  vector<ResultadoPartida> resultados(partidas);
+  GrupoHilos grupo(hilos);
+  if (semilla == 0)
+    semilla = Aleatorio::semillaAleatoria();
+
+  grupo.ejecutar(partidas, [&](int p) {
+    // Las partidas 2k y 2k+1 empiezan igual (flujo k de la semilla) y
+    // cambian quién sale
+    int turno_a = (primero == 0) ? 1 + p % 2 : primero;
+    Tablero tablero(filas, cols, fichas_ganar);
+    Aleatorio generador(semilla, p / 2);
+    Partida registro(tablero);
+    JugarApertura(tablero, apertura, generador, registro);
+
+    // Los motores de cada partida usan el flujo partidas + p
+    ParametrosBusqueda params_motores[2] = {params, params};
+    Aleatorio semillas(semilla, partidas + p);
+    for (int m = 0; m < 2; m++)
+      params_motores[m].semilla = semillas.siguiente() | 1;
+
+    // El motor que empieza es el que mueve después de la apertura
+    if (tablero.GetTurno() != 1)
+      turno_a = 3 - turno_a;
+    resultados[p] = JugarPartida(tablero, metricas, params_motores, turno_a, registro);
+    resultados[p].partida = registro;
+  });
+
+  // Totales del torneo
+  long victorias[3] = {0, 0, 0};
+  long jugadas[2] = {0, 0}, nodos[2] = {0, 0};
+  double segundos[2] = {0, 0};
+
+  for (int p = 0; p < partidas; p++)
+  {
+    victorias[resultados[p].ganador]++;
+    for (int m = 0; m < 2; m++)
+    {
+      jugadas[m] += resultados[p].jugadas[m];
+      segundos[m] += resultados[p].segundos[m];
+      nodos[m] += resultados[p].nodos[m];
+    }
+  }
+
+  struct rusage uso;
+  getrusage(RUSAGE_SELF, &uso);
+
+  if (!fichero_partidas.empty())
+  {
+    ofstream partidas_jugadas(fichero_partidas.c_str(), ios::app);
+    for (int p = 0; p < partidas && partidas_jugadas; p++)
+      partidas_jugadas << resultados[p].partida;
+    if (!partidas_jugadas)
+    {
+      cout << "Error: no se ha podido escribir en " << fichero_partidas << endl;
+      return 1;
+    }
+  }
+
+  // Salida en CSV; la cabecera sólo se escribe si el fichero es nuevo
+  ofstream salida;
+  bool cabecera = true;
+  if (!fichero.empty())
+  {
+    cabecera = !ifstream(fichero.c_str()).good();
+    salida.open(fichero.c_str(), ios::app);
+    if (!salida)
+    {
+      cout << "Error: no se ha podido abrir " << fichero << endl;
+      return 1;
+    }
+  }
+  ostream& os = fichero.empty() ? cout : salida;
+
+  if (cabecera)
+    os << "metrica_a,metrica_b,filas,columnas,partidas,victorias_a,empates,victorias_b,"
+       << "ms_jugada_a,ms_jugada_b,nodos_s_a,nodos_s_b,rss_max_kb" << endl;
+
+  os << metricas[0] << ',' << metricas[1] << ',' << filas << ',' << cols << ','
+     << partidas << ',' << victorias[1] << ',' << victorias[0] << ',' << victorias[2];
+  for (int m = 0; m < 2; m++)
+    os << ',' << (jugadas[m] ? 1000 * segundos[m] / jugadas[m] : 0);
+  for (int m = 0; m < 2; m++)
+    os << ',' << (long) (segundos[m] > 0 ? nodos[m] / segundos[m] : 0);
+  os << ',' << uso.ru_maxrss << endl;
+
+  return 0;
+}
+
+/* Fin fichero: torneo.cpp */